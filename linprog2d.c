@@ -16,6 +16,14 @@
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+/* Metrics and capture use clock_gettime() to measure the duration of each
+   solve; capture locks the file with flockfile(), metrics recycle the
+   counters of exited threads through a thread-specific key */
+#if (defined(LINPROG2D_METRICS) || defined(LINPROG2D_CAPTURE)) && \
+    !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199506L
+#endif
+
 #include "linprog2d.h"
 
 #include <math.h>
@@ -24,6 +32,25 @@
 #include <stdlib.h>
 #endif
 
+#ifdef LINPROG2D_CAPTURE
+#include <stdio.h>
+#include <time.h>
+#endif
+
+#ifdef LINPROG2D_USDT
+#include <sys/sdt.h>
+#endif
+
+#ifdef LINPROG2D_METRICS
+#ifdef LINPROG2D_NO_ALLOC
+#error "LINPROG2D_METRICS allocates per-thread counters and requires malloc"
+#endif
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#endif
+
 /******************************************************************************
  * PRIVATE HELPER FUNCTIONS                                                   *
  ******************************************************************************/
@@ -134,6 +161,29 @@ static void *mem_align64(void *p, unsigned long int offs) {
 	return (void *)(((unsigned long int)p + offs + 63UL) & (~63UL));
 }
 
+/******************************************************************************
+ * Static tracepoints                                                         *
+ ******************************************************************************/
+
+/**
+ * USDT probes in the "linprog2d" provider, enabled by compiling with the
+ * LINPROG2D_USDT flag. Each probe compiles to a single nop instruction plus a
+ * note describing where its arguments are found, so probes that are not
+ * attached cost next to nothing. Without the flag the probes expand to
+ * nothing.
+ */
+#ifdef LINPROG2D_USDT
+#define LP2D_PROBE3(name, a, b, c) DTRACE_PROBE3(linprog2d, name, a, b, c)
+#define LP2D_PROBE5(name, a, b, c, d, e) \
+	DTRACE_PROBE5(linprog2d, name, a, b, c, d, e)
+#define LP2D_PROBE6(name, a, b, c, d, e, f) \
+	DTRACE_PROBE6(linprog2d, name, a, b, c, d, e, f)
+#else
+#define LP2D_PROBE3(name, a, b, c)
+#define LP2D_PROBE5(name, a, b, c, d, e)
+#define LP2D_PROBE6(name, a, b, c, d, e, f)
+#endif
+
 /******************************************************************************
  * Result datastructure helper functions                                      *
  ******************************************************************************/
@@ -343,6 +393,45 @@ static double median(double *d, unsigned int len) {
 
 #undef SWAP
 
+/******************************************************************************
+ * Index sorting                                                              *
+ ******************************************************************************/
+
+/**
+ * Moves the index at position i down the max-heap stored in idcs until the
+ * heap property is restored. Used internally by sort_indices().
+ */
+static void sift_down(unsigned int *idcs, unsigned int i, unsigned int len,
+                      const double *key) {
+	unsigned int j, tmp;
+	while ((j = 2U * i + 1U) < len) {
+		if (j + 1U < len && key[idcs[j + 1U]] > key[idcs[j]]) {
+			j++; /* Pick the larger child */
+		}
+		if (key[idcs[i]] >= key[idcs[j]]) {
+			break;
+		}
+		tmp = idcs[i], idcs[i] = idcs[j], idcs[j] = tmp;
+		i = j;
+	}
+}
+
+/**
+ * Sorts the list of indices idcs such that key[idcs[i]] is ascending. Uses
+ * heap sort, which runs in O(n log n), is in-place and does not recurse.
+ */
+static void sort_indices(unsigned int *idcs, unsigned int len,
+                         const double *key) {
+	unsigned int i, tmp;
+	for (i = len / 2U; i > 0U; i--) {
+		sift_down(idcs, i - 1U, len, key);
+	}
+	for (i = len; i > 1U; i--) {
+		tmp = idcs[0], idcs[0] = idcs[i - 1U], idcs[i - 1U] = tmp;
+		sift_down(idcs, 0U, i - 1U, key);
+	}
+}
+
 /******************************************************************************
  * Actual implementation of the 2D linprog algorithm                          *
  ******************************************************************************/
@@ -429,6 +518,35 @@ struct linprog2d_data {
 	 * Number of constraints in the current problem.
 	 */
 	unsigned int n;
+
+	/**
+	 * Number of duplicate constraints removed by linprog2d_presolve() in the
+	 * current problem.
+	 */
+	unsigned int n_removed;
+
+	/**
+	 * True if linprog2d_presolve() should be run before the prune loop.
+	 */
+	bool_t presolve;
+
+	/**
+	 * Median computed in the last iteration of the prune loop and whether the
+	 * optimum was found to the left of it. Only valid if has_median is set.
+	 */
+	double mx;
+	bool_t has_median, optimum_is_left;
+
+	/**
+	 * Number of iterations of the prune loop in the current problem.
+	 */
+	unsigned int n_iter;
+
+	/**
+	 * Observer called after each iteration of the prune loop, or null.
+	 */
+	linprog2d_observer_t observer;
+	void *observer_data;
 };
 
 typedef struct linprog2d_data linprog2d_data_t;
@@ -448,6 +566,11 @@ static void linprog2d_reset(linprog2d_data_t *prog, unsigned int n) {
 	prog->R = mat22_create(0.0, 0.0, 0.0, 0.0);
 	prog->o = vec2_create(0.0, 0.0);
 	prog->n = n;
+	prog->n_removed = 0U;
+	prog->mx = 0.0;
+	prog->has_median = FALSE;
+	prog->optimum_is_left = FALSE;
+	prog->n_iter = 0U;
 }
 
 static linprog2d_t *linprog2d_init_internal(linprog2d_data_t *prog,
@@ -471,6 +594,9 @@ static linprog2d_t *linprog2d_init_internal(linprog2d_data_t *prog,
 	prog->floor = (unsigned int *)mem_align64(prog->ceil, SU * capacity);
 	prog->tmp = (unsigned int *)mem_align64(prog->floor, SU * capacity);
 	prog->capacity = capacity;
+	prog->observer = NULL;
+	prog->observer_data = NULL;
+	prog->presolve = FALSE;
 
 	/* Reset all other fields to their initial values */
 	linprog2d_reset(prog, 0U);
@@ -581,6 +707,121 @@ static int linprog2d_condition_problem(linprog2d_data_t *prog, double cx,
 	return TRUE; /* Success */
 }
 
+/* Index marking the end of a hash chain in linprog2d_presolve() */
+#define PRESOLVE_NIL 0xFFFFFFFFU
+
+/* Absolute tolerance below which two normalized directions are merged */
+#define PRESOLVE_EPS 1e-12
+
+/* Inverse width of the grid cells directions are hashed by; must be at most
+   1 / PRESOLVE_EPS so that merged directions are in the same or in adjacent
+   cells */
+#define PRESOLVE_SCALE 1073741824.0 /* 2^30 */
+
+/**
+ * Hashes the grid cell (qx, qy) of a normalized constraint direction.
+ */
+static unsigned long int linprog2d_direction_hash(unsigned long int qx,
+                                                  unsigned long int qy) {
+	return ((qx * 2654435761UL) ^ qy) & 0xFFFFFFFFUL;
+}
+
+/**
+ * Searches the hash chain of the grid cell (qx, qy) for a direction within
+ * PRESOLVE_EPS of (Gx, Gy). Returns its index or PRESOLVE_NIL.
+ */
+static unsigned int linprog2d_presolve_find(const linprog2d_data_t *prog,
+                                            unsigned int mask,
+                                            unsigned long int qx,
+                                            unsigned long int qy, double Gx,
+                                            double Gy) {
+	const unsigned int *heads = prog->ceil, *next = prog->floor;
+	unsigned int j = heads[linprog2d_direction_hash(qx, qy) & mask];
+	for (; j != PRESOLVE_NIL; j = next[j]) {
+		if (fabs(prog->Gx[j] - Gx) < PRESOLVE_EPS &&
+		    fabs(prog->Gy[j] - Gy) < PRESOLVE_EPS) {
+			break;
+		}
+	}
+	return j;
+}
+
+/**
+ * Removes constraints with the same direction as an earlier constraint, keeping
+ * only the tightest one. Must be called after linprog2d_condition_problem(),
+ * which normalizes the directions such that parallel constraints have equal
+ * coefficients. Uses a chained hash table with at most n buckets stored in the
+ * (at this point unused) ceil and floor lists, so the expected runtime is
+ * linear. Directions are hashed by the grid cell they fall into. A direction
+ * closer than PRESOLVE_EPS to the border of its cell is also looked up in the
+ * neighbouring cells, so every pair of directions within the tolerance is
+ * found.
+ * Returns the number of removed constraints.
+ *
+ * Directions are compared with an absolute tolerance, since rounding errors in
+ * the rotation are relative to the larger coefficient. The tolerance is kept
+ * small; merging nearly parallel constraints with a coarser tolerance would
+ * noticeably move the boundary of the feasible region far away from the
+ * origin.
+ */
+static unsigned int linprog2d_presolve(linprog2d_data_t *prog) {
+	unsigned int *heads = prog->ceil, *next = prog->floor;
+	double *Gx = prog->Gx, *Gy = prog->Gy, *h = prog->h;
+	const unsigned int n = prog->n;
+	const double border = PRESOLVE_EPS * PRESOLVE_SCALE;
+	unsigned int i, j, b, mask = 1U, i_tar = 0U;
+	unsigned long int qx, qy, nx, ny;
+	double fx, fy;
+	if (n == 0U) {
+		return 0U;
+	}
+
+	/* Use the largest power of two not larger than n as number of buckets */
+	while (mask <= n / 2U) {
+		mask *= 2U;
+	}
+	mask--;
+	for (b = 0U; b <= mask; b++) {
+		heads[b] = PRESOLVE_NIL;
+	}
+	for (i = 0U; i < n; i++) {
+		/* Compute the grid cell and the neighbouring cell closest to the
+		   direction in each coordinate; the offset keeps fx, fy positive */
+		fx = (Gx[i] + 2.0) * PRESOLVE_SCALE;
+		fy = (Gy[i] + 2.0) * PRESOLVE_SCALE;
+		qx = (unsigned long int)fx, qy = (unsigned long int)fy;
+		fx -= (double)qx, fy -= (double)qy;
+		nx = (fx < border) ? qx - 1UL : ((fx > 1.0 - border) ? qx + 1UL : qx);
+		ny = (fy < border) ? qy - 1UL : ((fy > 1.0 - border) ? qy + 1UL : qy);
+
+		/* Search for a constraint with the same direction in these cells */
+		j = linprog2d_presolve_find(prog, mask, qx, qy, Gx[i], Gy[i]);
+		if (j == PRESOLVE_NIL && nx != qx) {
+			j = linprog2d_presolve_find(prog, mask, nx, qy, Gx[i], Gy[i]);
+		}
+		if (j == PRESOLVE_NIL && ny != qy) {
+			j = linprog2d_presolve_find(prog, mask, qx, ny, Gx[i], Gy[i]);
+		}
+		if (j == PRESOLVE_NIL && nx != qx && ny != qy) {
+			j = linprog2d_presolve_find(prog, mask, nx, ny, Gx[i], Gy[i]);
+		}
+		if (j != PRESOLVE_NIL) {
+			h[j] = fmax_(h[j], h[i]);
+			continue;
+		}
+
+		/* Compact the constraint list inplace and insert into the bucket */
+		b = (unsigned int)(linprog2d_direction_hash(qx, qy) & mask);
+		Gx[i_tar] = Gx[i], Gy[i_tar] = Gy[i], h[i_tar] = h[i];
+		next[i_tar] = heads[b];
+		heads[b] = i_tar;
+		i_tar++;
+	}
+	prog->n = i_tar;
+	prog->n_removed = n - i_tar;
+	return n - i_tar;
+}
+
 #define CAT_VERT_LEFT 0
 #define CAT_VERT_RIGHT 1
 #define CAT_CEIL 2
@@ -817,39 +1058,31 @@ static struct linprog2d_extremum linprog2d_track_extrema(
 #define LOC_HERE_EDGE 4
 
 /**
- * Determines where the optimum is w.r.t. the given median mx. This function
- * assumes that there is at least one floor constraint.
+ * Determines where the optimum is w.r.t. some x-coordinate, given the extrema
+ * of the ceil and floor constraints at that coordinate. The floor extremum
+ * must be valid.
  */
-static int linprog2d_locate_optimum(linprog2d_data_t *prog, double mx,
-                                    double *y) {
-	/* Compute the value of the ceil/floor constraints at mx and track their
-	   slope. Since multiple constraints may go through exactly the same point,
-	   we need to track both the minimum and the maximum slope for all
-	   constraints that go through the same extreme point. */
-	struct linprog2d_extremum e_ceil, e_floor;
-	e_ceil = linprog2d_track_extrema(mx, prog->dx, prog->y0, prog->ceil,
-	                                 prog->ceil_len, TRUE);
-	e_floor = linprog2d_track_extrema(mx, prog->dx, prog->y0, prog->floor,
-	                                  prog->floor_len, FALSE);
-
-	if (e_ceil.valid && e_ceil.y < e_floor.y) {
+static int linprog2d_locate_optimum_from_extrema(
+    const struct linprog2d_extremum *e_ceil,
+    const struct linprog2d_extremum *e_floor, double *y) {
+	if (e_ceil->valid && e_ceil->y < e_floor->y) {
 		/* mx is outside the feasible region, (implicitly) evaluate
 		   d/dx f(x) - g(x) */
-		if (e_floor.min_dx > e_ceil.max_dx) {
+		if (e_floor->min_dx > e_ceil->max_dx) {
 			return LOC_LEFT;
-		} else if (e_floor.max_dx < e_ceil.min_dx) {
+		} else if (e_floor->max_dx < e_ceil->min_dx) {
 			return LOC_RIGHT;
 		}
 		return LOC_INFEASIBLE;
 	}
 
-	if (feq_(e_floor.min_dx, 0.0) && !feq_(e_floor.max_dx, 0.0)) {
+	if (feq_(e_floor->min_dx, 0.0) && !feq_(e_floor->max_dx, 0.0)) {
 		/* Solution is an edge, but this is the right-most point. */
 		return LOC_LEFT;
-	} else if (feq_(e_floor.max_dx, 0.0) && !feq_(e_floor.min_dx, 0.0)) {
+	} else if (feq_(e_floor->max_dx, 0.0) && !feq_(e_floor->min_dx, 0.0)) {
 		/* Solution is an edge, but this is the left-most point. */
 		return LOC_RIGHT;
-	} else if (feq_(e_floor.max_dx, 0.0) && feq_(e_floor.min_dx, 0.0)) {
+	} else if (feq_(e_floor->max_dx, 0.0) && feq_(e_floor->min_dx, 0.0)) {
 		/* This one is tough. The floor is horizontal, which means that the
 		   solution is an edge, but there is no intersection with another
 		   floor constraint that would allow us to progress naturally. We
@@ -857,17 +1090,35 @@ static int linprog2d_locate_optimum(linprog2d_data_t *prog, double mx,
 		   all other floors/ceils and return the min/max. Signal this by
 		   returning LOC_HERE_EDGE. */
 		return LOC_HERE_EDGE;
-	} else if (e_floor.min_dx < 0.0 && e_floor.max_dx > 0.0) {
+	} else if (e_floor->min_dx < 0.0 && e_floor->max_dx > 0.0) {
 		/* Vee-shape. This is the solution */
-		*y = e_floor.y;
+		*y = e_floor->y;
 		return LOC_HERE;
-	} else if (e_floor.min_dx > 0.0) {
+	} else if (e_floor->min_dx > 0.0) {
 		return LOC_LEFT;
 	} else {
 		return LOC_RIGHT;
 	}
 }
 
+/**
+ * Determines where the optimum is w.r.t. the given median mx. This function
+ * assumes that there is at least one floor constraint.
+ */
+static int linprog2d_locate_optimum(linprog2d_data_t *prog, double mx,
+                                    double *y) {
+	/* Compute the value of the ceil/floor constraints at mx and track their
+	   slope. Since multiple constraints may go through exactly the same point,
+	   we need to track both the minimum and the maximum slope for all
+	   constraints that go through the same extreme point. */
+	struct linprog2d_extremum e_ceil, e_floor;
+	e_ceil = linprog2d_track_extrema(mx, prog->dx, prog->y0, prog->ceil,
+	                                 prog->ceil_len, TRUE);
+	e_floor = linprog2d_track_extrema(mx, prog->dx, prog->y0, prog->floor,
+	                                  prog->floor_len, FALSE);
+	return linprog2d_locate_optimum_from_extrema(&e_ceil, &e_floor, y);
+}
+
 /**
  * Used internally in linprog2d_calculate_edge to check intersections between
  * the top-most horizontal floor constraint and all other ceil/floor
@@ -1002,35 +1253,75 @@ static linprog2d_result_t linprog2d_calculate_result(linprog2d_data_t *prog) {
 	}
 }
 
-/******************************************************************************
- * EXTERNAL API                                                               *
- ******************************************************************************/
+/* Paths through which linprog2d_solve() can arrive at its result, reported by
+   the "result" tracepoint */
+#define SOLVE_PATH_CAPACITY 0
+#define SOLVE_PATH_CATEGORIZE 1
+#define SOLVE_PATH_REMAINING 2
+#define SOLVE_PATH_INFEASIBLE 3
+#define SOLVE_PATH_POINT 4
+#define SOLVE_PATH_EDGE 5
 
-linprog2d_t *linprog2d_init(unsigned int capacity, char *mem) {
-	return linprog2d_init_internal((linprog2d_data_t *)mem, capacity,
-	                               mem + sizeof(linprog2d_data_t));
+/**
+ * Stores the final result of a solve and returns TRUE.
+ */
+static bool_t linprog2d_solve_done(const linprog2d_data_t *prog,
+                                   linprog2d_result_t *res, int path,
+                                   linprog2d_result_t value) {
+	LP2D_PROBE5(result, prog, path, (int)value.status, value.x1, value.y1);
+	(void)prog;
+	(void)path;
+	*res = value;
+	return TRUE;
 }
 
-linprog2d_result_t linprog2d_solve(linprog2d_t *prog_, double cx, double cy,
-                                   const double *Gx, const double *Gy,
-                                   const double *h, unsigned int n) {
-	double x = 0.0, y = 0.0; /* result x, y */
-	linprog2d_data_t *prog = (linprog2d_data_t *)prog_;
-	bool_t optimum_is_left = FALSE, has_median = FALSE;
+/**
+ * Reports the state of the prune loop after an iteration to the observer. loc
+ * is the verdict of linprog2d_locate_optimum() or -1 if no median was computed.
+ */
+static void linprog2d_observe(const linprog2d_data_t *prog, int loc) {
+	linprog2d_iteration_t it;
+	it.iteration = prog->n_iter - 1U;
+	it.mx = prog->mx;
+	it.verdict = (enum linprog2d_verdict)(loc + 1);
+	it.x0 = prog->x0;
+	it.x1 = prog->x1;
+	it.ceil_len = prog->ceil_len;
+	it.floor_len = prog->floor_len;
+	it.intersect_len = prog->intersect_len;
+	prog->observer(prog->observer_data, (const linprog2d_t *)prog, &it);
+}
 
+/**
+ * Copies the problem to the program storage and prepares the prune loop in
+ * linprog2d_solve_step(). Returns TRUE and writes the result to res if the
+ * problem could already be decided.
+ */
+static bool_t linprog2d_solve_begin(linprog2d_data_t *prog, double cx,
+                                    double cy, const double *Gx,
+                                    const double *Gy, const double *h,
+                                    unsigned int n, linprog2d_result_t *res) {
 	/* Make sure the given linprog2d instance has sufficient memory to solve
 	   the problem. If not, return with an error. */
+	LP2D_PROBE3(solve__entry, prog, n, prog ? prog->capacity : 0U);
 	if (!prog || prog->capacity < n) {
-		return linprog2d_result_err();
+		return linprog2d_solve_done(prog, res, SOLVE_PATH_CAPACITY,
+		                            linprog2d_result_err());
 	}
 
 	/* Copy the problem to the program storage and condition it. */
 	linprog2d_reset(prog, n);
 	linprog2d_condition_problem(prog, cx, cy, Gx, Gy, h);
 
+	/* Remove duplicate constraints before the prune loop if enabled. */
+	if (prog->presolve) {
+		linprog2d_presolve(prog);
+	}
+
 	/* Categorize the constraints into ceil, floor, and vertical constraints. */
 	if (!linprog2d_categorize_constraints(prog)) {
-		return linprog2d_result_infeasible();
+		return linprog2d_solve_done(prog, res, SOLVE_PATH_CATEGORIZE,
+		                            linprog2d_result_infeasible());
 	}
 
 	/* Calculate the slope for the ceil and floor constraints */
@@ -1038,105 +1329,4035 @@ linprog2d_result_t linprog2d_solve(linprog2d_t *prog_, double cx, double cy,
 	                                 prog->Gy, prog->h, prog->dx, prog->y0);
 	linprog2d_calculate_yoffset_form(prog->floor, prog->floor_len, prog->Gx,
 	                                 prog->Gy, prog->h, prog->dx, prog->y0);
+	return FALSE;
+}
+
+/**
+ * Performs a single iteration of the prune loop. Returns TRUE and writes the
+ * result to res once the problem is solved. The loop state is kept in the
+ * instance, so that the phases of the solver can be measured separately.
+ */
+static bool_t linprog2d_solve_step(linprog2d_data_t *prog,
+                                   linprog2d_result_t *res) {
+	double y = 0.0;
+	int loc;
 
 	/* Repeat until there is at most one floor and ceil constraint left or the
-	   left and right bounds are invalid. */
-	while ((prog->floor_len != 0U) &&
-	       (prog->floor_len > 1U || prog->ceil_len > 1U) &&
-	       ((prog->x1 > prog->x0) || feq_(prog->x1, prog->x0))) {
-		/* Calculate constraint intersection points. Of those constraints that
-		   are parallel or have an intersection point outside of [x0, x1], throw
-		   one away. Furthermore, if we calculated a median in the last round
-		   and know its location w.r.t. the optimum, check whether the
-		   intersection point is on that median. Note that the two functions
-		   below edit the ceil and floor list inplace. */
-		prog->intersect_len = 0U; /* number of intersections */
-		linprog2d_calculate_intersects(prog, prog->ceil, &(prog->ceil_len),
-		                               TRUE, has_median, x, optimum_is_left);
-		linprog2d_calculate_intersects(prog, prog->floor, &(prog->floor_len),
-		                               FALSE, has_median, x, optimum_is_left);
-
-		/* If we have no intersections, then the above code must have eliminated
-		   some constraints. This will give us new pairs to try. */
-		if (prog->intersect_len == 0U) {
-			continue;
-		}
+	   left and right bounds are invalid. Then compute the result from the
+	   remaining floor and ceil constraint. */
+	if (!((prog->floor_len != 0U) &&
+	      (prog->floor_len > 1U || prog->ceil_len > 1U) &&
+	      ((prog->x1 > prog->x0) || feq_(prog->x1, prog->x0)))) {
+		return linprog2d_solve_done(prog, res, SOLVE_PATH_REMAINING,
+		                            linprog2d_calculate_result(prog));
+	}
 
-		/* Compute the median of the x-coordinates of the intersection points
-		   and update the left/right boundary. */
-		x = median(prog->x_intersect, prog->intersect_len);
-		switch (linprog2d_locate_optimum(prog, x, &y)) {
-			case LOC_INFEASIBLE:
-				return linprog2d_result_infeasible();
-			case LOC_LEFT:
-				prog->x1 = fmin_(prog->x1, x);
-				optimum_is_left = TRUE;
-				has_median = TRUE;
-				break;
-			case LOC_RIGHT:
-				prog->x0 = fmax_(prog->x0, x);
-				optimum_is_left = FALSE;
-				has_median = TRUE;
-				break;
-			case LOC_HERE:
-				return linprog2d_result_point(&prog->R, &prog->o, x, y);
-			case LOC_HERE_EDGE:
-				return linprog2d_calculate_edge(prog);
+	/* Calculate constraint intersection points. Of those constraints that are
+	   parallel or have an intersection point outside of [x0, x1], throw one
+	   away. Furthermore, if we calculated a median in the last round and know
+	   its location w.r.t. the optimum, check whether the intersection point is
+	   on that median. Note that the two functions below edit the ceil and floor
+	   list inplace. */
+	prog->n_iter++;
+	prog->intersect_len = 0U; /* number of intersections */
+	linprog2d_calculate_intersects(prog, prog->ceil, &(prog->ceil_len), TRUE,
+	                               prog->has_median, prog->mx,
+	                               prog->optimum_is_left);
+	linprog2d_calculate_intersects(prog, prog->floor, &(prog->floor_len),
+	                               FALSE, prog->has_median, prog->mx,
+	                               prog->optimum_is_left);
+
+	LP2D_PROBE6(prune, prog, prog->ceil_len, prog->floor_len,
+	            prog->intersect_len, prog->x0, prog->x1);
+
+	/* If we have no intersections, then the above code must have eliminated
+	   some constraints. This will give us new pairs to try. */
+	if (prog->intersect_len == 0U) {
+		if (prog->observer) {
+			linprog2d_observe(prog, -1);
 		}
+		return FALSE;
 	}
 
-	/* Compute the results from the remaining floor and ceil constraint */
-	return linprog2d_calculate_result(prog);
+	/* Compute the median of the x-coordinates of the intersection points and
+	   update the left/right boundary. */
+	prog->mx = median(prog->x_intersect, prog->intersect_len);
+	LP2D_PROBE3(median, prog, prog->intersect_len, prog->mx);
+	loc = linprog2d_locate_optimum(prog, prog->mx, &y);
+	switch (loc) {
+		case LOC_LEFT:
+			prog->x1 = fmin_(prog->x1, prog->mx);
+			prog->optimum_is_left = TRUE;
+			prog->has_median = TRUE;
+			break;
+		case LOC_RIGHT:
+			prog->x0 = fmax_(prog->x0, prog->mx);
+			prog->optimum_is_left = FALSE;
+			prog->has_median = TRUE;
+			break;
+	}
+	if (prog->observer) {
+		linprog2d_observe(prog, loc);
+	}
+	switch (loc) {
+		case LOC_INFEASIBLE:
+			return linprog2d_solve_done(prog, res, SOLVE_PATH_INFEASIBLE,
+			                            linprog2d_result_infeasible());
+		case LOC_HERE:
+			return linprog2d_solve_done(
+			    prog, res, SOLVE_PATH_POINT,
+			    linprog2d_result_point(&prog->R, &prog->o, prog->mx, y));
+		case LOC_HERE_EDGE:
+			return linprog2d_solve_done(prog, res, SOLVE_PATH_EDGE,
+			                            linprog2d_calculate_edge(prog));
+	}
+	return FALSE;
 }
 
-#ifndef LINPROG2D_REDUCED_INTERFACE
-linprog2d_size_t linprog2d_mem_size(unsigned int capacity) {
-	linprog2d_size_t res = 0UL;
+/**
+ * Solves the problem without capture or metrics. Used by the other solvers in
+ * this library, so only problems passed to the public interface are recorded.
+ */
+static linprog2d_result_t linprog2d_solve_internal(linprog2d_data_t *prog,
+                                                   double cx, double cy,
+                                                   const double *Gx,
+                                                   const double *Gy,
+                                                   const double *h,
+                                                   unsigned int n) {
+	linprog2d_result_t res;
+	if (!linprog2d_solve_begin(prog, cx, cy, Gx, Gy, h, n, &res)) {
+		while (!linprog2d_solve_step(prog, &res)) {
+			/* Prune until the result is known */
+		}
+	}
+	return res;
+}
 
-	/* Main datastructure plus alignment */
-	res += sizeof(linprog2d_data_t) + 64UL;
+/******************************************************************************
+ * Angle-sorted constraints and convex polygons                               *
+ ******************************************************************************/
 
-	/* Space for the Gx, Gy, h, dx, y0, x_intersect lists plus alignment. The
-	   x_intersect list only has half the length. */
-	res +=
-	    (sizeof(double) * 5UL + sizeof(double) / 2UL) * capacity + 64UL * 6UL;
+#define TWO_PI 6.28318530717958647692
 
-	/* Space for the ceil, floor, tmp lists plus alignment. */
-	res += sizeof(unsigned int) * 3UL * capacity + 64UL * 3UL;
+/**
+ * Read-only view onto either a list of constraints sorted by the angle of their
+ * normals or onto the vertices of a convex polygon. In the latter case, the
+ * constraint normals are computed on the fly from the polygon edges.
+ */
+struct linprog2d_sorted {
+	/**
+	 * Either Gx and Gy or the x and y coordinates of the polygon vertices.
+	 */
+	const double *a, *b;
 
-	return res;
+	/**
+	 * Number of constraints or vertices.
+	 */
+	unsigned int n;
+
+	/**
+	 * True if a and b are polygon vertices.
+	 */
+	bool_t polygon;
+};
+
+/**
+ * Returns the normal of the k-th constraint. The k-th polygon edge goes from
+ * vertex k to vertex k + 1; its inward-facing normal is the edge direction
+ * rotated by 90 degrees counter-clockwise.
+ */
+static struct vec2 sorted_normal(const struct linprog2d_sorted *s,
+                                 unsigned int k) {
+	const unsigned int k1 = (k + 1U == s->n) ? 0U : k + 1U;
+	if (s->polygon) {
+		return vec2_create(s->b[k] - s->b[k1], s->a[k1] - s->a[k]);
+	}
+	return vec2_create(s->a[k], s->b[k]);
 }
 
-linprog2d_t *linprog2d_create(unsigned int capacity) {
-#ifndef LINPROG2D_NO_ALLOC
-	return linprog2d_init(capacity,
-	                      (char *)malloc(linprog2d_mem_size(capacity)));
-#else
-	return NULL;
-#endif
+/**
+ * Returns a pseudo-angle in [0, 4) that increases monotonically with the
+ * counter-clockwise angle from ref to v in [0, 2 pi). Each quadrant maps to an
+ * interval of length one. Uses only arithmetic, so that the reduced interface
+ * does not depend on atan2().
+ */
+static double sorted_angle(struct vec2 ref, struct vec2 v) {
+	const double y = ref.x * v.y - ref.y * v.x, x = ref.x * v.x + ref.y * v.y;
+	if (y >= 0.0) {
+		if (x >= 0.0) {
+			return (x + y > 0.0) ? y / (x + y) : 0.0;
+		}
+		return 1.0 - x / (y - x);
+	} else if (x < 0.0) {
+		return 2.0 - y / (-x - y);
+	}
+	return 3.0 + x / (x - y);
 }
 
-void linprog2d_free(linprog2d_t *prog) {
-#ifndef LINPROG2D_NO_ALLOC
-	free(prog); /* Free the previously allocated memory */
-#endif
+/**
+ * Returns true if v points in the same direction as c.
+ */
+static bool_t sorted_parallel(struct vec2 v, struct vec2 c) {
+	return feq_(v.x * c.y, v.y * c.x) && (v.x * c.x + v.y * c.y > 0.0);
 }
 
-unsigned int linprog2d_capacity(const linprog2d_t *prog) {
-	return ((linprog2d_data_t *)prog)->capacity;
+/**
+ * Binary search for the constraint l such that the gradient c lies in the
+ * cone spanned by the normals of l and l + 1 (including the normal of l).
+ * Requires s->n > 0.
+ */
+static unsigned int sorted_search(const struct linprog2d_sorted *s,
+                                  struct vec2 c) {
+	const struct vec2 ref = sorted_normal(s, 0U);
+	const double ac = sorted_angle(ref, c);
+	unsigned int lo = 1U, hi = s->n, mid;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2U;
+		if (sorted_angle(ref, sorted_normal(s, mid)) > ac) {
+			hi = mid;
+		} else {
+			lo = mid + 1U;
+		}
+	}
+	return lo - 1U;
 }
 
-linprog2d_result_t linprog2d_solve_simple(double cx, double cy,
-                                          const double *Gx, const double *Gy,
-                                          const double *h, unsigned int n) {
-#ifndef LINPROG2D_NO_ALLOC
-	linprog2d_t *prog = linprog2d_create(n);
-	if (prog) {
-		linprog2d_result_t res = linprog2d_solve(prog, cx, cy, Gx, Gy, h, n);
-		linprog2d_free(prog);
-		return res;
+/**
+ * Returns an edge result with the end points ordered consistently with
+ * linprog2d_solve().
+ */
+static linprog2d_result_t sorted_result_edge(struct vec2 c, double x1,
+                                             double y1, double x2,
+                                             double y2) {
+	if (c.y * x1 - c.x * y1 > c.y * x2 - c.x * y2) {
+		return linprog2d_result_create(LP2D_EDGE, x2, y2, x1, y1);
 	}
-#endif /* LINPROG2D_NO_ALLOC */
-	return linprog2d_result_err();
+	return linprog2d_result_create(LP2D_EDGE, x1, y1, x2, y2);
+}
+
+/**
+ * Intersects the lines of the constraints i and j.
+ */
+static struct vec2 sorted_intersect(const double *Gx, const double *Gy,
+                                    const double *h, unsigned int i,
+                                    unsigned int j) {
+	const double det = Gx[i] * Gy[j] - Gy[i] * Gx[j];
+	return vec2_create((h[i] * Gy[j] - Gy[i] * h[j]) / det,
+	                   (Gx[i] * h[j] - h[i] * Gx[j]) / det);
+}
+
+/**
+ * Returns true if the counter-clockwise angle between the normals of the
+ * constraints i and j is smaller than pi, i.e. the two constraints intersect
+ * in a vertex of the feasible region.
+ */
+static bool_t sorted_bounded(const double *Gx, const double *Gy,
+                             unsigned int i, unsigned int j) {
+	return (i != j) && (Gx[i] * Gy[j] - Gy[i] * Gx[j] > 0.0);
+}
+
+static linprog2d_result_t linprog2d_solve_sorted_internal(
+    double cx, double cy, const double *Gx, const double *Gy, const double *h,
+    unsigned int n) {
+	struct linprog2d_sorted s;
+	const struct vec2 c = vec2_create(cx, cy);
+	unsigned int l, u, e, prev, next;
+	struct vec2 p, q;
+
+	if (feq_(cx, 0.0) && feq_(cy, 0.0)) {
+		return linprog2d_result_err();
+	}
+	if (n == 0U) {
+		return linprog2d_result_unbounded();
+	}
+
+	s.a = Gx, s.b = Gy, s.n = n, s.polygon = FALSE;
+	l = sorted_search(&s, c);
+	u = (l + 1U == n) ? 0U : l + 1U;
+
+	/* If the gradient is parallel to one of the constraints, the optimum is the
+	   corresponding edge. The edge is bounded if the neighbouring constraints
+	   intersect it. */
+	if (sorted_parallel(sorted_normal(&s, l), c) ||
+	    sorted_parallel(sorted_normal(&s, u), c)) {
+		e = sorted_parallel(sorted_normal(&s, l), c) ? l : u;
+		prev = (e == 0U) ? n - 1U : e - 1U;
+		next = (e + 1U == n) ? 0U : e + 1U;
+		if (!sorted_bounded(Gx, Gy, prev, e) ||
+		    !sorted_bounded(Gx, Gy, e, next)) {
+			return linprog2d_result_unbounded();
+		}
+		p = sorted_intersect(Gx, Gy, h, prev, e);
+		q = sorted_intersect(Gx, Gy, h, e, next);
+		return sorted_result_edge(c, p.x, p.y, q.x, q.y);
+	}
+
+	/* Otherwise, the optimum is the vertex between l and u, if it exists */
+	if (!sorted_bounded(Gx, Gy, l, u)) {
+		return linprog2d_result_unbounded();
+	}
+	p = sorted_intersect(Gx, Gy, h, l, u);
+	return linprog2d_result_create(LP2D_POINT, p.x, p.y, 0.0, 0.0);
+}
+
+static linprog2d_result_t linprog2d_solve_polygon_internal(double cx, double cy,
+                                                           const double *x,
+                                                           const double *y,
+                                                           unsigned int n) {
+	struct linprog2d_sorted s;
+	const struct vec2 c = vec2_create(cx, cy);
+	unsigned int l, u, v;
+
+	if (feq_(cx, 0.0) && feq_(cy, 0.0)) {
+		return linprog2d_result_err();
+	}
+	if (n == 0U) {
+		return linprog2d_result_infeasible();
+	}
+	if (n == 1U) {
+		return linprog2d_result_create(LP2D_POINT, x[0], y[0], 0.0, 0.0);
+	}
+
+	/* Edge l goes from vertex l to vertex u; the optimum is vertex u unless the
+	   gradient is parallel to the normal of one of the edges l, u */
+	s.a = x, s.b = y, s.n = n, s.polygon = TRUE;
+	l = sorted_search(&s, c);
+	u = (l + 1U == n) ? 0U : l + 1U;
+	v = (u + 1U == n) ? 0U : u + 1U;
+	if (sorted_parallel(sorted_normal(&s, l), c)) {
+		return sorted_result_edge(c, x[l], y[l], x[u], y[u]);
+	} else if (sorted_parallel(sorted_normal(&s, u), c)) {
+		return sorted_result_edge(c, x[u], y[u], x[v], y[v]);
+	}
+	return linprog2d_result_create(LP2D_POINT, x[u], y[u], 0.0, 0.0);
+}
+
+/******************************************************************************
+ * Prepared feasible regions                                                  *
+ ******************************************************************************/
+
+/**
+ * Upper envelope (pointwise maximum) of a set of lines y = y0[i] + dx[i] * x.
+ * Only lines that actually contribute to the envelope are stored. The lines
+ * are sorted by ascending slope; line i is the maximum in the interval
+ * [bx[i - 1], bx[i]], where bx[len - 1] is infinity.
+ */
+struct linprog2d_envelope {
+	/**
+	 * Slopes, y-axis offsets and right breakpoints of the lines.
+	 */
+	double *dx, *y0, *bx;
+
+	/**
+	 * Number of lines in the envelope.
+	 */
+	unsigned int len;
+};
+
+/**
+ * Internally used structure holding all the data associated with a prepared
+ * feasible region. The region is stored as the set of points (x, y) with
+ *
+ * x0 <= x <= x1 and floor(x) <= y <= -ceil(x),
+ *
+ * where floor and ceil are upper envelopes. The ceil envelope stores the
+ * negated ceiling constraints, such that both envelopes are convex.
+ */
+struct linprog2d_region_data {
+	/**
+	 * Envelopes of the floor and (negated) ceiling constraints. Both envelopes
+	 * share the same memory.
+	 */
+	struct linprog2d_envelope floor, ceil;
+
+	/**
+	 * Temporary slope/offset form of the constraints used while preparing the
+	 * region.
+	 */
+	double *src_dx, *src_y0;
+
+	/**
+	 * Temporary memory used for sorting the constraints.
+	 */
+	unsigned int *idcs;
+
+	/**
+	 * Left and right boundary of the region. If the region is empty, x0 is
+	 * larger than x1.
+	 */
+	double x0, x1;
+
+	/**
+	 * Number of constraints the region can be prepared from.
+	 */
+	unsigned int capacity;
+};
+
+typedef struct linprog2d_region_data linprog2d_region_data_t;
+
+static linprog2d_region_t *linprog2d_region_init_internal(
+    linprog2d_region_data_t *region, unsigned int capacity, char *mem) {
+#define SD sizeof(double)
+	if (!region) {
+		return NULL;
+	}
+
+	/* Calculate the offsets for the individual arrays from the continuous
+	   piece of memory passed to this function */
+	region->floor.dx = (double *)mem_align64(mem, 0U);
+	region->floor.y0 = (double *)mem_align64(region->floor.dx, SD * capacity);
+	region->floor.bx = (double *)mem_align64(region->floor.y0, SD * capacity);
+	region->src_dx = (double *)mem_align64(region->floor.bx, SD * capacity);
+	region->src_y0 = (double *)mem_align64(region->src_dx, SD * capacity);
+	region->idcs = (unsigned int *)mem_align64(region->src_y0, SD * capacity);
+	region->capacity = capacity;
+
+	/* The region is initially the entire plane */
+	region->floor.len = 0U;
+	region->ceil = region->floor;
+	region->x0 = -HUGE_VAL;
+	region->x1 = HUGE_VAL;
+
+	return region;
+#undef SD
+}
+
+/**
+ * Computes the x-coordinate of the intersection between two lines in
+ * slope/offset form. Lines with equal slope must be handled by the caller.
+ */
+static double linprog2d_line_intersect(double dx1, double y01, double dx2,
+                                       double y02) {
+	return (y01 - y02) / (dx2 - dx1);
+}
+
+/**
+ * Computes the upper envelope of the given lines and writes it to the arrays
+ * dx, y0, bx. Uses the well-known convex hull trick: after sorting the lines by
+ * slope, a line is dropped as soon as it is hidden by its neighbours. Returns
+ * the number of lines in the envelope.
+ */
+static unsigned int linprog2d_envelope_build(const double *src_dx,
+                                             const double *src_y0,
+                                             unsigned int *idcs,
+                                             unsigned int len, double *dx,
+                                             double *y0, double *bx) {
+	unsigned int i, j, m = 0U;
+	sort_indices(idcs, len, src_dx);
+	for (i = 0U; i < len; i++) {
+		j = idcs[i];
+
+		/* Of two parallel lines only keep the upper one */
+		if (m > 0U && feq_(dx[m - 1U], src_dx[j])) {
+			if (y0[m - 1U] >= src_y0[j]) {
+				continue;
+			}
+			m--;
+		}
+
+		/* Remove lines that are hidden by their neighbours */
+		while (m > 1U && linprog2d_line_intersect(dx[m - 2U], y0[m - 2U],
+		                                          src_dx[j], src_y0[j]) <=
+		                     bx[m - 2U]) {
+			m--;
+		}
+
+		/* Update the breakpoint of the previous line and append this line */
+		if (m > 0U) {
+			bx[m - 1U] = linprog2d_line_intersect(dx[m - 1U], y0[m - 1U],
+			                                      src_dx[j], src_y0[j]);
+		}
+		dx[m] = src_dx[j], y0[m] = src_y0[j], bx[m] = HUGE_VAL;
+		m++;
+	}
+	return m;
+}
+
+/**
+ * Returns the index of the line that forms the envelope at x. This is a
+ * branch-free binary search over the breakpoints.
+ */
+static unsigned int linprog2d_envelope_find(const struct linprog2d_envelope *e,
+                                            double x) {
+	unsigned int base = 0U, n = e->len, half;
+	while (n > 1U) {
+		half = n / 2U;
+		base = (e->bx[base + half - 1U] < x) ? base + half : base;
+		n -= half;
+	}
+	return base;
+}
+
+/**
+ * Evaluates the envelope at x. Returns -infinity if the envelope is empty.
+ */
+static double linprog2d_envelope_eval(const struct linprog2d_envelope *e,
+                                      double x) {
+	unsigned int i;
+	if (e->len == 0U) {
+		return -HUGE_VAL;
+	}
+	i = linprog2d_envelope_find(e, x);
+	return e->y0[i] + e->dx[i] * x;
+}
+
+/**
+ * Restricts [x0, x1] to the interval in which the floor is below the ceiling.
+ * Since floor and ceiling are both linear between their combined breakpoints,
+ * this only requires a single merge-like pass over both envelopes.
+ */
+static void linprog2d_region_clip(linprog2d_region_data_t *r) {
+	const struct linprog2d_envelope *f = &r->floor, *c = &r->ceil;
+	unsigned int i = 0U, j = 0U;
+	double lo = -HUGE_VAL, hi, a, b, p, q;
+	double fa = HUGE_VAL, fb = -HUGE_VAL; /* Feasible interval */
+
+	if (f->len == 0U || c->len == 0U) {
+		return; /* Floor and ceiling never intersect */
+	}
+
+	while (TRUE) {
+		/* Both envelopes are linear in [lo, hi]. Compute the interval
+		   [a, b] in which p + q * x = -ceil(x) - floor(x) >= 0. */
+		hi = fmin_(f->bx[i], c->bx[j]);
+		p = -c->y0[j] - f->y0[i], q = -c->dx[j] - f->dx[i];
+		a = fmax_(fmax_(lo, r->x0), (q > 0.0) ? -p / q : -HUGE_VAL);
+		b = fmin_(fmin_(hi, r->x1), (q < 0.0) ? -p / q : HUGE_VAL);
+		if ((q != 0.0 || p >= 0.0) && a <= b) {
+			fa = fmin_(fa, a), fb = fmax_(fb, b);
+		}
+
+		/* Advance to the next breakpoint */
+		if (hi >= HUGE_VAL) {
+			break;
+		}
+		if (f->bx[i] <= hi) {
+			i++;
+		}
+		if (c->bx[j] <= hi) {
+			j++;
+		}
+		lo = hi;
+	}
+	r->x0 = fa, r->x1 = fb;
+}
+
+/**
+ * Builds the region from the given constraints. Returns false if the region
+ * instance does not have sufficient capacity.
+ */
+static bool_t linprog2d_region_prepare_internal(linprog2d_region_data_t *r,
+                                                const double *Gx,
+                                                const double *Gy,
+                                                const double *h,
+                                                unsigned int n) {
+	unsigned int i, n_floor = 0U, n_ceil = 0U;
+	double gx, gy, hi, norm;
+
+	if (!r || r->capacity < n) {
+		return FALSE;
+	}
+
+	/* Reset the region to the entire plane */
+	r->x0 = -HUGE_VAL, r->x1 = HUGE_VAL;
+	r->floor.len = r->ceil.len = 0U;
+
+	/* Convert the constraints to slope/offset form. Floor constraints are
+	   written to the beginning, ceil constraints to the end of the temporary
+	   arrays. */
+	for (i = 0U; i < n; i++) {
+		norm = linprog2d_normalization_coeff(Gx[i], Gy[i]);
+		if (feq_(norm, 0.0)) {
+			if (h[i] > 0.0) {
+				r->x0 = HUGE_VAL, r->x1 = -HUGE_VAL; /* Region is empty */
+			}
+			continue;
+		}
+		gx = Gx[i] / norm, gy = Gy[i] / norm, hi = h[i] / norm;
+		switch (linprog2d_constraint_category(gx, gy)) {
+			case CAT_VERT_LEFT:
+				r->x0 = fmax_(r->x0, hi / gx);
+				break;
+			case CAT_VERT_RIGHT:
+				r->x1 = fmin_(r->x1, hi / gx);
+				break;
+			case CAT_FLOOR:
+				r->src_dx[n_floor] = -gx / gy, r->src_y0[n_floor] = hi / gy;
+				r->idcs[n_floor] = n_floor;
+				n_floor++;
+				break;
+			case CAT_CEIL:
+				/* Store the negated line y <= y0 + dx * x */
+				n_ceil++;
+				r->src_dx[n - n_ceil] = gx / gy;
+				r->src_y0[n - n_ceil] = -hi / gy;
+				r->idcs[n - n_ceil] = n - n_ceil;
+				break;
+		}
+	}
+
+	/* Compute the upper envelopes. The ceil envelope is stored directly after
+	   the floor envelope. */
+	r->floor.len = linprog2d_envelope_build(r->src_dx, r->src_y0, r->idcs,
+	                                        n_floor, r->floor.dx, r->floor.y0,
+	                                        r->floor.bx);
+	r->ceil.dx = r->floor.dx + r->floor.len;
+	r->ceil.y0 = r->floor.y0 + r->floor.len;
+	r->ceil.bx = r->floor.bx + r->floor.len;
+	r->ceil.len = linprog2d_envelope_build(r->src_dx, r->src_y0,
+	                                       r->idcs + n - n_ceil, n_ceil,
+	                                       r->ceil.dx, r->ceil.y0, r->ceil.bx);
+
+	/* Compute the interval in which the region is not empty */
+	if (r->x0 <= r->x1) {
+		linprog2d_region_clip(r);
+	}
+	return TRUE;
+}
+
+/**
+ * Number of queries that are processed simultaneously by
+ * linprog2d_region_contains(). The binary searches for the individual queries
+ * are interleaved so that their independent memory accesses overlap. The
+ * lookups are scalar gathers, so this does not vectorise.
+ */
+#define REGION_LANES 4U
+
+/**
+ * Tests whether the given points are inside the region. Interleaves the
+ * queries of REGION_LANES points; only the first m results are written.
+ */
+static void linprog2d_region_contains_interleaved(
+    const linprog2d_region_data_t *r, const double *x, const double *y,
+    unsigned char *inside, unsigned int m) {
+	const struct linprog2d_envelope *f = &r->floor, *c = &r->ceil;
+	unsigned int k, n, half, fi[REGION_LANES], ci[REGION_LANES];
+	bool_t res;
+
+	/* Interleaved binary search in the floor and ceil envelopes */
+	for (k = 0U; k < REGION_LANES; k++) {
+		fi[k] = ci[k] = 0U;
+	}
+	for (n = f->len; n > 1U; n -= half) {
+		half = n / 2U;
+		for (k = 0U; k < REGION_LANES; k++) {
+			fi[k] += (f->bx[fi[k] + half - 1U] < x[k]) ? half : 0U;
+		}
+	}
+	for (n = c->len; n > 1U; n -= half) {
+		half = n / 2U;
+		for (k = 0U; k < REGION_LANES; k++) {
+			ci[k] += (c->bx[ci[k] + half - 1U] < x[k]) ? half : 0U;
+		}
+	}
+
+	/* Evaluate the envelopes */
+	for (k = 0U; k < m; k++) {
+		res = (x[k] >= r->x0) && (x[k] <= r->x1);
+		if (f->len > 0U) {
+			res = res && (y[k] >= f->y0[fi[k]] + f->dx[fi[k]] * x[k]);
+		}
+		if (c->len > 0U) {
+			res = res && (-y[k] >= c->y0[ci[k]] + c->dx[ci[k]] * x[k]);
+		}
+		inside[k] = res ? 1U : 0U;
+	}
+}
+
+/**
+ * Computes the distance between the point (px, py) and the part of the line
+ * y = y0 + dx * x with x in [lo, hi].
+ */
+static double linprog2d_segment_distance(double dx, double y0, double lo,
+                                         double hi, double px, double py) {
+	double x = (px + dx * (py - y0)) / (1.0 + dx * dx); /* Projection */
+	x = fmin_(fmax_(x, lo), hi);
+	return hypot_(px - x, py - (y0 + dx * x));
+}
+
+/**
+ * Computes the distance between the point (px, py) and the boundary pieces of
+ * the given envelope that are in the interval [x0, x1]. The sign flips the
+ * envelope back to its original orientation.
+ */
+static double linprog2d_envelope_distance(const struct linprog2d_envelope *e,
+                                          double sign, double x0, double x1,
+                                          double px, double py) {
+	unsigned int i;
+	double lo, hi, d = HUGE_VAL;
+	for (i = 0U; i < e->len; i++) {
+		lo = fmax_(x0, (i == 0U) ? -HUGE_VAL : e->bx[i - 1U]);
+		hi = fmin_(x1, e->bx[i]);
+		if (lo <= hi) {
+			d = fmin_(d, linprog2d_segment_distance(
+			                 sign * e->dx[i], sign * e->y0[i], lo, hi, px, py));
+		}
+	}
+	return d;
+}
+
+/**
+ * Computes the distance between the point (px, py) and the vertical boundary
+ * piece of the region at x (if there is any).
+ */
+static double linprog2d_region_vertical_distance(
+    const linprog2d_region_data_t *r, double x, double px, double py) {
+	double ylo, yhi;
+	if (x <= -HUGE_VAL || x >= HUGE_VAL) {
+		return HUGE_VAL;
+	}
+	ylo = linprog2d_envelope_eval(&r->floor, x);
+	yhi = -linprog2d_envelope_eval(&r->ceil, x);
+	return hypot_(px - x, py - fmin_(fmax_(py, ylo), yhi));
+}
+
+/**
+ * Computes the signed distance between the point (px, py) and the boundary of
+ * the region. The distance is negative if the point is inside the region.
+ */
+static double linprog2d_region_distance_single(const linprog2d_region_data_t *r,
+                                               double px, double py) {
+	unsigned char inside[REGION_LANES];
+	double x[REGION_LANES], y[REGION_LANES], d;
+	unsigned int k;
+
+	/* Since the region is convex, the distance to the boundary is the minimum
+	   distance to any of the boundary pieces. */
+	d = linprog2d_envelope_distance(&r->floor, 1.0, r->x0, r->x1, px, py);
+	d = fmin_(d, linprog2d_envelope_distance(&r->ceil, -1.0, r->x0, r->x1, px,
+	                                         py));
+	d = fmin_(d, linprog2d_region_vertical_distance(r, r->x0, px, py));
+	d = fmin_(d, linprog2d_region_vertical_distance(r, r->x1, px, py));
+
+	/* Determine the sign */
+	for (k = 0U; k < REGION_LANES; k++) {
+		x[k] = px, y[k] = py;
+	}
+	linprog2d_region_contains_interleaved(r, x, y, inside, 1U);
+	return inside[0] ? -d : d;
+}
+
+/* Relative tolerance used when comparing objective values and checking the
+   additional constraints in linprog2d_region_solve() */
+#define REGION_EPS 1e-9
+
+/**
+ * Returns the index of the first line in the envelope with a slope larger than
+ * or equal to s (or larger than s if strict is true).
+ */
+static unsigned int linprog2d_envelope_find_slope(
+    const struct linprog2d_envelope *e, double s, bool_t strict) {
+	unsigned int base = 0U, n = e->len, half;
+	while (n > 0U) {
+		half = n / 2U;
+		if (strict ? (e->dx[base + half] <= s) : (e->dx[base + half] < s)) {
+			base += half + 1U;
+			n -= half + 1U;
+		} else {
+			n = half;
+		}
+	}
+	return base;
+}
+
+/**
+ * Computes the interval [lo, hi] in which the envelope is below or on the line
+ * y = a + b * x. Since the envelope is convex, this set is an interval; its
+ * end points are found by binary search over the breakpoints in O(log n).
+ * Returns false if the interval is empty.
+ */
+static bool_t linprog2d_envelope_below(const struct linprog2d_envelope *e,
+                                       double a, double b, double *lo,
+                                       double *hi) {
+#define PHI(i, x) (e->y0[i] - a + (e->dx[i] - b) * (x))
+	const unsigned int L = e->len;
+	unsigned int m, base, n, half;
+
+	*lo = -HUGE_VAL, *hi = HUGE_VAL;
+	if (L == 0U) {
+		return TRUE;
+	}
+
+	/* The difference phi between envelope and line is minimal at the first
+	   piece m with a slope larger than or equal to b */
+	m = linprog2d_envelope_find_slope(e, b, FALSE);
+	if (m < L && feq_(e->dx[m], b) && PHI(m, 0.0) > 0.0) {
+		return FALSE; /* Parallel piece above the line */
+	}
+	if (m > 0U && m < L && PHI(m, e->bx[m - 1U]) > 0.0) {
+		return FALSE; /* Minimum above the line */
+	}
+
+	/* Right end: first piece j >= m whose right end is above the line. Pieces
+	   with infinite right end are above the line iff their slope is larger
+	   than b. */
+	base = m, n = L - m;
+	while (n > 0U) {
+		half = n / 2U;
+		if (base + half + 1U < L ? PHI(base + half, e->bx[base + half]) <= 0.0
+		                         : !(e->dx[base + half] > b)) {
+			base += half + 1U;
+			n -= half + 1U;
+		} else {
+			n = half;
+		}
+	}
+	if (base < L) {
+		*hi = (a - e->y0[base]) / (e->dx[base] - b);
+	}
+
+	/* Left end: last piece j < m whose left end is above the line. Since all
+	   pieces before m have a slope smaller than b, the left end of piece zero
+	   is always above the line. */
+	if (m > 0U) {
+		base = 0U, n = m;
+		while (n > 1U) {
+			half = n / 2U;
+			base = (PHI(base + half, e->bx[base + half - 1U]) > 0.0)
+			           ? base + half
+			           : base;
+			n -= half;
+		}
+		*lo = (a - e->y0[base]) / (e->dx[base] - b);
+	}
+	return TRUE;
+#undef PHI
+}
+
+/**
+ * Returns true if the point (x, y) satisfies the constraint
+ * Gx * x + Gy * y >= h up to a small relative tolerance.
+ */
+static bool_t linprog2d_region_satisfies(double Gx, double Gy, double h,
+                                         double x, double y) {
+	const double lhs = Gx * x + Gy * y;
+	return lhs - h >=
+	       -REGION_EPS * (1.0 + fabs(Gx * x) + fabs(Gy * y) + fabs(h));
+}
+
+/**
+ * Segment p + t * d with t in [t0, t1] used by linprog2d_region_solve().
+ */
+struct linprog2d_segment {
+	struct vec2 p, d;
+	double t0, t1;
+};
+
+/**
+ * Returns true if the segment is not empty. End points that are no further
+ * apart than the rounding error, as in vertices of the region, are merged into
+ * a single point.
+ */
+static bool_t linprog2d_segment_valid(struct linprog2d_segment *seg) {
+	if (seg->t0 > -HUGE_VAL && seg->t1 < HUGE_VAL &&
+	    fabs(seg->t0 - seg->t1) <=
+	        REGION_EPS * (1.0 + fabs(seg->t0) + fabs(seg->t1))) {
+		seg->t0 = seg->t1 = 0.5 * (seg->t0 + seg->t1);
+	}
+	return seg->t0 <= seg->t1;
+}
+
+/**
+ * Computes the set of optimal points of the linear program with the region as
+ * feasible set. The optimum is searched on the floor envelope if the gradient
+ * points upwards, on the ceiling envelope if it points downwards, and on the
+ * vertical boundaries otherwise. The resulting segment may be a single point
+ * or have infinite end points. Returns false if the objective is unbounded
+ * below. Runs in O(log n).
+ */
+static bool_t linprog2d_region_optimum(const linprog2d_region_data_t *r,
+                                       double cx, double cy,
+                                       struct linprog2d_segment *seg) {
+	const struct linprog2d_envelope *e;
+	double sign, s, x;
+	unsigned int i;
+
+	if (feq_(cy, 0.0)) {
+		/* Optimum is on the left or right boundary */
+		x = (cx > 0.0) ? r->x0 : r->x1;
+		if (x <= -HUGE_VAL || x >= HUGE_VAL) {
+			return FALSE;
+		}
+		seg->p = vec2_create(x, 0.0), seg->d = vec2_create(0.0, 1.0);
+		seg->t0 = linprog2d_envelope_eval(&r->floor, x);
+		seg->t1 = -linprog2d_envelope_eval(&r->ceil, x);
+		return TRUE;
+	}
+
+	/* On the selected envelope, the objective is cx * x + |cy| * e(x); this
+	   function is convex with slope cx + |cy| * dx[i] on piece i. */
+	e = (cy > 0.0) ? &r->floor : &r->ceil;
+	sign = (cy > 0.0) ? 1.0 : -1.0;
+	if (e->len == 0U) {
+		return FALSE;
+	}
+	s = -sign * cx / cy;
+	i = linprog2d_envelope_find_slope(e, s, FALSE);
+	if (i < e->len && feq_(e->dx[i], s)) {
+		/* The objective is constant on piece i */
+		seg->p = vec2_create(0.0, sign * e->y0[i]);
+		seg->d = vec2_create(1.0, sign * e->dx[i]);
+		seg->t0 = fmax_(r->x0, (i == 0U) ? -HUGE_VAL : e->bx[i - 1U]);
+		seg->t1 = fmin_(r->x1, e->bx[i]);
+		if (linprog2d_segment_valid(seg)) {
+			return TRUE;
+		}
+	}
+	x = (i == 0U) ? -HUGE_VAL : ((i == e->len) ? HUGE_VAL : e->bx[i - 1U]);
+	x = fmin_(fmax_(x, r->x0), r->x1);
+	if (x <= -HUGE_VAL || x >= HUGE_VAL) {
+		return FALSE;
+	}
+	seg->p = vec2_create(x, sign * linprog2d_envelope_eval(e, x));
+	seg->d = vec2_create(0.0, 0.0);
+	seg->t0 = seg->t1 = 0.0;
+	return TRUE;
+}
+
+/**
+ * Clips the segment with the constraints in G, h except for the constraint
+ * with index skip. Returns false if the segment is empty afterwards.
+ */
+static bool_t linprog2d_segment_clip(struct linprog2d_segment *seg,
+                                     const double *Gx, const double *Gy,
+                                     const double *h, unsigned int k,
+                                     unsigned int skip) {
+	unsigned int j;
+	double gd, gp;
+	for (j = 0U; j < k; j++) {
+		if (j == skip) {
+			continue;
+		}
+		gd = Gx[j] * seg->d.x + Gy[j] * seg->d.y;
+		gp = Gx[j] * seg->p.x + Gy[j] * seg->p.y;
+		if (feq_(gd, 0.0)) {
+			if (!linprog2d_region_satisfies(Gx[j], Gy[j], h[j], seg->p.x,
+			                                seg->p.y)) {
+				return FALSE;
+			}
+		} else if (gd > 0.0) {
+			seg->t0 = fmax_(seg->t0, (h[j] - gp) / gd);
+		} else {
+			seg->t1 = fmin_(seg->t1, (h[j] - gp) / gd);
+		}
+	}
+	return linprog2d_segment_valid(seg);
+}
+
+/**
+ * Intersects the line Gx * x + Gy * y = h with the region. Runs in O(log n).
+ * Returns false if the intersection is empty.
+ */
+static bool_t linprog2d_region_intersect_line(const linprog2d_region_data_t *r,
+                                              double Gx, double Gy, double h,
+                                              struct linprog2d_segment *seg) {
+	const double norm = linprog2d_normalization_coeff(Gx, Gy);
+	double gx = Gx / norm, gy = Gy / norm, hn = h / norm, a, b, lo, hi;
+
+	if (linprog2d_constraint_category(gx, gy) <= CAT_VERT_RIGHT) {
+		/* Vertical line; parametrise by y */
+		seg->p = vec2_create(hn / gx, 0.0), seg->d = vec2_create(0.0, 1.0);
+		seg->t0 = linprog2d_envelope_eval(&r->floor, seg->p.x);
+		seg->t1 = -linprog2d_envelope_eval(&r->ceil, seg->p.x);
+		return seg->p.x >= r->x0 && seg->p.x <= r->x1 &&
+		       linprog2d_segment_valid(seg);
+	}
+
+	/* Line y = a + b * x; parametrise by x */
+	a = hn / gy, b = -gx / gy;
+	seg->p = vec2_create(0.0, a), seg->d = vec2_create(1.0, b);
+	seg->t0 = r->x0, seg->t1 = r->x1;
+	if (!linprog2d_envelope_below(&r->floor, a, b, &lo, &hi)) {
+		return FALSE;
+	}
+	seg->t0 = fmax_(seg->t0, lo), seg->t1 = fmin_(seg->t1, hi);
+	if (!linprog2d_envelope_below(&r->ceil, -a, -b, &lo, &hi)) {
+		return FALSE;
+	}
+	seg->t0 = fmax_(seg->t0, lo), seg->t1 = fmin_(seg->t1, hi);
+	return linprog2d_segment_valid(seg);
+}
+
+/**
+ * Returns true if the objective can decrease indefinitely along some direction
+ * d in the recession cone of the region intersected with the given
+ * constraints. The recession cone of the region is described by at most six
+ * homogeneous constraints: the extreme slopes of both envelopes and the
+ * vertical boundaries. Its extreme rays are perpendicular to one of the
+ * constraint normals, or, if the cone is the entire plane, -c is a descent
+ * direction.
+ */
+static bool_t linprog2d_region_descent(const linprog2d_region_data_t *r,
+                                       double cx, double cy, const double *Gx,
+                                       const double *Gy, unsigned int k) {
+	double ux[6], uy[6], dx, dy, g1, g2, tol;
+	unsigned int nu = 0U, i, j, m = 0U;
+	const struct linprog2d_envelope *f = &r->floor, *c = &r->ceil;
+
+	/* Homogeneous constraints of the region */
+	if (f->len > 0U) {
+		ux[nu] = -f->dx[0U], uy[nu++] = 1.0;
+		ux[nu] = -f->dx[f->len - 1U], uy[nu++] = 1.0;
+	}
+	if (c->len > 0U) {
+		ux[nu] = -c->dx[0U], uy[nu++] = -1.0;
+		ux[nu] = -c->dx[c->len - 1U], uy[nu++] = -1.0;
+	}
+	if (r->x0 > -HUGE_VAL) {
+		ux[nu] = 1.0, uy[nu++] = 0.0;
+	}
+	if (r->x1 < HUGE_VAL) {
+		ux[nu] = -1.0, uy[nu++] = 0.0;
+	}
+
+	/* Candidate directions: -c and both directions along each constraint */
+	for (i = 0U; i < 1U + 2U * (nu + k); i++) {
+		if (i == 0U) {
+			dx = -cx, dy = -cy;
+		} else {
+			j = (i - 1U) / 2U;
+			dx = (j < nu) ? -uy[j] : -Gy[j - nu];
+			dy = (j < nu) ? ux[j] : Gx[j - nu];
+			dx = (i % 2U) ? dx : -dx, dy = (i % 2U) ? dy : -dy;
+		}
+		if (!(cx * dx + cy * dy < -REGION_EPS * hypot_(cx, cy) * hypot_(dx, dy))) {
+			continue;
+		}
+		for (m = 0U; m < nu + k; m++) {
+			g1 = (m < nu) ? ux[m] : Gx[m - nu];
+			g2 = (m < nu) ? uy[m] : Gy[m - nu];
+			tol = REGION_EPS * hypot_(g1, g2) * hypot_(dx, dy);
+			if (g1 * dx + g2 * dy < -tol) {
+				break;
+			}
+		}
+		if (m == nu + k) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * Returns some point inside the (non-empty) region.
+ */
+static struct vec2 linprog2d_region_point(const linprog2d_region_data_t *r) {
+	const double x = fmin_(fmax_(0.0, r->x0), r->x1);
+	const double ylo = linprog2d_envelope_eval(&r->floor, x);
+	const double yhi = -linprog2d_envelope_eval(&r->ceil, x);
+	if (ylo > -HUGE_VAL && yhi < HUGE_VAL) {
+		return vec2_create(x, 0.5 * (ylo + yhi));
+	}
+	return vec2_create(x, (ylo > -HUGE_VAL) ? ylo : fmin_(0.0, yhi));
+}
+
+/**
+ * Best candidate found by linprog2d_region_solve(). Edges are preferred over
+ * points with the same objective value.
+ */
+struct linprog2d_region_candidate {
+	linprog2d_result_t res;
+	double value;
+	bool_t valid, edge;
+};
+
+/**
+ * Computes the optimum of the objective on the given segment and replaces the
+ * best candidate if the optimum is better. Segments on which the objective
+ * decreases indefinitely are ignored; they are detected by
+ * linprog2d_region_descent().
+ */
+static void linprog2d_region_candidate_update(
+    struct linprog2d_region_candidate *best, struct vec2 c,
+    const struct linprog2d_segment *seg) {
+	const double cd = c.x * seg->d.x + c.y * seg->d.y;
+	const bool_t flat = feq_(c.x * seg->d.x, -c.y * seg->d.y);
+	linprog2d_result_t res;
+	double t, value, tol;
+	bool_t edge = FALSE;
+	struct vec2 p, q;
+
+	if (flat) {
+		/* The objective is constant along the segment */
+		t = (seg->t0 > -HUGE_VAL) ? seg->t0
+		                          : ((seg->t1 < HUGE_VAL) ? seg->t1 : 0.0);
+	} else {
+		t = (cd > 0.0) ? seg->t0 : seg->t1;
+		if (t <= -HUGE_VAL || t >= HUGE_VAL) {
+			return;
+		}
+	}
+	p = vec2_create(seg->p.x + t * seg->d.x, seg->p.y + t * seg->d.y);
+	value = c.x * p.x + c.y * p.y;
+	res = linprog2d_result_create(LP2D_POINT, p.x, p.y, 0.0, 0.0);
+	if (flat && (seg->t0 <= -HUGE_VAL || seg->t1 >= HUGE_VAL)) {
+		res = linprog2d_result_unbounded(), edge = TRUE;
+	} else if (flat && seg->t0 < seg->t1) {
+		q = vec2_create(seg->p.x + seg->t1 * seg->d.x,
+		                seg->p.y + seg->t1 * seg->d.y);
+		res = sorted_result_edge(c, p.x, p.y, q.x, q.y), edge = TRUE;
+	}
+
+	tol = REGION_EPS * (1.0 + fabs(value) + fabs(best->value));
+	if (!best->valid || value < best->value - tol ||
+	    (value <= best->value + tol && edge && !best->edge)) {
+		best->res = res, best->value = value;
+		best->valid = TRUE, best->edge = edge;
+	}
+}
+
+/**
+ * Solves the linear program consisting of the region and k additional
+ * constraints. The optimum is either the optimum of the region (if it satisfies
+ * all additional constraints), or lies on one of the additional constraint
+ * lines. Runs in O(k log n + k^2).
+ */
+static linprog2d_result_t linprog2d_region_solve_internal(
+    const linprog2d_region_data_t *r, double cx, double cy, const double *Gx,
+    const double *Gy, const double *h, unsigned int k) {
+	const struct vec2 c = vec2_create(cx, cy);
+	struct linprog2d_region_candidate best;
+	struct linprog2d_segment seg;
+	bool_t feasible = FALSE;
+	struct vec2 p;
+	unsigned int i;
+
+	if (feq_(cx, 0.0) && feq_(cy, 0.0)) {
+		return linprog2d_result_err();
+	}
+	if (!(r->x0 <= r->x1)) {
+		return linprog2d_result_infeasible();
+	}
+
+	/* Handle degenerate constraints of the form 0 >= h */
+	for (i = 0U; i < k; i++) {
+		if (feq_(linprog2d_normalization_coeff(Gx[i], Gy[i]), 0.0) &&
+		    h[i] > 0.0) {
+			return linprog2d_result_infeasible();
+		}
+	}
+
+	/* Candidate from the base region; optimal edges are clipped by the
+	   additional constraints */
+	best.valid = best.edge = FALSE, best.value = 0.0;
+	if (linprog2d_region_optimum(r, cx, cy, &seg) &&
+	    linprog2d_segment_clip(&seg, Gx, Gy, h, k, k)) {
+		linprog2d_region_candidate_update(&best, c, &seg);
+		feasible = TRUE;
+	}
+
+	/* Candidates on each of the additional constraint lines */
+	for (i = 0U; i < k; i++) {
+		if (feq_(linprog2d_normalization_coeff(Gx[i], Gy[i]), 0.0)) {
+			continue;
+		}
+		if (linprog2d_region_intersect_line(r, Gx[i], Gy[i], h[i], &seg) &&
+		    linprog2d_segment_clip(&seg, Gx, Gy, h, k, i)) {
+			linprog2d_region_candidate_update(&best, c, &seg);
+			feasible = TRUE;
+		}
+	}
+
+	/* If none of the segments is feasible, the feasible set is either empty or
+	   the entire region (in which case the base problem must be unbounded).
+	   A bounded objective at this point means that the optimum was lost to
+	   rounding; report an error rather than a wrong status. */
+	if (!feasible) {
+		p = linprog2d_region_point(r);
+		for (i = 0U; i < k; i++) {
+			if (!linprog2d_region_satisfies(Gx[i], Gy[i], h[i], p.x, p.y)) {
+				return linprog2d_result_infeasible();
+			}
+		}
+		if (linprog2d_region_descent(r, cx, cy, Gx, Gy, k)) {
+			return linprog2d_result_unbounded();
+		}
+		return linprog2d_result_err();
+	}
+	if (!best.valid || linprog2d_region_descent(r, cx, cy, Gx, Gy, k)) {
+		return linprog2d_result_unbounded();
+	}
+	return best.res;
+}
+
+/******************************************************************************
+ * Dynamic constraint sets                                                    *
+ ******************************************************************************/
+
+/* The dynamic constraint set stores each of the following constraint classes
+   in a separate tree. Vertical constraints are stored as horizontal lines,
+   right and ceil constraints are negated. This way, all trees represent an
+   upper envelope. */
+#define DYN_FLOOR 0
+#define DYN_CEIL 1
+#define DYN_LEFT 2
+#define DYN_RIGHT 3
+#define DYN_N_TREES 4
+#define DYN_TRUE 4  /* Constraint of the form 0 >= h with h <= 0 */
+#define DYN_FALSE 5 /* Constraint of the form 0 >= h with h > 0 */
+#define DYN_UNUSED 6
+
+/* Index representing the absence of a node */
+#define DYN_NIL 0xFFFFFFFFU
+
+/**
+ * Node in one of the trees of a dynamic constraint set. The trees are
+ * leaf-oriented; each leaf stores a line, the leaves are sorted by slope. Each
+ * inner node stores the x-coordinate at which the envelope of its left subtree
+ * crosses the envelope of its right subtree. Left of this point, the envelope
+ * of the entire subtree is the envelope of the left subtree, right of this
+ * point it is the envelope of the right subtree. Hence, the envelope can be
+ * evaluated by descending the tree in O(log n) (this is the central idea of
+ * the Overmars-van Leeuwen structure).
+ */
+struct linprog2d_dynamic_node {
+	/**
+	 * Slope and offset of the line stored in a leaf.
+	 */
+	double dx, y0;
+
+	/**
+	 * Inner nodes: x-coordinate of the crossing point of the two child
+	 * envelopes. May be infinite if one of the envelopes dominates.
+	 */
+	double key;
+
+	/**
+	 * Inner nodes: slope separating the left from the right subtree.
+	 */
+	double split;
+
+	/**
+	 * Children and parent of this node. The children of a leaf are DYN_NIL.
+	 * The left child of a free node points at the next free node.
+	 */
+	unsigned int left, right, parent;
+
+	/**
+	 * Number of leaves in the subtree.
+	 */
+	unsigned int size;
+
+	/**
+	 * Class of the constraint stored in a leaf (one of the DYN_* constants).
+	 */
+	unsigned int cls;
+
+	/**
+	 * Incremented whenever the constraint stored in this node is removed;
+	 * stored in the handle to detect handles of removed constraints.
+	 */
+	unsigned int gen;
+};
+
+typedef struct linprog2d_dynamic_node linprog2d_dynamic_node_t;
+
+/**
+ * Internally used structure holding all the data associated with a dynamic
+ * constraint set.
+ */
+struct linprog2d_dynamic_data {
+	/**
+	 * Pool of nodes. There are two nodes per constraint.
+	 */
+	linprog2d_dynamic_node_t *nodes;
+
+	/**
+	 * Temporary memory used for rebuilding subtrees.
+	 */
+	unsigned int *tmp;
+
+	/**
+	 * Roots of the individual trees.
+	 */
+	unsigned int root[DYN_N_TREES];
+
+	/**
+	 * First element in the list of free nodes.
+	 */
+	unsigned int free;
+
+	/**
+	 * Number of constraints that are currently in the set and the number of
+	 * constraints that are always false.
+	 */
+	unsigned int n, n_false;
+
+	/**
+	 * Maximum number of constraints.
+	 */
+	unsigned int capacity;
+
+	/**
+	 * Number of low bits of a handle holding the node index; the remaining
+	 * bits hold the generation of the node.
+	 */
+	unsigned int index_bits;
+
+	/**
+	 * Rotation matrix aligning the gradient with the y-axis.
+	 */
+	struct mat22 R;
+
+	/**
+	 * Set to false whenever the constraint set changes.
+	 */
+	bool_t valid;
+
+	/**
+	 * Cached result.
+	 */
+	linprog2d_result_t result;
+};
+
+typedef struct linprog2d_dynamic_data linprog2d_dynamic_data_t;
+
+/**
+ * Returns true if the given node is a leaf.
+ */
+static bool_t dyn_is_leaf(const linprog2d_dynamic_node_t *nodes,
+                          unsigned int i) {
+	return nodes[i].left == DYN_NIL;
+}
+
+/**
+ * Removes a node from the free list. There must be a free node.
+ */
+static unsigned int dyn_alloc(linprog2d_dynamic_data_t *d) {
+	const unsigned int i = d->free;
+	d->free = d->nodes[i].left;
+	d->nodes[i].left = d->nodes[i].right = d->nodes[i].parent = DYN_NIL;
+	d->nodes[i].size = 1U;
+	d->nodes[i].cls = DYN_UNUSED;
+	return i;
+}
+
+/**
+ * Returns the given node to the free list.
+ */
+static void dyn_release(linprog2d_dynamic_data_t *d, unsigned int i) {
+	d->nodes[i].left = d->free;
+	d->nodes[i].size = 0U;
+	d->nodes[i].cls = DYN_UNUSED;
+	d->free = i;
+}
+
+/**
+ * Returns the leaf storing the line that forms the envelope of the subtree v
+ * at x. If x is exactly on a crossing point, tie_right selects the line on
+ * the right.
+ */
+static unsigned int dyn_find(const linprog2d_dynamic_node_t *nodes,
+                             unsigned int v, double x, bool_t tie_right) {
+	while (!dyn_is_leaf(nodes, v)) {
+		if (x < nodes[v].key || (x == nodes[v].key && !tie_right)) {
+			v = nodes[v].left;
+		} else {
+			v = nodes[v].right;
+		}
+	}
+	return v;
+}
+
+/**
+ * Evaluates the given line at x.
+ */
+static double dyn_line(const linprog2d_dynamic_node_t *nodes, unsigned int l,
+                       double x) {
+	return nodes[l].y0 + nodes[l].dx * x;
+}
+
+/**
+ * Evaluates the envelope of the subtree v at x.
+ */
+static double dyn_eval(const linprog2d_dynamic_node_t *nodes, unsigned int v,
+                       double x) {
+	return dyn_line(nodes, dyn_find(nodes, v, x, FALSE), x);
+}
+
+/**
+ * Computes the x-coordinate at which the envelope of the subtree a crosses the
+ * envelope of the subtree b. All slopes in a must be smaller than or equal to
+ * the slopes in b, so the difference between the two envelopes is monotonically
+ * decreasing. First finds the line in a that is active at the crossing point,
+ * then the corresponding line in b. Runs in O(log^2 n).
+ */
+static double dyn_crossing(const linprog2d_dynamic_node_t *nodes,
+                           unsigned int a, unsigned int b) {
+	const unsigned int a_root = a, b_root = b;
+	double k;
+
+	while (!dyn_is_leaf(nodes, a)) {
+		k = nodes[a].key;
+		if (k >= HUGE_VAL) {
+			a = nodes[a].left;
+		} else if (k <= -HUGE_VAL) {
+			a = nodes[a].right;
+		} else if (dyn_eval(nodes, a_root, k) >= dyn_eval(nodes, b_root, k)) {
+			a = nodes[a].right; /* Crossing is right of k */
+		} else {
+			a = nodes[a].left; /* Crossing is left of k */
+		}
+	}
+
+	while (!dyn_is_leaf(nodes, b)) {
+		k = nodes[b].key;
+		if (k >= HUGE_VAL) {
+			b = nodes[b].left;
+		} else if (k <= -HUGE_VAL) {
+			b = nodes[b].right;
+		} else if (dyn_line(nodes, a, k) >= dyn_eval(nodes, b_root, k)) {
+			b = nodes[b].right;
+		} else {
+			b = nodes[b].left;
+		}
+	}
+
+	if (feq_(nodes[a].dx, nodes[b].dx)) {
+		return (nodes[a].y0 >= nodes[b].y0) ? HUGE_VAL : -HUGE_VAL;
+	}
+	return linprog2d_line_intersect(nodes[a].dx, nodes[a].y0, nodes[b].dx,
+	                                nodes[b].y0);
+}
+
+/**
+ * Returns true if the inner node v is out of balance and its subtree should
+ * be rebuilt.
+ */
+static bool_t dyn_unbalanced(const linprog2d_dynamic_node_t *nodes,
+                             unsigned int v) {
+	const unsigned int sl = nodes[nodes[v].left].size;
+	const unsigned int sr = nodes[nodes[v].right].size;
+	return 4U * ((sl > sr) ? sl : sr) > 3U * nodes[v].size;
+}
+
+/**
+ * Writes the leaves of the subtree v to tmp (in order) and releases all inner
+ * nodes. Returns the number of leaves.
+ */
+static unsigned int dyn_flatten(linprog2d_dynamic_data_t *d, unsigned int v,
+                                unsigned int *tmp) {
+	unsigned int l, r, n;
+	if (dyn_is_leaf(d->nodes, v)) {
+		tmp[0] = v;
+		return 1U;
+	}
+	l = d->nodes[v].left, r = d->nodes[v].right;
+	dyn_release(d, v);
+	n = dyn_flatten(d, l, tmp);
+	return n + dyn_flatten(d, r, tmp + n);
+}
+
+/**
+ * Builds a perfectly balanced tree from the given list of leaves and returns
+ * its root.
+ */
+static unsigned int dyn_build(linprog2d_dynamic_data_t *d,
+                              const unsigned int *leaves, unsigned int n) {
+	linprog2d_dynamic_node_t *nodes = d->nodes;
+	const unsigned int mid = n / 2U;
+	unsigned int v, l, r;
+	if (n == 1U) {
+		return leaves[0];
+	}
+	l = dyn_build(d, leaves, mid);
+	r = dyn_build(d, leaves + mid, n - mid);
+	v = dyn_alloc(d);
+	nodes[v].left = l, nodes[v].right = r;
+	nodes[l].parent = nodes[r].parent = v;
+	nodes[v].size = n;
+	nodes[v].split = nodes[leaves[mid]].dx;
+	nodes[v].key = dyn_crossing(nodes, l, r);
+	return v;
+}
+
+/**
+ * Replaces the child old of the node p with the node new. If p is DYN_NIL, new
+ * becomes the root of the tree.
+ */
+static void dyn_replace(linprog2d_dynamic_data_t *d, unsigned int tree,
+                        unsigned int p, unsigned int old, unsigned int new_) {
+	linprog2d_dynamic_node_t *nodes = d->nodes;
+	nodes[new_].parent = p;
+	if (p == DYN_NIL) {
+		d->root[tree] = new_;
+	} else if (nodes[p].left == old) {
+		nodes[p].left = new_;
+	} else {
+		nodes[p].right = new_;
+	}
+}
+
+/**
+ * Updates the subtree sizes and crossing points on the path from the inner
+ * node u to the root. Rebuilds the highest subtree on that path that is out of
+ * balance (partial rebuilding, as in scapegoat trees). This keeps the depth of
+ * the tree logarithmic, with amortised O(log n) nodes touched per update.
+ */
+static void dyn_fixup(linprog2d_dynamic_data_t *d, unsigned int tree,
+                      unsigned int u) {
+	linprog2d_dynamic_node_t *nodes = d->nodes;
+	unsigned int v, p, n, top = DYN_NIL;
+
+	for (v = u; v != DYN_NIL; v = nodes[v].parent) {
+		nodes[v].size = nodes[nodes[v].left].size + nodes[nodes[v].right].size;
+		if (dyn_unbalanced(nodes, v)) {
+			top = v;
+		}
+	}
+
+	if (top != DYN_NIL) {
+		p = nodes[top].parent;
+		n = dyn_flatten(d, top, d->tmp);
+		dyn_replace(d, tree, p, top, dyn_build(d, d->tmp, n));
+		u = p;
+	}
+
+	for (v = u; v != DYN_NIL; v = nodes[v].parent) {
+		nodes[v].key = dyn_crossing(nodes, nodes[v].left, nodes[v].right);
+	}
+}
+
+/**
+ * Inserts the leaf l into the given tree.
+ */
+static void dyn_tree_insert(linprog2d_dynamic_data_t *d, unsigned int tree,
+                            unsigned int l) {
+	linprog2d_dynamic_node_t *nodes = d->nodes;
+	unsigned int u, v = d->root[tree];
+
+	if (v == DYN_NIL) {
+		d->root[tree] = l;
+		return;
+	}
+
+	/* Descend to the leaf next to which the new line should be inserted */
+	while (!dyn_is_leaf(nodes, v)) {
+		v = (nodes[l].dx < nodes[v].split) ? nodes[v].left : nodes[v].right;
+	}
+
+	/* Replace the leaf with an inner node joining the old and the new leaf */
+	u = dyn_alloc(d);
+	dyn_replace(d, tree, nodes[v].parent, v, u);
+	if (nodes[l].dx < nodes[v].dx) {
+		nodes[u].left = l, nodes[u].right = v;
+	} else {
+		nodes[u].left = v, nodes[u].right = l;
+	}
+	nodes[u].split = nodes[nodes[u].right].dx;
+	nodes[v].parent = nodes[l].parent = u;
+	dyn_fixup(d, tree, u);
+}
+
+/**
+ * Removes the leaf l from the given tree. Does not release l itself.
+ */
+static void dyn_tree_remove(linprog2d_dynamic_data_t *d, unsigned int tree,
+                            unsigned int l) {
+	linprog2d_dynamic_node_t *nodes = d->nodes;
+	const unsigned int p = nodes[l].parent;
+	unsigned int g, s;
+
+	if (p == DYN_NIL) {
+		d->root[tree] = DYN_NIL;
+		return;
+	}
+
+	/* Replace the parent with the sibling of l */
+	s = (nodes[p].left == l) ? nodes[p].right : nodes[p].left;
+	g = nodes[p].parent;
+	dyn_replace(d, tree, g, p, s);
+	dyn_release(d, p);
+	dyn_fixup(d, tree, g);
+}
+
+static linprog2d_dynamic_t *linprog2d_dynamic_init_internal(
+    linprog2d_dynamic_data_t *d, unsigned int capacity, char *mem, double cx,
+    double cy) {
+	unsigned int i;
+	if (!d) {
+		return NULL;
+	}
+
+	/* Calculate the offsets for the individual arrays */
+	d->nodes = (linprog2d_dynamic_node_t *)mem_align64(mem, 0U);
+	d->tmp = (unsigned int *)mem_align64(
+	    d->nodes, sizeof(linprog2d_dynamic_node_t) * 2U * capacity);
+	d->capacity = capacity;
+	for (d->index_bits = 1U;
+	     d->index_bits < 32U && (2U * capacity - 1U) >> d->index_bits;
+	     d->index_bits++) {
+	}
+
+	/* Initially, all nodes are in the free list */
+	d->free = DYN_NIL;
+	for (i = 2U * capacity; i > 0U; i--) {
+		d->nodes[i - 1U].gen = 0U;
+		dyn_release(d, i - 1U);
+	}
+	for (i = 0U; i < DYN_N_TREES; i++) {
+		d->root[i] = DYN_NIL;
+	}
+	d->n = d->n_false = 0U;
+	d->R = mat22_rot(cx, cy);
+	d->valid = FALSE;
+	return d;
+}
+
+/**
+ * Returns the number of distinct generations a handle can encode. The
+ * generation is stored in the bits above the node index; the all-ones value is
+ * excluded so that no handle equals LINPROG2D_INVALID_HANDLE.
+ */
+static unsigned int dyn_n_generations(const linprog2d_dynamic_data_t *d) {
+	return (d->index_bits < 32U) ? (0xFFFFFFFFU >> d->index_bits) : 1U;
+}
+
+/**
+ * Converts the leaf l into a handle consisting of the index and generation of
+ * the node.
+ */
+static unsigned int dyn_handle(const linprog2d_dynamic_data_t *d,
+                               unsigned int l) {
+	return (d->index_bits < 32U) ? (l | (d->nodes[l].gen << d->index_bits))
+	                             : l;
+}
+
+/**
+ * Adds a constraint to the dynamic constraint set. Returns the handle of the
+ * leaf node representing the constraint, or DYN_NIL if the set is full.
+ */
+static unsigned int dyn_insert(linprog2d_dynamic_data_t *d, double Gx,
+                               double Gy, double h) {
+	linprog2d_dynamic_node_t *nodes = d->nodes;
+	const struct mat22 *R = &d->R;
+	double gx, gy, norm;
+	unsigned int l;
+
+	if (d->n >= d->capacity) {
+		return DYN_NIL;
+	}
+
+	/* Rotate and normalize the constraint */
+	gx = R->a11 * Gx + R->a12 * Gy;
+	gy = R->a21 * Gx + R->a22 * Gy;
+	l = dyn_alloc(d);
+	if (feq_(gx, 0.0) && feq_(gy, 0.0)) {
+		nodes[l].cls = (h <= 0.0) ? DYN_TRUE : DYN_FALSE;
+		d->n_false += (h <= 0.0) ? 0U : 1U;
+	} else {
+		norm = linprog2d_normalization_coeff(gx, gy);
+		gx /= norm, gy /= norm, h /= norm;
+		switch (linprog2d_constraint_category(gx, gy)) {
+			case CAT_VERT_LEFT:
+				nodes[l].cls = DYN_LEFT;
+				nodes[l].dx = 0.0, nodes[l].y0 = h / gx;
+				break;
+			case CAT_VERT_RIGHT:
+				nodes[l].cls = DYN_RIGHT;
+				nodes[l].dx = 0.0, nodes[l].y0 = -h / gx;
+				break;
+			case CAT_FLOOR:
+				nodes[l].cls = DYN_FLOOR;
+				nodes[l].dx = -gx / gy, nodes[l].y0 = h / gy;
+				break;
+			case CAT_CEIL:
+				nodes[l].cls = DYN_CEIL;
+				nodes[l].dx = gx / gy, nodes[l].y0 = -h / gy;
+				break;
+		}
+		dyn_tree_insert(d, nodes[l].cls, l);
+	}
+
+	d->n++;
+	d->valid = FALSE;
+	return dyn_handle(d, l);
+}
+
+/**
+ * Removes the constraint with the given handle from the dynamic constraint
+ * set. Returns false if the handle is invalid, including handles of
+ * constraints that have already been removed.
+ */
+static bool_t dyn_remove(linprog2d_dynamic_data_t *d, unsigned int handle) {
+	linprog2d_dynamic_node_t *nodes = d->nodes;
+	const unsigned int l =
+	    (d->index_bits < 32U) ? (handle & ((1U << d->index_bits) - 1U))
+	                          : handle;
+	if (l >= 2U * d->capacity || nodes[l].size != 1U ||
+	    nodes[l].cls == DYN_UNUSED || dyn_handle(d, l) != handle) {
+		return FALSE;
+	}
+	if (nodes[l].cls < DYN_N_TREES) {
+		dyn_tree_remove(d, nodes[l].cls, l);
+	} else if (nodes[l].cls == DYN_FALSE) {
+		d->n_false--;
+	}
+	nodes[l].gen = (nodes[l].gen + 1U) % dyn_n_generations(d);
+	dyn_release(d, l);
+	d->n--;
+	d->valid = FALSE;
+	return TRUE;
+}
+
+/**
+ * Computes the extremum of the envelope stored in the given tree at x, as well
+ * as the slopes of the lines passing through the extremum. If negate is true,
+ * the tree stores negated lines and the minimum of the original lines is
+ * computed.
+ */
+static struct linprog2d_extremum dyn_extremum(
+    const linprog2d_dynamic_node_t *nodes, unsigned int root, double x,
+    bool_t negate) {
+	struct linprog2d_extremum e;
+	unsigned int l, r;
+	e.valid = root != DYN_NIL;
+	if (!e.valid) {
+		e.y = negate ? HUGE_VAL : -HUGE_VAL;
+		e.min_dx = HUGE_VAL, e.max_dx = -HUGE_VAL;
+		return e;
+	}
+	l = dyn_find(nodes, root, x, FALSE);
+	r = dyn_find(nodes, root, x, TRUE);
+	if (negate) {
+		e.y = -dyn_line(nodes, l, x);
+		e.min_dx = -nodes[r].dx, e.max_dx = -nodes[l].dx;
+	} else {
+		e.y = dyn_line(nodes, l, x);
+		e.min_dx = nodes[l].dx, e.max_dx = nodes[r].dx;
+	}
+	return e;
+}
+
+/**
+ * Determines where the optimum is w.r.t. x; see linprog2d_locate_optimum().
+ */
+static int dyn_locate(const linprog2d_dynamic_data_t *d, double x, double *y) {
+	struct linprog2d_extremum e_ceil, e_floor;
+	e_ceil = dyn_extremum(d->nodes, d->root[DYN_CEIL], x, TRUE);
+	e_floor = dyn_extremum(d->nodes, d->root[DYN_FLOOR], x, FALSE);
+	return linprog2d_locate_optimum_from_extrema(&e_ceil, &e_floor, y);
+}
+
+/* Returned by dyn_descend() if the descent reached a leaf */
+#define DYN_LOC_LEAF 5
+
+/**
+ * Descends the tree v towards the optimum. Narrows the interval [lo, hi]
+ * containing the optimum until only a single line of the tree is active in the
+ * interval and writes this line to leaf. Aborts early if the optimum is found
+ * at one of the crossing points x or the problem is infeasible, and returns
+ * the corresponding LOC_* code.
+ */
+static int dyn_descend(const linprog2d_dynamic_data_t *d, unsigned int v,
+                       double *lo, double *hi, double *x, double *y,
+                       unsigned int *leaf) {
+	const linprog2d_dynamic_node_t *nodes = d->nodes;
+	double k;
+	int loc;
+	while (v != DYN_NIL && !dyn_is_leaf(nodes, v)) {
+		k = nodes[v].key;
+		if (k <= *lo) {
+			v = nodes[v].right;
+		} else if (k >= *hi) {
+			v = nodes[v].left;
+		} else {
+			switch (loc = dyn_locate(d, k, y)) {
+				case LOC_LEFT:
+					*hi = k, v = nodes[v].left;
+					break;
+				case LOC_RIGHT:
+					*lo = k, v = nodes[v].right;
+					break;
+				default:
+					*x = k;
+					return loc;
+			}
+		}
+	}
+	*leaf = v;
+	return DYN_LOC_LEAF;
+}
+
+/**
+ * Searches the boundary of the interval in [lo, hi] in which the ceiling is
+ * above y. If search_right is true, the ceiling must be above y at lo,
+ * otherwise at hi.
+ */
+static double dyn_ceil_bound(const linprog2d_dynamic_node_t *nodes,
+                             unsigned int root, double y, double lo, double hi,
+                             bool_t search_right) {
+	unsigned int v = root;
+	double k, dx, y0;
+	while (!dyn_is_leaf(nodes, v)) {
+		k = nodes[v].key;
+		if (k <= lo) {
+			v = nodes[v].right;
+		} else if (k >= hi) {
+			v = nodes[v].left;
+		} else if ((-dyn_eval(nodes, root, k) >= y) == search_right) {
+			lo = k, v = nodes[v].right;
+		} else {
+			hi = k, v = nodes[v].left;
+		}
+	}
+
+	/* Intersect the remaining ceiling with the horizontal line */
+	dx = -nodes[v].dx, y0 = -nodes[v].y0;
+	if (search_right) {
+		return (dx < 0.0) ? fmin_(hi, (y - y0) / dx) : hi;
+	}
+	return (dx > 0.0) ? fmax_(lo, (y - y0) / dx) : lo;
+}
+
+/**
+ * Creates the result for an edge or a point at height y between l and r.
+ */
+static linprog2d_result_t dyn_result_edge(const struct mat22 *R, double l,
+                                          double r, double y) {
+	const struct vec2 o = vec2_create(0.0, 0.0);
+	if ((l <= -HUGE_VAL) || (r >= HUGE_VAL)) {
+		return linprog2d_result_unbounded();
+	} else if (feq_(l, r)) {
+		return linprog2d_result_point(R, &o, l, y);
+	}
+	return linprog2d_result_edge(R, &o, l, y, r, y);
+}
+
+/**
+ * We know that the optimum is an edge formed by the horizontal floor line
+ * active at x. Computes the extent of the edge; this is the dynamic
+ * counterpart to linprog2d_calculate_edge().
+ */
+static linprog2d_result_t dyn_calculate_edge(const linprog2d_dynamic_data_t *d,
+                                             double x, double x0, double x1) {
+	const linprog2d_dynamic_node_t *nodes = d->nodes;
+	const unsigned int c = d->root[DYN_CEIL];
+	unsigned int v = d->root[DYN_FLOOR];
+	double y;
+
+	/* Compute the interval in which the floor line is active */
+	while (!dyn_is_leaf(nodes, v)) {
+		if (x <= nodes[v].key) {
+			x1 = fmin_(x1, nodes[v].key), v = nodes[v].left;
+		} else {
+			x0 = fmax_(x0, nodes[v].key), v = nodes[v].right;
+		}
+	}
+	y = dyn_line(nodes, v, x);
+
+	/* Restrict the interval to the region in which the ceiling is above the
+	   floor */
+	if (c != DYN_NIL) {
+		x0 = dyn_ceil_bound(nodes, c, y, x0, x, FALSE);
+		x1 = dyn_ceil_bound(nodes, c, y, x, x1, TRUE);
+	}
+	return dyn_result_edge(&d->R, x0, x1, y);
+}
+
+/**
+ * Computes the optimum for a single remaining floor and ceil line in the
+ * interval [x0, x1]; this is the dynamic counterpart to
+ * linprog2d_calculate_result().
+ */
+static linprog2d_result_t dyn_calculate_result(const linprog2d_dynamic_data_t *d,
+                                               unsigned int f, unsigned int c,
+                                               double x0, double x1) {
+	const linprog2d_dynamic_node_t *nodes = d->nodes;
+	const struct vec2 o = vec2_create(0.0, 0.0);
+	const double fdx = nodes[f].dx, fy0 = nodes[f].y0;
+	double cdx, cy0;
+
+	/* Intersect the floor with the ceiling and adapt the interval */
+	if (c != DYN_NIL) {
+		cdx = -nodes[c].dx, cy0 = -nodes[c].y0;
+		if (!feq_(fdx, cdx)) {
+			if (fdx > cdx) {
+				x1 = fmin_(x1, linprog2d_line_intersect(fdx, fy0, cdx, cy0));
+			} else {
+				x0 = fmax_(x0, linprog2d_line_intersect(fdx, fy0, cdx, cy0));
+			}
+		} else if (!feq_(fy0, cy0) && fy0 > cy0) {
+			return linprog2d_result_infeasible();
+		}
+		if (x0 > x1 && !feq_(x0, x1)) {
+			return linprog2d_result_infeasible();
+		}
+	}
+
+	/* Return the lowest point on the floor */
+	if (feq_(fdx, 0.0)) {
+		return dyn_result_edge(&d->R, x0, x1, fy0);
+	} else if (fdx > 0.0) {
+		if (x0 <= -HUGE_VAL) {
+			return linprog2d_result_unbounded();
+		}
+		return linprog2d_result_point(&d->R, &o, x0, fy0 + fdx * x0);
+	} else {
+		if (x1 >= HUGE_VAL) {
+			return linprog2d_result_unbounded();
+		}
+		return linprog2d_result_point(&d->R, &o, x1, fy0 + fdx * x1);
+	}
+}
+
+/**
+ * Computes the optimum of the current dynamic constraint set. First narrows
+ * the interval containing the optimum by descending the floor tree, then by
+ * descending the ceil tree. Each step of the descent evaluates the location of
+ * the optimum at a crossing point, which takes O(log n), so the entire
+ * function runs in O(log^2 n).
+ */
+static linprog2d_result_t dyn_solve(const linprog2d_dynamic_data_t *d) {
+	const linprog2d_dynamic_node_t *nodes = d->nodes;
+	const struct vec2 o = vec2_create(0.0, 0.0);
+	unsigned int f = DYN_NIL, c = DYN_NIL;
+	double x0 = -HUGE_VAL, x1 = HUGE_VAL, lo, hi, x = 0.0, y = 0.0;
+	int loc;
+
+	/* The gradient must not be zero */
+	if (d->R.a11 != d->R.a11) {
+		return linprog2d_result_err();
+	}
+
+	/* Check for constraints that are always false */
+	if (d->n_false > 0U) {
+		return linprog2d_result_infeasible();
+	}
+
+	/* Compute the left and right boundary */
+	if (d->root[DYN_LEFT] != DYN_NIL) {
+		x0 = dyn_eval(nodes, d->root[DYN_LEFT], 0.0);
+	}
+	if (d->root[DYN_RIGHT] != DYN_NIL) {
+		x1 = -dyn_eval(nodes, d->root[DYN_RIGHT], 0.0);
+	}
+	if (x0 > x1) {
+		return linprog2d_result_infeasible();
+	}
+
+	/* There is no floor constraint. The problem is unbounded. */
+	if (d->root[DYN_FLOOR] == DYN_NIL) {
+		return linprog2d_result_unbounded();
+	}
+
+	/* Narrow down the location of the optimum */
+	lo = x0, hi = x1;
+	loc = dyn_descend(d, d->root[DYN_FLOOR], &lo, &hi, &x, &y, &f);
+	if (loc == DYN_LOC_LEAF) {
+		loc = dyn_descend(d, d->root[DYN_CEIL], &lo, &hi, &x, &y, &c);
+	}
+	switch (loc) {
+		case LOC_INFEASIBLE:
+			return linprog2d_result_infeasible();
+		case LOC_HERE:
+			return linprog2d_result_point(&d->R, &o, x, y);
+		case LOC_HERE_EDGE:
+			return dyn_calculate_edge(d, x, x0, x1);
+	}
+	return dyn_calculate_result(d, f, c, lo, hi);
+}
+
+/******************************************************************************
+ * Sliding windows                                                            *
+ ******************************************************************************/
+
+/**
+ * Internally used structure holding all the data associated with a sliding
+ * window. The window is a ring buffer of handles into a dynamic constraint
+ * set; pushing a constraint into a full window removes the oldest constraint
+ * from the set.
+ */
+struct linprog2d_window_data {
+	/**
+	 * Dynamic constraint set holding the constraints in the window.
+	 */
+	linprog2d_dynamic_data_t dyn;
+
+	/**
+	 * Ring buffer containing the handles of the constraints in the window in
+	 * the order in which they were pushed.
+	 */
+	unsigned int *handles;
+
+	/**
+	 * Index of the oldest entry in the ring buffer and number of entries.
+	 */
+	unsigned int head, len;
+
+	/**
+	 * Maximum number of constraints in the window.
+	 */
+	unsigned int width;
+};
+
+typedef struct linprog2d_window_data linprog2d_window_data_t;
+
+static linprog2d_window_t *linprog2d_window_init_internal(
+    linprog2d_window_data_t *w, unsigned int width, char *mem, double cx,
+    double cy) {
+	if (!w) {
+		return NULL;
+	}
+
+	/* The ring buffer is followed by the memory of the dynamic set */
+	w->handles = (unsigned int *)mem_align64(mem, 0U);
+	if (!linprog2d_dynamic_init_internal(&w->dyn, width,
+	                                     (char *)(w->handles + width), cx, cy)) {
+		return NULL;
+	}
+	w->head = w->len = 0U;
+	w->width = width;
+	return w;
+}
+
+/**
+ * Adds a constraint to the window. If the window is full, the oldest
+ * constraint is removed first.
+ */
+static void linprog2d_window_push_internal(linprog2d_window_data_t *w,
+                                           double Gx, double Gy, double h) {
+	unsigned int tail;
+	if (w->width == 0U) {
+		return;
+	}
+	if (w->len == w->width) {
+		dyn_remove(&w->dyn, w->handles[w->head]);
+		w->head = (w->head + 1U == w->width) ? 0U : w->head + 1U;
+		w->len--;
+	}
+	tail = w->head + w->len;
+	tail = (tail >= w->width) ? tail - w->width : tail;
+	w->handles[tail] = dyn_insert(&w->dyn, Gx, Gy, h);
+	w->len++;
+}
+
+/******************************************************************************
+ * Kinetic problems                                                           *
+ ******************************************************************************/
+
+/* Index representing the absence of a basis constraint */
+#define KIN_NIL 0xFFFFFFFFU
+
+/* Relative tolerance used when deciding whether a constraint is tight */
+#define KIN_EPS 1e-9
+
+/**
+ * Optimal basis of a kinetic problem. The basis consists of the two constraints
+ * i, j passing through the optimal vertex p(t) = p0 + p1 * t. The gradient is
+ * a non-negative combination c = li * G[i] + lj * G[j] of the basis normals.
+ */
+struct linprog2d_kinetic_basis {
+	unsigned int i, j;
+	struct vec2 p0, p1;
+	double li, lj;
+};
+
+/**
+ * Internally used structure holding all the data associated with a kinetic
+ * problem. As long as the optimum is a single vertex, the optimal basis is
+ * tracked and only changes whenever a constraint not in the basis becomes
+ * violated (an "event"). At each event, a single dual simplex pivot is
+ * performed. In all other cases the problem is solved from scratch using the
+ * embedded solver.
+ */
+struct linprog2d_kinetic_data {
+	/**
+	 * Solver used whenever the optimal basis is unknown.
+	 */
+	linprog2d_data_t solver;
+
+	/**
+	 * Constraints Gx[i] * x + Gy[i] * y >= h[i] + v[i] * t and temporary
+	 * memory holding the offsets at a specific point in time.
+	 */
+	double *Gx, *Gy, *h, *v, *ht;
+
+	/**
+	 * Gradient that should be minimized.
+	 */
+	double cx, cy;
+
+	/**
+	 * Time of the last query and time of the next event.
+	 */
+	double t, t_next;
+
+	/**
+	 * Current optimal basis. Only valid if has_basis is true.
+	 */
+	struct linprog2d_kinetic_basis basis;
+
+	/**
+	 * Constraint that becomes violated at t_next.
+	 */
+	unsigned int k_next;
+
+	/**
+	 * Number of constraints in the current problem and maximum number of
+	 * constraints.
+	 */
+	unsigned int n, capacity;
+
+	/**
+	 * Number of events processed since the problem was prepared. Used for
+	 * testing.
+	 */
+	unsigned int n_events;
+
+	/**
+	 * True if the optimum at time t is a single vertex with known basis.
+	 */
+	bool_t has_basis;
+};
+
+typedef struct linprog2d_kinetic_data linprog2d_kinetic_data_t;
+
+static linprog2d_kinetic_t *linprog2d_kinetic_init_internal(
+    linprog2d_kinetic_data_t *d, unsigned int capacity, char *mem) {
+#define SD sizeof(double)
+	if (!d) {
+		return NULL;
+	}
+
+	/* The constraint arrays are followed by the memory of the solver */
+	d->Gx = (double *)mem_align64(mem, 0U);
+	d->Gy = (double *)mem_align64(d->Gx, SD * capacity);
+	d->h = (double *)mem_align64(d->Gy, SD * capacity);
+	d->v = (double *)mem_align64(d->h, SD * capacity);
+	d->ht = (double *)mem_align64(d->v, SD * capacity);
+	if (!linprog2d_init_internal(&d->solver, capacity,
+	                             (char *)(d->ht + capacity))) {
+		return NULL;
+	}
+	d->capacity = capacity;
+	d->n = d->n_events = 0U;
+	d->t = d->t_next = 0.0;
+	d->has_basis = FALSE;
+	return d;
+#undef SD
+}
+
+/**
+ * Returns true if constraint k is violated by more than the tolerance at the
+ * point (x, y) at time t.
+ */
+static bool_t kin_violated(const linprog2d_kinetic_data_t *d, unsigned int k,
+                           double x, double y, double t) {
+	const double ht = d->h[k] + d->v[k] * t;
+	const double s = d->Gx[k] * x + d->Gy[k] * y - ht;
+	return s < -KIN_EPS * (1.0 + fabs(ht) + fabs(d->Gx[k] * x) +
+	                       fabs(d->Gy[k] * y));
+}
+
+/**
+ * Computes the vertex and the Lagrange multipliers for the basis consisting
+ * of the constraints i and j. Returns false if the two constraints are
+ * parallel or the gradient is not strictly inside the cone spanned by the two
+ * constraint normals, i.e. the basis is not optimal or the optimum is an edge.
+ */
+static bool_t kin_basis(const linprog2d_kinetic_data_t *d, unsigned int i,
+                        unsigned int j, struct linprog2d_kinetic_basis *b) {
+	const double a11 = d->Gx[i], a12 = d->Gy[i];
+	const double a21 = d->Gx[j], a22 = d->Gy[j];
+	const double det = a11 * a22 - a12 * a21;
+	if (feq_(a11 * a22, a12 * a21)) {
+		return FALSE;
+	}
+
+	/* Solve [Gi; Gj] p = h_B + v_B * t for p0 and p1 */
+	b->i = i, b->j = j;
+	b->p0 = vec2_create((a22 * d->h[i] - a12 * d->h[j]) / det,
+	                    (a11 * d->h[j] - a21 * d->h[i]) / det);
+	b->p1 = vec2_create((a22 * d->v[i] - a12 * d->v[j]) / det,
+	                    (a11 * d->v[j] - a21 * d->v[i]) / det);
+
+	/* Solve [Gi; Gj]^T (li, lj) = c */
+	b->li = (a22 * d->cx - a21 * d->cy) / det;
+	b->lj = (a11 * d->cy - a12 * d->cx) / det;
+	return (b->li > KIN_EPS * (fabs(b->li) + fabs(b->lj))) &&
+	       (b->lj > KIN_EPS * (fabs(b->li) + fabs(b->lj)));
+}
+
+/**
+ * Computes the time of the next event for the current basis, i.e. the first
+ * time t_next >= t at which a constraint not in the basis becomes violated.
+ * A constraint that is already violated at t is an event at t.
+ */
+static void kin_find_next_event(linprog2d_kinetic_data_t *d) {
+	const struct linprog2d_kinetic_basis *b = &d->basis;
+	const double x = b->p0.x + b->p1.x * d->t, y = b->p0.y + b->p1.y * d->t;
+	double s0, s1, te;
+	unsigned int k;
+
+	d->t_next = HUGE_VAL;
+	d->k_next = KIN_NIL;
+	for (k = 0U; k < d->n; k++) {
+		if (k == b->i || k == b->j) {
+			continue;
+		}
+
+		/* The slack s0 + s1 * t of constraint k is linear in t */
+		s1 = d->Gx[k] * b->p1.x + d->Gy[k] * b->p1.y - d->v[k];
+		if (kin_violated(d, k, x, y, d->t)) {
+			te = d->t;
+		} else if (s1 < 0.0) {
+			s0 = d->Gx[k] * b->p0.x + d->Gy[k] * b->p0.y - d->h[k];
+			te = fmax_(d->t, -s0 / s1);
+		} else {
+			continue;
+		}
+		if (te < d->t_next) {
+			d->t_next = te, d->k_next = k;
+		}
+	}
+}
+
+/**
+ * Performs a dual simplex pivot at time t: constraint k enters the basis, one
+ * of the current basis constraints leaves it. Returns false if there is no
+ * unique pivot or the leaving constraint is violated at the new vertex, in
+ * which case the problem either becomes infeasible or degenerate.
+ */
+static bool_t kin_pivot(linprog2d_kinetic_data_t *d, unsigned int k,
+                        double t) {
+	struct linprog2d_kinetic_basis b1, b2;
+	const bool_t ok1 = kin_basis(d, k, d->basis.j, &b1);
+	const bool_t ok2 = kin_basis(d, d->basis.i, k, &b2);
+	const struct linprog2d_kinetic_basis *b = ok1 ? &b1 : &b2;
+	if (ok1 == ok2 || kin_violated(d, ok1 ? d->basis.i : d->basis.j,
+	                               b->p0.x + b->p1.x * t,
+	                               b->p0.y + b->p1.y * t, t)) {
+		return FALSE;
+	}
+	d->basis = *b;
+	d->n_events++;
+	return TRUE;
+}
+
+/**
+ * Searches the two constraints passing through the point (x, y) at time t that
+ * form an optimal basis. Among the constraints that are tight at (x, y), picks
+ * the normals closest to the gradient on either side.
+ */
+static bool_t kin_find_basis(linprog2d_kinetic_data_t *d, double x, double y) {
+	const double cn = hypot_(d->cx, d->cy);
+	double cos_l = -HUGE_VAL, cos_r = -HUGE_VAL, s, tol, cs, cr;
+	unsigned int k, kl = KIN_NIL, kr = KIN_NIL;
+	for (k = 0U; k < d->n; k++) {
+		s = d->Gx[k] * x + d->Gy[k] * y - d->ht[k];
+		tol = KIN_EPS * (1.0 + fabs(d->ht[k]) + fabs(d->Gx[k] * x) +
+		                 fabs(d->Gy[k] * y));
+		if (fabs(s) > tol) {
+			continue;
+		}
+		cs = (d->cx * d->Gx[k] + d->cy * d->Gy[k]) /
+		     (cn * hypot_(d->Gx[k], d->Gy[k]));
+		cr = d->cx * d->Gy[k] - d->cy * d->Gx[k];
+		if (cr > 0.0 && cs > cos_l) {
+			cos_l = cs, kl = k;
+		} else if (cr < 0.0 && cs > cos_r) {
+			cos_r = cs, kr = k;
+		}
+	}
+	return (kl != KIN_NIL) && (kr != KIN_NIL) && kin_basis(d, kl, kr, &d->basis);
+}
+
+/**
+ * Solves the problem at time t from scratch and tries to extract the optimal
+ * basis from the result.
+ */
+static linprog2d_result_t kin_rebase(linprog2d_kinetic_data_t *d, double t) {
+	linprog2d_result_t res;
+	unsigned int k;
+	for (k = 0U; k < d->n; k++) {
+		d->ht[k] = d->h[k] + d->v[k] * t;
+	}
+	res = linprog2d_solve_internal(&d->solver, d->cx, d->cy, d->Gx, d->Gy,
+	                               d->ht, d->n);
+	d->t = t;
+	d->has_basis =
+	    (res.status == LP2D_POINT) && kin_find_basis(d, res.x1, res.y1);
+	if (d->has_basis) {
+		kin_find_next_event(d);
+	}
+	return res;
+}
+
+/**
+ * Advances the kinetic problem to time t and returns the optimum. Processes
+ * all events between the last query and t. Falls back to solving the problem
+ * from scratch if t lies in the past, no basis is known, or a pivot fails.
+ */
+static linprog2d_result_t kin_advance(linprog2d_kinetic_data_t *d, double t) {
+	unsigned int n_pivots = 0U;
+	const struct linprog2d_kinetic_basis *b = &d->basis;
+	if (!d->has_basis || t < d->t) {
+		return kin_rebase(d, t);
+	}
+	while (d->t_next <= t) {
+		/* Guard against cycling in degenerate vertices */
+		if (n_pivots++ > d->n || !kin_pivot(d, d->k_next, d->t_next)) {
+			return kin_rebase(d, t);
+		}
+		d->t = d->t_next;
+		kin_find_next_event(d);
+	}
+	d->t = t;
+	return linprog2d_result_create(LP2D_POINT, b->p0.x + b->p1.x * t,
+	                               b->p0.y + b->p1.y * t, 0.0, 0.0);
+}
+
+/**
+ * Copies the given kinetic problem into the instance and solves it at time t.
+ */
+static bool_t kin_prepare(linprog2d_kinetic_data_t *d, double cx, double cy,
+                          const double *Gx, const double *Gy, const double *h,
+                          const double *v, unsigned int n, double t) {
+	unsigned int k;
+	if (n > d->capacity) {
+		return FALSE;
+	}
+	for (k = 0U; k < n; k++) {
+		d->Gx[k] = Gx[k], d->Gy[k] = Gy[k], d->h[k] = h[k], d->v[k] = v[k];
+	}
+	d->cx = cx, d->cy = cy;
+	d->n = n;
+	d->n_events = 0U;
+	kin_rebase(d, t);
+	return TRUE;
+}
+
+/******************************************************************************
+ * Random sampling for very large problems                                    *
+ ******************************************************************************/
+
+/* Half-width of the bounding box added to each sampled subproblem */
+#define SMP_BOX 1e100
+
+/* Relative tolerance used when deciding whether a constraint is violated */
+#define SMP_EPS 1e-9
+
+/* Maximum number of subproblems solved before giving up */
+#define SMP_MAX_ROUNDS 64U
+
+/**
+ * Internally used structure holding all the data associated with a sampling
+ * solver. Following Clarkson, the optimum is computed for a working set
+ * consisting of a random sample R of about 2 sqrt(n) constraints and a set V
+ * of constraints that were found to be violated by an earlier subproblem.
+ * Each round performs one sequential pass over all n constraints to find the
+ * violators of the current optimum. The expected number of rounds is
+ * constant, while the working set, and thus the memory, is O(sqrt(n)).
+ */
+struct linprog2d_sampling_data {
+	/**
+	 * Solver used for the subproblems.
+	 */
+	linprog2d_data_t solver;
+
+	/**
+	 * Working set. The first four entries are the bounding box, followed by
+	 * the sample R and the violators V.
+	 */
+	double *Gx, *Gy, *h;
+
+	/**
+	 * Indices of the violators found by the last scan.
+	 */
+	unsigned int *idx;
+
+	/**
+	 * Callback used to scan for violators, or null for the sequential scan.
+	 */
+	linprog2d_scanner_t scanner;
+	void *scanner_data;
+
+	/**
+	 * Maximum number of constraints in a problem and in the working set.
+	 */
+	unsigned int capacity, width;
+
+	/**
+	 * Number of subproblems solved during the last call to
+	 * linprog2d_sampling_solve(). Used for testing.
+	 */
+	unsigned int n_rounds;
+
+	/**
+	 * State of the pseudo random number generator used to draw the samples.
+	 */
+	unsigned long int rng;
+};
+
+typedef struct linprog2d_sampling_data linprog2d_sampling_data_t;
+
+/**
+ * Returns the smallest integer s with s * s >= n. Avoids ceil(), which the
+ * reduced interface does not otherwise depend on.
+ */
+static unsigned int smp_sqrt_ceil(unsigned int n) {
+	unsigned long int s = (unsigned long int)sqrt((double)n);
+	while (s * s < (unsigned long int)n) {
+		s++;
+	}
+	return (unsigned int)s;
+}
+
+/**
+ * Returns the size of the working set used for problems with the given
+ * capacity, excluding the bounding box.
+ */
+static unsigned int smp_width(unsigned int capacity) {
+	return 8U * smp_sqrt_ceil(capacity);
+}
+
+static linprog2d_sampling_t *linprog2d_sampling_init_internal(
+    linprog2d_sampling_data_t *d, unsigned int capacity, char *mem) {
+#define SD sizeof(double)
+	const unsigned int w = smp_width(capacity) + 4U;
+	if (!d) {
+		return NULL;
+	}
+
+	/* The working set is followed by the memory of the solver */
+	d->Gx = (double *)mem_align64(mem, 0U);
+	d->Gy = (double *)mem_align64(d->Gx, SD * w);
+	d->h = (double *)mem_align64(d->Gy, SD * w);
+	d->idx = (unsigned int *)mem_align64(d->h, SD * w);
+	if (!linprog2d_init_internal(&d->solver, w, (char *)(d->idx + w))) {
+		return NULL;
+	}
+	d->scanner = NULL;
+	d->scanner_data = NULL;
+	d->capacity = capacity;
+	d->width = w - 4U;
+	d->n_rounds = 0U;
+	d->rng = 2463534242UL;
+
+	/* Bounding box |x| <= SMP_BOX, |y| <= SMP_BOX */
+	d->Gx[0] = 1.0, d->Gy[0] = 0.0, d->h[0] = -SMP_BOX;
+	d->Gx[1] = -1.0, d->Gy[1] = 0.0, d->h[1] = -SMP_BOX;
+	d->Gx[2] = 0.0, d->Gy[2] = 1.0, d->h[2] = -SMP_BOX;
+	d->Gx[3] = 0.0, d->Gy[3] = -1.0, d->h[3] = -SMP_BOX;
+	return d;
+#undef SD
+}
+
+/**
+ * Returns a pseudo random integer in [0, n) using a 32-bit xorshift
+ * generator.
+ */
+static unsigned int smp_rand(linprog2d_sampling_data_t *d, unsigned int n) {
+	unsigned long int x = d->rng;
+	unsigned int i;
+	x ^= (x << 13) & 0xFFFFFFFFUL;
+	x ^= x >> 17;
+	x ^= (x << 5) & 0xFFFFFFFFUL;
+	i = (unsigned int)((double)x / 4294967296.0 * (double)n);
+	d->rng = x;
+	return (i < n) ? i : n - 1U;
+}
+
+/**
+ * Returns true if the point (x, y) violates the constraint
+ * Gx * x + Gy * y >= h by more than the tolerance.
+ */
+static bool_t smp_violated(double Gx, double Gy, double h, double x, double y) {
+	const double s = Gx * x + Gy * y - h;
+	return s < -SMP_EPS * (1.0 + fabs(h) + fabs(Gx * x) + fabs(Gy * y));
+}
+
+/**
+ * Finds the violators with index in [i0, i1); see linprog2d_violators_find().
+ */
+static unsigned int smp_violators_find(const linprog2d_violator_scan_t *scan,
+                                       unsigned int i0, unsigned int i1,
+                                       unsigned int *idx) {
+	const double *Gx = scan->Gx, *Gy = scan->Gy, *h = scan->h;
+	const linprog2d_result_t res = scan->res;
+	const bool_t edge = res.status == LP2D_EDGE;
+	unsigned int i, k = 0U;
+	for (i = i0; i < i1; i++) {
+		if (smp_violated(Gx[i], Gy[i], h[i], res.x1, res.y1) ||
+		    (edge && smp_violated(Gx[i], Gy[i], h[i], res.x2, res.y2))) {
+			idx[k++] = i;
+			if (k > scan->max_k) {
+				break;
+			}
+		}
+	}
+	return k;
+}
+
+/**
+ * Scans all n constraints and appends those violated by the result of the
+ * current subproblem to the working set, starting at index m. The scan stops
+ * as soon as more than max_k violators have been found; only the first max_k
+ * are appended. Returns the number of violators found.
+ */
+static unsigned int smp_find_violators(linprog2d_sampling_data_t *d,
+                                       linprog2d_result_t res,
+                                       const double *Gx, const double *Gy,
+                                       const double *h, unsigned int n,
+                                       unsigned int m, unsigned int max_k) {
+	linprog2d_violator_scan_t scan;
+	unsigned int i, k;
+	scan.Gx = Gx, scan.Gy = Gy, scan.h = h, scan.n = n;
+	scan.res = res, scan.max_k = max_k;
+	k = d->scanner ? d->scanner(d->scanner_data, &scan, d->idx)
+	               : smp_violators_find(&scan, 0U, n, d->idx);
+	for (i = 0U; i < k && i < max_k; i++) {
+		d->Gx[m + i] = Gx[d->idx[i]];
+		d->Gy[m + i] = Gy[d->idx[i]];
+		d->h[m + i] = h[d->idx[i]];
+	}
+	return k;
+}
+
+/**
+ * Returns true if the given result touches the bounding box.
+ */
+static bool_t smp_on_box(linprog2d_result_t res) {
+	double r = fmax_(fabs(res.x1), fabs(res.y1));
+	if (res.status == LP2D_EDGE) {
+		r = fmax_(r, fmax_(fabs(res.x2), fabs(res.y2)));
+	}
+	return r >= 0.5 * SMP_BOX;
+}
+
+/**
+ * Solves the given problem using Clarkson's random sampling scheme. Problems
+ * that fit into the working set are passed to the solver directly.
+ */
+static linprog2d_result_t smp_solve(linprog2d_sampling_data_t *d, double cx,
+                                    double cy, const double *Gx,
+                                    const double *Gy, const double *h,
+                                    unsigned int n) {
+	linprog2d_result_t res;
+	unsigned int s, r, i, k, m, max_k;
+	d->n_rounds = 0U;
+	if (n > d->capacity) {
+		return linprog2d_result_err();
+	}
+	if (n <= d->width) {
+		d->n_rounds = 1U;
+		return linprog2d_solve_internal(&d->solver, cx, cy, Gx, Gy, h, n);
+	}
+
+	/* Sample size and maximum number of violators added per round. The
+	   optimal basis consists of two constraints, so V is augmented at most
+	   twice before it contains the basis. */
+	s = smp_sqrt_ceil(n);
+	r = 2U * s;
+	m = 4U + r;
+	while (d->n_rounds < SMP_MAX_ROUNDS) {
+		/* Draw a new sample R in front of V */
+		for (i = 4U; i < 4U + r; i++) {
+			k = smp_rand(d, n);
+			d->Gx[i] = Gx[k], d->Gy[i] = Gy[k], d->h[i] = h[k];
+		}
+
+		/* Solve the subproblem; the bounding box ensures that there is an
+		   optimum against which violators can be determined */
+		d->n_rounds++;
+		res = linprog2d_solve_internal(&d->solver, cx, cy, d->Gx, d->Gy, d->h,
+		                               m);
+		if (res.status != LP2D_POINT && res.status != LP2D_EDGE) {
+			return res; /* Infeasible or error */
+		}
+
+		/* Add the violators to V if there are not too many of them,
+		   otherwise discard them */
+		max_k = 4U + d->width - m;
+		max_k = (max_k < 2U * s) ? max_k : 2U * s;
+		k = smp_find_violators(d, res, Gx, Gy, h, n, m, max_k);
+		if (k == 0U) {
+			return smp_on_box(res) ? linprog2d_result_unbounded() : res;
+		} else if (k <= max_k) {
+			m += k;
+		}
+	}
+	return linprog2d_result_err();
+}
+
+/******************************************************************************
+ * Lazy constraint generation                                                 *
+ ******************************************************************************/
+
+/* Number of consecutive rounds after which a slack oracle constraint is
+   dropped from the active set */
+#define CUT_MAX_AGE 4U
+
+/* Maximum number of oracle queries before giving up; only reached if dropped
+   constraints are generated again and again */
+#define CUT_MAX_ROUNDS 4096U
+
+/**
+ * Internally used structure holding all the data associated with a cutting
+ * plane solver. The solver maintains an active set of constraints, which
+ * initially consists of the bounding box used by the sampling solver and the
+ * constraints passed by the caller. Constraints returned by the separation
+ * oracle are appended to the active set until the oracle does not find any
+ * violated constraints. Oracle constraints that remain slack for CUT_MAX_AGE
+ * rounds are dropped again.
+ *
+ * The active set is stored as a kinetic problem that does not move. As long
+ * as the optimum is a single vertex, each round restarts from the optimal
+ * basis of the previous round and restores feasibility with dual simplex
+ * pivots; the active set is only solved from scratch if this fails.
+ */
+struct linprog2d_cutting_data {
+	/**
+	 * Active set and its optimal basis. The first four entries are the
+	 * bounding box.
+	 */
+	linprog2d_kinetic_data_t kin;
+
+	/**
+	 * Number of consecutive rounds each constraint of the active set has been
+	 * slack at the optimum.
+	 */
+	unsigned int *age;
+
+	/**
+	 * Maximum number of constraints in the active set, excluding the bounding
+	 * box.
+	 */
+	unsigned int capacity;
+
+	/**
+	 * Number of constraints in the active set after the last call to
+	 * linprog2d_cutting_solve(), excluding the bounding box, number of
+	 * times the oracle was queried, and number of times the active set was
+	 * solved from scratch. Used for testing.
+	 */
+	unsigned int n_active, n_rounds, n_solves;
+};
+
+typedef struct linprog2d_cutting_data linprog2d_cutting_data_t;
+
+static linprog2d_cutting_t *linprog2d_cutting_init_internal(
+    linprog2d_cutting_data_t *d, unsigned int capacity, char *mem) {
+	/* One additional entry ensures that the oracle can always be queried */
+	const unsigned int w = capacity + 5U;
+	linprog2d_kinetic_data_t *kin;
+	if (!d) {
+		return NULL;
+	}
+	kin = &d->kin;
+
+	/* The ages are followed by the memory of the active set */
+	d->age = (unsigned int *)mem_align64(mem, 0U);
+	if (!linprog2d_kinetic_init_internal(kin, w, (char *)(d->age + w))) {
+		return NULL;
+	}
+	d->capacity = capacity;
+	d->n_active = d->n_rounds = d->n_solves = 0U;
+
+	/* Bounding box |x| <= SMP_BOX, |y| <= SMP_BOX. The active set never
+	   moves, so all velocities v are zero. */
+	kin->Gx[0] = 1.0, kin->Gy[0] = 0.0, kin->h[0] = -SMP_BOX, kin->v[0] = 0.0;
+	kin->Gx[1] = -1.0, kin->Gy[1] = 0.0, kin->h[1] = -SMP_BOX, kin->v[1] = 0.0;
+	kin->Gx[2] = 0.0, kin->Gy[2] = 1.0, kin->h[2] = -SMP_BOX, kin->v[2] = 0.0;
+	kin->Gx[3] = 0.0, kin->Gy[3] = -1.0, kin->h[3] = -SMP_BOX, kin->v[3] = 0.0;
+	return d;
+}
+
+/**
+ * Queries the oracle at the point (x, y) and appends the returned constraints
+ * to the active set, starting at index m. Constraints that are not actually
+ * violated by (x, y) are discarded; this guarantees progress even if the
+ * oracle is inexact. Returns the number of constraints that were added.
+ */
+static unsigned int cut_separate(linprog2d_cutting_data_t *d, double x,
+                                 double y, unsigned int m,
+                                 linprog2d_oracle_t oracle, void *data) {
+	linprog2d_kinetic_data_t *kin = &d->kin;
+	const unsigned int max_k = d->capacity + 5U - m;
+	unsigned int i, k, n_added = 0U;
+	d->n_rounds++;
+	k = oracle(data, x, y, kin->Gx + m, kin->Gy + m, kin->h + m, max_k);
+	k = (k < max_k) ? k : max_k;
+	for (i = 0U; i < k; i++) {
+		if (smp_violated(kin->Gx[m + i], kin->Gy[m + i], kin->h[m + i], x,
+		                 y)) {
+			kin->Gx[m + n_added] = kin->Gx[m + i];
+			kin->Gy[m + n_added] = kin->Gy[m + i];
+			kin->h[m + n_added] = kin->h[m + i];
+			kin->v[m + n_added] = 0.0;
+			d->age[m + n_added] = 0U;
+			n_added++;
+		}
+	}
+	return n_added;
+}
+
+/**
+ * Ages the oracle constraints, starting at index m0, that are slack at the
+ * optimum res and removes those that have been slack for CUT_MAX_AGE rounds.
+ * Constraints in the optimal basis are tight and always kept. Returns the new
+ * size of the active set.
+ */
+static unsigned int cut_drop_slack(linprog2d_cutting_data_t *d,
+                                   linprog2d_result_t res, unsigned int m0) {
+	linprog2d_kinetic_data_t *kin = &d->kin;
+	const bool_t edge = res.status == LP2D_EDGE;
+	unsigned int i, m = m0;
+	for (i = m0; i < kin->n; i++) {
+		/* A constraint is slack if it is not tight at any end point */
+		if (smp_violated(-kin->Gx[i], -kin->Gy[i], -kin->h[i], res.x1,
+		                 res.y1) &&
+		    (!edge || smp_violated(-kin->Gx[i], -kin->Gy[i], -kin->h[i],
+		                           res.x2, res.y2))) {
+			d->age[i]++;
+		} else {
+			d->age[i] = 0U;
+		}
+		if (d->age[i] >= CUT_MAX_AGE &&
+		    !(kin->has_basis && (i == kin->basis.i || i == kin->basis.j))) {
+			continue;
+		}
+		if (kin->has_basis && i == kin->basis.i) {
+			kin->basis.i = m;
+		} else if (kin->has_basis && i == kin->basis.j) {
+			kin->basis.j = m;
+		}
+		kin->Gx[m] = kin->Gx[i], kin->Gy[m] = kin->Gy[i], kin->h[m] = kin->h[i];
+		d->age[m++] = d->age[i];
+	}
+	return m;
+}
+
+/**
+ * Solves the active set after constraints were appended. Starting from the
+ * previous optimal basis, the most violated constraint repeatedly enters the
+ * basis until the vertex is feasible. Falls back to solving the active set
+ * from scratch if there is no basis or a pivot fails.
+ */
+static linprog2d_result_t cut_resolve(linprog2d_cutting_data_t *d) {
+	linprog2d_kinetic_data_t *kin = &d->kin;
+	const struct linprog2d_kinetic_basis *b = &kin->basis;
+	unsigned int i, k, n_pivots = 0U;
+	double s, s_min;
+	while (kin->has_basis) {
+		/* Search the most violated constraint, relative to its norm */
+		k = KIN_NIL, s_min = 0.0;
+		for (i = 0U; i < kin->n; i++) {
+			if (!smp_violated(kin->Gx[i], kin->Gy[i], kin->h[i], b->p0.x,
+			                  b->p0.y)) {
+				continue;
+			}
+			s = (kin->Gx[i] * b->p0.x + kin->Gy[i] * b->p0.y - kin->h[i]) /
+			    hypot_(kin->Gx[i], kin->Gy[i]);
+			if (s < s_min) {
+				s_min = s, k = i;
+			}
+		}
+		if (k == KIN_NIL) {
+			return linprog2d_result_create(LP2D_POINT, b->p0.x, b->p0.y, 0.0,
+			                               0.0);
+		}
+
+		/* Guard against cycling in degenerate vertices */
+		if (n_pivots++ > kin->n || !kin_pivot(kin, k, 0.0)) {
+			break;
+		}
+	}
+	d->n_solves++;
+	return kin_rebase(kin, 0.0);
+}
+
+/**
+ * Solves the problem defined by the n initial constraints and the constraints
+ * generated by the oracle.
+ */
+static linprog2d_result_t cut_solve(linprog2d_cutting_data_t *d, double cx,
+                                    double cy, const double *Gx,
+                                    const double *Gy, const double *h,
+                                    unsigned int n, linprog2d_oracle_t oracle,
+                                    void *data) {
+	linprog2d_kinetic_data_t *kin = &d->kin;
+	linprog2d_result_t res;
+	unsigned int i, k, m = 4U + n;
+	d->n_active = d->n_rounds = d->n_solves = 0U;
+	if (n > d->capacity) {
+		return linprog2d_result_err();
+	}
+	for (i = 0U; i < n; i++) {
+		kin->Gx[4U + i] = Gx[i], kin->Gy[4U + i] = Gy[i], kin->h[4U + i] = h[i];
+		kin->v[4U + i] = 0.0;
+	}
+
+	/* Solve the initial active set; the bounding box ensures that there is an
+	   optimum at which the oracle can be queried */
+	kin->cx = cx, kin->cy = cy;
+	kin->n = m;
+	kin->has_basis = FALSE;
+	res = cut_resolve(d);
+	while (TRUE) {
+		d->n_active = m - 4U;
+		if (res.status != LP2D_POINT && res.status != LP2D_EDGE) {
+			return res; /* Infeasible or error */
+		}
+
+		/* Make room for new constraints; only oracle constraints may be
+		   dropped, the oracle may not know the initial ones */
+		m = kin->n = cut_drop_slack(d, res, 4U + n);
+
+		/* Both end points of an edge must be feasible */
+		k = cut_separate(d, res.x1, res.y1, m, oracle, data);
+		if (k == 0U && res.status == LP2D_EDGE) {
+			k = cut_separate(d, res.x2, res.y2, m, oracle, data);
+		}
+		if (k == 0U) {
+			d->n_active = m - 4U;
+			return smp_on_box(res) ? linprog2d_result_unbounded() : res;
+		}
+
+		/* Abort if the active set exceeds the capacity */
+		m += k;
+		if (m > 4U + d->capacity || d->n_rounds >= CUT_MAX_ROUNDS) {
+			return linprog2d_result_err();
+		}
+		kin->n = m;
+		res = cut_resolve(d);
+	}
+}
+
+/******************************************************************************
+ * Result cache                                                               *
+ ******************************************************************************/
+
+/* Index representing the absence of a cache entry */
+#define CACHE_NIL 0xFFFFFFFFU
+
+/* Number of independent accumulators used when hashing the input arrays */
+#define CACHE_LANES 4U
+
+/**
+ * Internally used structure holding all the data associated with a result
+ * cache. Each entry stores a copy of the problem and its result, so hits can
+ * be verified against the full input. Entries are found through a chained
+ * hash table and evicted in least-recently-used order.
+ */
+struct linprog2d_cache_data {
+	/**
+	 * Solver used on a cache miss.
+	 */
+	linprog2d_data_t solver;
+
+	/**
+	 * Copies of the constraints of each entry. Entry e occupies the indices
+	 * [e * capacity, e * capacity + n[e]).
+	 */
+	double *Gx, *Gy, *h;
+
+	/**
+	 * Gradient of each entry.
+	 */
+	double *cx, *cy;
+
+	/**
+	 * Result of each entry.
+	 */
+	linprog2d_result_t *result;
+
+	/**
+	 * Hash and number of constraints of each entry.
+	 */
+	unsigned long int *hash;
+	unsigned int *n;
+
+	/**
+	 * Doubly linked list of the entries in order of their last use, and the
+	 * next entry in the same hash bucket.
+	 */
+	unsigned int *prev, *next, *chain;
+
+	/**
+	 * First entry in each hash bucket. The number of buckets is mask + 1.
+	 */
+	unsigned int *buckets;
+	unsigned int mask;
+
+	/**
+	 * Most and least recently used entry.
+	 */
+	unsigned int head, tail;
+
+	/**
+	 * Maximum number of constraints per problem, maximum number of entries,
+	 * and number of used entries.
+	 */
+	unsigned int capacity, entries, len;
+
+	/**
+	 * Number of cache hits and misses.
+	 */
+	unsigned long int n_hits, n_misses;
+};
+
+typedef struct linprog2d_cache_data linprog2d_cache_data_t;
+
+/**
+ * Returns the number of hash buckets minus one for the given number of
+ * entries; the number of buckets is the smallest power of two not smaller than
+ * the number of entries.
+ */
+static unsigned int cache_mask(unsigned int entries) {
+	unsigned int mask = 1U;
+	while (mask < entries) {
+		mask *= 2U;
+	}
+	return mask - 1U;
+}
+
+static linprog2d_cache_t *linprog2d_cache_init_internal(
+    linprog2d_cache_data_t *d, unsigned int entries, unsigned int capacity,
+    char *mem) {
+#define SD sizeof(double)
+#define SU sizeof(unsigned int)
+	const unsigned long int pool = (unsigned long int)entries * capacity;
+	unsigned int i;
+	if (!d) {
+		return NULL;
+	}
+
+	/* The entries are followed by the memory of the solver */
+	d->mask = cache_mask(entries);
+	d->Gx = (double *)mem_align64(mem, 0U);
+	d->Gy = (double *)mem_align64(d->Gx, SD * pool);
+	d->h = (double *)mem_align64(d->Gy, SD * pool);
+	d->cx = (double *)mem_align64(d->h, SD * pool);
+	d->cy = (double *)mem_align64(d->cx, SD * entries);
+	d->result = (linprog2d_result_t *)mem_align64(d->cy, SD * entries);
+	d->hash = (unsigned long int *)mem_align64(
+	    d->result, sizeof(linprog2d_result_t) * entries);
+	d->n = (unsigned int *)mem_align64(d->hash,
+	                                   sizeof(unsigned long int) * entries);
+	d->prev = (unsigned int *)mem_align64(d->n, SU * entries);
+	d->next = (unsigned int *)mem_align64(d->prev, SU * entries);
+	d->chain = (unsigned int *)mem_align64(d->next, SU * entries);
+	d->buckets = (unsigned int *)mem_align64(d->chain, SU * entries);
+	if (!linprog2d_init_internal(&d->solver, capacity,
+	                             (char *)(d->buckets + d->mask + 1U))) {
+		return NULL;
+	}
+	for (i = 0U; i <= d->mask; i++) {
+		d->buckets[i] = CACHE_NIL;
+	}
+	d->head = d->tail = CACHE_NIL;
+	d->capacity = capacity;
+	d->entries = entries;
+	d->len = 0U;
+	d->n_hits = d->n_misses = 0UL;
+	return d;
+#undef SD
+#undef SU
+}
+
+/**
+ * Folds the bit pattern of the double x into the 32-bit hash value a.
+ */
+static unsigned long int cache_hash_step(unsigned long int a, double x) {
+	union {
+		double d;
+		unsigned int u[sizeof(double) / sizeof(unsigned int)];
+	} v;
+	unsigned int i;
+	v.d = x + 0.0; /* Map -0.0 to 0.0 */
+	for (i = 0U; i < sizeof(double) / sizeof(unsigned int); i++) {
+		a = ((a ^ v.u[i]) * 16777619UL) & 0xFFFFFFFFUL;
+	}
+	return a;
+}
+
+/**
+ * Computes the hash of the given problem. The arrays are hashed in blocks of
+ * CACHE_LANES elements with one independent accumulator per lane, such that
+ * the multiplications of different lanes can be executed in parallel.
+ */
+static unsigned long int cache_hash(double cx, double cy, const double *Gx,
+                                    const double *Gy, const double *h,
+                                    unsigned int n) {
+	unsigned long int acc[CACHE_LANES], res;
+	unsigned int i, j;
+	for (j = 0U; j < CACHE_LANES; j++) {
+		acc[j] = 2166136261UL + j;
+	}
+	for (i = 0U; i + CACHE_LANES <= n; i += CACHE_LANES) {
+		for (j = 0U; j < CACHE_LANES; j++) {
+			acc[j] = cache_hash_step(acc[j], Gx[i + j]);
+			acc[j] = cache_hash_step(acc[j], Gy[i + j]);
+			acc[j] = cache_hash_step(acc[j], h[i + j]);
+		}
+	}
+	for (; i < n; i++) {
+		acc[0] = cache_hash_step(acc[0], Gx[i]);
+		acc[0] = cache_hash_step(acc[0], Gy[i]);
+		acc[0] = cache_hash_step(acc[0], h[i]);
+	}
+
+	/* Combine the lanes with the gradient and the number of constraints */
+	res = cache_hash_step(cache_hash_step(2166136261UL ^ n, cx), cy);
+	for (j = 0U; j < CACHE_LANES; j++) {
+		res = ((res ^ acc[j]) * 16777619UL) & 0xFFFFFFFFUL;
+	}
+	return res;
+}
+
+/**
+ * Returns true if entry e stores exactly the given problem.
+ */
+static bool_t cache_equal(const linprog2d_cache_data_t *d, unsigned int e,
+                          double cx, double cy, const double *Gx,
+                          const double *Gy, const double *h, unsigned int n) {
+	const unsigned long int offs = (unsigned long int)e * d->capacity;
+	unsigned int i;
+	if (d->n[e] != n || d->cx[e] != cx || d->cy[e] != cy) {
+		return FALSE;
+	}
+	for (i = 0U; i < n; i++) {
+		if (d->Gx[offs + i] != Gx[i] || d->Gy[offs + i] != Gy[i] ||
+		    d->h[offs + i] != h[i]) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Removes entry e from the list of recently used entries.
+ */
+static void cache_unlink(linprog2d_cache_data_t *d, unsigned int e) {
+	if (d->prev[e] != CACHE_NIL) {
+		d->next[d->prev[e]] = d->next[e];
+	} else {
+		d->head = d->next[e];
+	}
+	if (d->next[e] != CACHE_NIL) {
+		d->prev[d->next[e]] = d->prev[e];
+	} else {
+		d->tail = d->prev[e];
+	}
+}
+
+/**
+ * Inserts entry e at the front of the list of recently used entries.
+ */
+static void cache_push_front(linprog2d_cache_data_t *d, unsigned int e) {
+	d->prev[e] = CACHE_NIL;
+	d->next[e] = d->head;
+	if (d->head != CACHE_NIL) {
+		d->prev[d->head] = e;
+	} else {
+		d->tail = e;
+	}
+	d->head = e;
+}
+
+/**
+ * Removes the least recently used entry from the cache and returns its index.
+ */
+static unsigned int cache_evict(linprog2d_cache_data_t *d) {
+	const unsigned int e = d->tail;
+	unsigned int *p = &d->buckets[d->hash[e] & d->mask];
+	while (*p != e) {
+		p = &d->chain[*p];
+	}
+	*p = d->chain[e];
+	cache_unlink(d, e);
+	return e;
+}
+
+/**
+ * Returns the cached result for the given problem or solves it and adds the
+ * result to the cache.
+ */
+static linprog2d_result_t cache_solve(linprog2d_cache_data_t *d, double cx,
+                                      double cy, const double *Gx,
+                                      const double *Gy, const double *h,
+                                      unsigned int n) {
+	unsigned long int hash, offs;
+	unsigned int e, i;
+	linprog2d_result_t res;
+	if (n > d->capacity) {
+		return linprog2d_result_err();
+	}
+
+	/* Look for the problem in the cache */
+	hash = cache_hash(cx, cy, Gx, Gy, h, n);
+	for (e = d->buckets[hash & d->mask]; e != CACHE_NIL; e = d->chain[e]) {
+		if (d->hash[e] == hash && cache_equal(d, e, cx, cy, Gx, Gy, h, n)) {
+			cache_unlink(d, e);
+			cache_push_front(d, e);
+			d->n_hits++;
+			return d->result[e];
+		}
+	}
+
+	/* Solve the problem. Errors are not cached. */
+	d->n_misses++;
+	res = linprog2d_solve_internal(&d->solver, cx, cy, Gx, Gy, h, n);
+	if (d->entries == 0U || res.status == LP2D_ERROR) {
+		return res;
+	}
+
+	/* Store the problem in an unused or the least recently used entry */
+	e = (d->len < d->entries) ? d->len++ : cache_evict(d);
+	offs = (unsigned long int)e * d->capacity;
+	for (i = 0U; i < n; i++) {
+		d->Gx[offs + i] = Gx[i], d->Gy[offs + i] = Gy[i], d->h[offs + i] = h[i];
+	}
+	d->cx[e] = cx, d->cy[e] = cy, d->n[e] = n;
+	d->hash[e] = hash;
+	d->result[e] = res;
+	d->chain[e] = d->buckets[hash & d->mask];
+	d->buckets[hash & d->mask] = e;
+	cache_push_front(d, e);
+	return res;
+}
+
+#ifdef LINPROG2D_CAPTURE
+/******************************************************************************
+ * Problem capture                                                            *
+ ******************************************************************************/
+
+/* Magic bytes at the beginning of each capture file */
+#define CAPTURE_MAGIC "LP2DCAP1"
+
+/* Size of the stdio buffer used for the capture file */
+#define CAPTURE_BUF_SIZE (1UL << 20)
+
+/* Sink all problems are passed to, or NULL if capture is disabled */
+static linprog2d_capture_sink_t capture_sink = NULL;
+static void *capture_sink_data = NULL;
+
+/* File opened by linprog2d_capture_start(), or NULL */
+static FILE *capture_file = NULL;
+
+/**
+ * Sink used by linprog2d_capture_start(). Appends a single problem to the
+ * capture file. Each record consists of the number of constraints n and the
+ * result status as unsigned int, followed by cx, cy, the result coordinates
+ * x1, y1, x2, y2, the solve time in seconds, and the arrays Gx, Gy, h as
+ * double, all in native byte order. The file stays locked while the record is
+ * written, so records of different threads are not interleaved.
+ */
+static void capture_write(void *data, const linprog2d_capture_record_t *rec) {
+	FILE *f = (FILE *)data;
+	unsigned int head[2];
+	double vals[7];
+	head[0] = rec->n, head[1] = (unsigned int)rec->res.status;
+	vals[0] = rec->cx, vals[1] = rec->cy;
+	vals[2] = rec->res.x1, vals[3] = rec->res.y1;
+	vals[4] = rec->res.x2, vals[5] = rec->res.y2;
+	vals[6] = rec->seconds;
+	flockfile(f);
+	fwrite(head, sizeof(unsigned int), 2U, f);
+	fwrite(vals, sizeof(double), 7U, f);
+	fwrite(rec->Gx, sizeof(double), rec->n, f);
+	fwrite(rec->Gy, sizeof(double), rec->n, f);
+	fwrite(rec->h, sizeof(double), rec->n, f);
+	funlockfile(f);
+}
+
+static double capture_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+#endif /* LINPROG2D_CAPTURE */
+
+#ifdef LINPROG2D_METRICS
+/******************************************************************************
+ * Metrics                                                                    *
+ ******************************************************************************/
+
+/* Number of size classes; class c holds sizes with c significant bits */
+#define METRICS_SIZE_CLASSES 33U
+
+/* Number of latency buckets; bucket b holds latencies in [2^b, 2^(b+1)) ns */
+#define METRICS_LATENCY_BUCKETS 40U
+
+/* Number of iteration buckets; the last bucket holds all larger counts */
+#define METRICS_ITER_BUCKETS 65U
+
+/**
+ * Counters of a single thread. Only the owning thread writes to its block,
+ * so the counters are updated without read-modify-write instructions; readers
+ * load them with relaxed atomics and add up all blocks. When a thread exits,
+ * its block is put on a free list and handed to the next thread that records
+ * metrics, which keeps counting on top of the existing counts. Blocks are
+ * never freed, so the counts of threads that have exited are retained, but
+ * there are only as many blocks as threads have recorded at the same time.
+ */
+struct metrics_block {
+	unsigned long int latency[METRICS_SIZE_CLASSES][METRICS_LATENCY_BUCKETS];
+	unsigned long int status[LP2D_POINT + 1];
+	unsigned long int iter[METRICS_ITER_BUCKETS];
+	unsigned long int created[METRICS_SIZE_CLASSES];
+	unsigned long int exceeded;
+	struct metrics_block *next, *next_free;
+};
+
+/* Block of the calling thread, list of all blocks, and list of the blocks of
+   exited threads. The mutex guards adding blocks and the free list. */
+static __thread struct metrics_block *metrics_local = NULL;
+static struct metrics_block *metrics_head = NULL;
+static struct metrics_block *metrics_free = NULL;
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Key whose destructor returns the block of an exiting thread */
+static pthread_key_t metrics_key;
+static pthread_once_t metrics_key_once = PTHREAD_ONCE_INIT;
+static int metrics_key_valid = 0;
+
+#define METRICS_INC(x) \
+	__atomic_store_n(&(x), __atomic_load_n(&(x), __ATOMIC_RELAXED) + 1UL, \
+	                 __ATOMIC_RELAXED)
+#define METRICS_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+static const char *metrics_status_names[LP2D_POINT + 1] = {
+    "error", "infeasible", "unbounded", "edge", "point"};
+
+/**
+ * Destructor of metrics_key; puts the block of the exiting thread on the free
+ * list.
+ */
+static void metrics_release(void *data) {
+	struct metrics_block *b = (struct metrics_block *)data;
+	metrics_local = NULL;
+	pthread_mutex_lock(&metrics_mutex);
+	b->next_free = metrics_free;
+	metrics_free = b;
+	pthread_mutex_unlock(&metrics_mutex);
+}
+
+static void metrics_key_create(void) {
+	metrics_key_valid = pthread_key_create(&metrics_key, metrics_release) == 0;
+}
+
+/**
+ * Returns the counter block of the calling thread. On first use, takes a
+ * block from the free list or registers a new one. Returns NULL if no memory
+ * is available.
+ */
+static struct metrics_block *metrics_block(void) {
+	struct metrics_block *b = metrics_local;
+	if (b) {
+		return b;
+	}
+	pthread_once(&metrics_key_once, metrics_key_create);
+	pthread_mutex_lock(&metrics_mutex);
+	if ((b = metrics_free)) {
+		metrics_free = b->next_free;
+	} else if ((b = (struct metrics_block *)calloc(
+	                1U, sizeof(struct metrics_block)))) {
+		b->next = metrics_head;
+		__atomic_store_n(&metrics_head, b, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&metrics_mutex);
+
+	/* Without the key, the block stays with the thread after it exits */
+	if (b && metrics_key_valid) {
+		pthread_setspecific(metrics_key, b);
+	}
+	return metrics_local = b;
+}
+
+/**
+ * Returns the number of significant bits in x, i.e. the index of the
+ * logarithmic bucket x falls into.
+ */
+static unsigned int metrics_log2(unsigned long int x) {
+	unsigned int b = 0U;
+	while (x) {
+		x >>= 1U, b++;
+	}
+	return b;
+}
+
+static double metrics_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static void metrics_record_solve(const linprog2d_data_t *prog, unsigned int n,
+                                 linprog2d_result_t res, double seconds) {
+	struct metrics_block *b = metrics_block();
+	unsigned int c = metrics_log2(n),
+	             l = metrics_log2((unsigned long int)(seconds * 1e9));
+	if (!b) {
+		return;
+	}
+	c = (c < METRICS_SIZE_CLASSES) ? c : METRICS_SIZE_CLASSES - 1U;
+	l = (l > 0U) ? l - 1U : 0U;
+	l = (l < METRICS_LATENCY_BUCKETS) ? l : METRICS_LATENCY_BUCKETS - 1U;
+	METRICS_INC(b->latency[c][l]);
+	METRICS_INC(b->status[res.status]);
+	if (!prog || prog->capacity < n) {
+		METRICS_INC(b->exceeded);
+	} else {
+		METRICS_INC(b->iter[(prog->n_iter < METRICS_ITER_BUCKETS)
+		                        ? prog->n_iter
+		                        : METRICS_ITER_BUCKETS - 1U]);
+	}
+}
+
+static void metrics_record_create(unsigned int capacity) {
+	struct metrics_block *b = metrics_block();
+	unsigned int c = metrics_log2(capacity);
+	if (b) {
+		METRICS_INC(
+		    b->created[(c < METRICS_SIZE_CLASSES) ? c
+		                                          : METRICS_SIZE_CLASSES - 1U]);
+	}
+}
+
+/**
+ * Adds up the counters of all threads. Returns the number of blocks.
+ */
+static unsigned int metrics_merge(struct metrics_block *sum) {
+	const struct metrics_block *b;
+	unsigned int i, j, n_threads = 0U;
+	for (b = __atomic_load_n(&metrics_head, __ATOMIC_ACQUIRE); b;
+	     b = b->next, n_threads++) {
+		for (i = 0U; i < METRICS_SIZE_CLASSES; i++) {
+			for (j = 0U; j < METRICS_LATENCY_BUCKETS; j++) {
+				sum->latency[i][j] += METRICS_LOAD(b->latency[i][j]);
+			}
+			sum->created[i] += METRICS_LOAD(b->created[i]);
+		}
+		for (i = 0U; i <= LP2D_POINT; i++) {
+			sum->status[i] += METRICS_LOAD(b->status[i]);
+		}
+		for (i = 0U; i < METRICS_ITER_BUCKETS; i++) {
+			sum->iter[i] += METRICS_LOAD(b->iter[i]);
+		}
+		sum->exceeded += METRICS_LOAD(b->exceeded);
+	}
+	return n_threads;
+}
+
+/**
+ * Smallest and largest value in the logarithmic class c.
+ */
+static unsigned long int metrics_class_min(unsigned int c) {
+	return c ? 1UL << (c - 1U) : 0UL;
+}
+
+static unsigned long int metrics_class_max(unsigned int c) {
+	return c ? (1UL << c) - 1UL : 0UL;
+}
+
+static void metrics_dump_json(FILE *f, const struct metrics_block *m,
+                              unsigned int n_threads) {
+	unsigned int i, j;
+	const char *sep = "";
+	fprintf(f, "{\n  \"threads\": %u,\n  \"status\": {", n_threads);
+	for (i = 0U; i <= LP2D_POINT; i++) {
+		fprintf(f, "%s\"%s\": %lu", i ? ", " : "", metrics_status_names[i],
+		        m->status[i]);
+	}
+	fprintf(f, "},\n  \"latency_ns\": [");
+	for (i = 0U; i < METRICS_SIZE_CLASSES; i++) {
+		const char *bsep = "";
+		for (j = 0U; j < METRICS_LATENCY_BUCKETS && !m->latency[i][j]; j++) {
+		}
+		if (j == METRICS_LATENCY_BUCKETS) {
+			continue;
+		}
+		fprintf(f, "%s\n    {\"n_min\": %lu, \"n_max\": %lu, \"buckets\": [",
+		        sep, metrics_class_min(i), metrics_class_max(i));
+		for (; j < METRICS_LATENCY_BUCKETS; j++) {
+			if (m->latency[i][j]) {
+				fprintf(f, "%s{\"ns_min\": %lu, \"count\": %lu}", bsep,
+				        1UL << j, m->latency[i][j]);
+				bsep = ", ";
+			}
+		}
+		fprintf(f, "]}");
+		sep = ",";
+	}
+	fprintf(f, "\n  ],\n  \"iterations\": [");
+	for (i = 0U, sep = ""; i < METRICS_ITER_BUCKETS; i++) {
+		if (m->iter[i]) {
+			fprintf(f, "%s{\"%s\": %u, \"count\": %lu}", sep,
+			        (i + 1U < METRICS_ITER_BUCKETS) ? "iterations"
+			                                        : "iterations_min",
+			        i, m->iter[i]);
+			sep = ", ";
+		}
+	}
+	fprintf(f, "],\n  \"workspaces_created\": [");
+	for (i = 0U, sep = ""; i < METRICS_SIZE_CLASSES; i++) {
+		if (m->created[i]) {
+			fprintf(f,
+			        "%s{\"capacity_min\": %lu, \"capacity_max\": %lu, "
+			        "\"count\": %lu}",
+			        sep, metrics_class_min(i), metrics_class_max(i),
+			        m->created[i]);
+			sep = ", ";
+		}
+	}
+	fprintf(f, "],\n  \"capacity_exceeded\": %lu\n}\n", m->exceeded);
+}
+
+static void metrics_dump_text(FILE *f, const struct metrics_block *m,
+                              unsigned int n_threads) {
+	unsigned int i, j;
+	fprintf(f, "threads %u\n", n_threads);
+	for (i = 0U; i <= LP2D_POINT; i++) {
+		fprintf(f, "status %s %lu\n", metrics_status_names[i], m->status[i]);
+	}
+	for (i = 0U; i < METRICS_SIZE_CLASSES; i++) {
+		for (j = 0U; j < METRICS_LATENCY_BUCKETS; j++) {
+			if (m->latency[i][j]) {
+				fprintf(f, "latency n=%lu..%lu ns=%lu..%lu %lu\n",
+				        metrics_class_min(i), metrics_class_max(i),
+				        metrics_class_min(j + 1U), metrics_class_max(j + 1U),
+				        m->latency[i][j]);
+			}
+		}
+	}
+	for (i = 0U; i < METRICS_ITER_BUCKETS; i++) {
+		if (m->iter[i]) {
+			fprintf(f, "iterations %u%s %lu\n", i,
+			        (i + 1U < METRICS_ITER_BUCKETS) ? "" : "..", m->iter[i]);
+		}
+	}
+	for (i = 0U; i < METRICS_SIZE_CLASSES; i++) {
+		if (m->created[i]) {
+			fprintf(f, "workspaces_created capacity=%lu..%lu %lu\n",
+			        metrics_class_min(i), metrics_class_max(i), m->created[i]);
+		}
+	}
+	fprintf(f, "capacity_exceeded %lu\n", m->exceeded);
+}
+#endif /* LINPROG2D_METRICS */
+
+/******************************************************************************
+ * EXTERNAL API                                                               *
+ ******************************************************************************/
+
+linprog2d_size_t linprog2d_mem_size(unsigned int capacity) {
+	linprog2d_size_t res = 0UL;
+
+	/* Main datastructure plus alignment */
+	res += sizeof(linprog2d_data_t) + 64UL;
+
+	/* Space for the Gx, Gy, h, dx, y0, x_intersect lists plus alignment. The
+	   x_intersect list only has half the length. */
+	res +=
+	    (sizeof(double) * 5UL + sizeof(double) / 2UL) * capacity + 64UL * 6UL;
+
+	/* Space for the ceil, floor, tmp lists plus alignment. */
+	res += sizeof(unsigned int) * 3UL * capacity + 64UL * 3UL;
+
+	return res;
+}
+
+linprog2d_t *linprog2d_init(unsigned int capacity, char *mem) {
+#ifdef LINPROG2D_METRICS
+	if (mem) {
+		metrics_record_create(capacity);
+	}
+#endif
+	return linprog2d_init_internal((linprog2d_data_t *)mem, capacity,
+	                               mem + sizeof(linprog2d_data_t));
+}
+
+/**
+ * Solves the problem, passing it to the capture sink if capture is active.
+ */
+static linprog2d_result_t linprog2d_solve_captured(
+    linprog2d_t *prog, double cx, double cy, const double *Gx,
+    const double *Gy, const double *h, unsigned int n) {
+#ifdef LINPROG2D_CAPTURE
+	linprog2d_capture_record_t rec;
+	if (capture_sink) {
+		rec.seconds = capture_now();
+		rec.res = linprog2d_solve_internal((linprog2d_data_t *)prog, cx, cy,
+		                                   Gx, Gy, h, n);
+		rec.seconds = capture_now() - rec.seconds;
+		rec.cx = cx, rec.cy = cy;
+		rec.Gx = Gx, rec.Gy = Gy, rec.h = h, rec.n = n;
+		capture_sink(capture_sink_data, &rec);
+		return rec.res;
+	}
+#endif
+	return linprog2d_solve_internal((linprog2d_data_t *)prog, cx, cy, Gx, Gy,
+	                                h, n);
+}
+
+linprog2d_result_t linprog2d_solve(linprog2d_t *prog, double cx, double cy,
+                                   const double *Gx, const double *Gy,
+                                   const double *h, unsigned int n) {
+#ifdef LINPROG2D_METRICS
+	double t0 = metrics_now();
+	linprog2d_result_t res =
+	    linprog2d_solve_captured(prog, cx, cy, Gx, Gy, h, n);
+	metrics_record_solve((const linprog2d_data_t *)prog, n, res,
+	                     metrics_now() - t0);
+	return res;
+#else
+	return linprog2d_solve_captured(prog, cx, cy, Gx, Gy, h, n);
+#endif
+}
+
+void linprog2d_set_observer(linprog2d_t *prog, linprog2d_observer_t observer,
+                            void *data) {
+	((linprog2d_data_t *)prog)->observer = observer;
+	((linprog2d_data_t *)prog)->observer_data = data;
+}
+
+linprog2d_result_t linprog2d_solve_sorted(double cx, double cy,
+                                          const double *Gx, const double *Gy,
+                                          const double *h, unsigned int n) {
+	return linprog2d_solve_sorted_internal(cx, cy, Gx, Gy, h, n);
+}
+
+linprog2d_result_t linprog2d_solve_polygon(double cx, double cy,
+                                           const double *x, const double *y,
+                                           unsigned int n) {
+	return linprog2d_solve_polygon_internal(cx, cy, x, y, n);
+}
+
+linprog2d_region_t *linprog2d_region_init(unsigned int capacity, char *mem) {
+	return linprog2d_region_init_internal((linprog2d_region_data_t *)mem,
+	                                      capacity,
+	                                      mem + sizeof(linprog2d_region_data_t));
+}
+
+int linprog2d_region_prepare(linprog2d_region_t *region, const double *Gx,
+                             const double *Gy, const double *h,
+                             unsigned int n) {
+	return linprog2d_region_prepare_internal((linprog2d_region_data_t *)region,
+	                                         Gx, Gy, h, n);
+}
+
+int linprog2d_region_empty(const linprog2d_region_t *region) {
+	const linprog2d_region_data_t *r = (const linprog2d_region_data_t *)region;
+	return !(r->x0 <= r->x1);
+}
+
+void linprog2d_region_contains(const linprog2d_region_t *region,
+                               const double *x, const double *y,
+                               unsigned char *inside, unsigned int m) {
+	const linprog2d_region_data_t *r = (const linprog2d_region_data_t *)region;
+	double xs[REGION_LANES], ys[REGION_LANES];
+	unsigned int i, k;
+
+	/* Process full groups of queries directly */
+	for (i = 0U; i + REGION_LANES <= m; i += REGION_LANES) {
+		linprog2d_region_contains_interleaved(r, x + i, y + i, inside + i,
+		                                      REGION_LANES);
+	}
+
+	/* Pad the remaining queries to a full group; only the valid results are
+	   written, which avoids copying them from a temporary buffer */
+	if (i < m) {
+		for (k = 0U; k < REGION_LANES; k++) {
+			xs[k] = x[(i + k < m) ? i + k : m - 1U];
+			ys[k] = y[(i + k < m) ? i + k : m - 1U];
+		}
+		linprog2d_region_contains_interleaved(r, xs, ys, inside + i, m - i);
+	}
+}
+
+void linprog2d_region_distance(const linprog2d_region_t *region,
+                               const double *x, const double *y, double *dist,
+                               unsigned int m) {
+	const linprog2d_region_data_t *r = (const linprog2d_region_data_t *)region;
+	unsigned int i;
+	for (i = 0U; i < m; i++) {
+		dist[i] = linprog2d_region_distance_single(r, x[i], y[i]);
+	}
+}
+
+linprog2d_result_t linprog2d_region_solve(const linprog2d_region_t *region,
+                                          double cx, double cy,
+                                          const double *Gx, const double *Gy,
+                                          const double *h, unsigned int k) {
+	return linprog2d_region_solve_internal(
+	    (const linprog2d_region_data_t *)region, cx, cy, Gx, Gy, h, k);
+}
+
+linprog2d_dynamic_t *linprog2d_dynamic_init(unsigned int capacity, char *mem,
+                                            double cx, double cy) {
+	return linprog2d_dynamic_init_internal(
+	    (linprog2d_dynamic_data_t *)mem, capacity,
+	    mem + sizeof(linprog2d_dynamic_data_t), cx, cy);
+}
+
+unsigned int linprog2d_dynamic_insert(linprog2d_dynamic_t *dyn, double Gx,
+                                      double Gy, double h) {
+	return dyn_insert((linprog2d_dynamic_data_t *)dyn, Gx, Gy, h);
+}
+
+int linprog2d_dynamic_remove(linprog2d_dynamic_t *dyn, unsigned int handle) {
+	return dyn_remove((linprog2d_dynamic_data_t *)dyn, handle);
+}
+
+unsigned int linprog2d_dynamic_size(const linprog2d_dynamic_t *dyn) {
+	return ((const linprog2d_dynamic_data_t *)dyn)->n;
+}
+
+linprog2d_result_t linprog2d_dynamic_result(linprog2d_dynamic_t *dyn) {
+	linprog2d_dynamic_data_t *d = (linprog2d_dynamic_data_t *)dyn;
+	if (!d->valid) {
+		d->result = dyn_solve(d);
+		d->valid = TRUE;
+	}
+	return d->result;
+}
+
+linprog2d_window_t *linprog2d_window_init(unsigned int width, char *mem,
+                                          double cx, double cy) {
+	return linprog2d_window_init_internal(
+	    (linprog2d_window_data_t *)mem, width,
+	    mem + sizeof(linprog2d_window_data_t), cx, cy);
+}
+
+linprog2d_result_t linprog2d_window_push(linprog2d_window_t *win, double Gx,
+                                         double Gy, double h) {
+	linprog2d_window_data_t *w = (linprog2d_window_data_t *)win;
+	linprog2d_window_push_internal(w, Gx, Gy, h);
+	return linprog2d_dynamic_result(&w->dyn);
+}
+
+unsigned int linprog2d_window_size(const linprog2d_window_t *win) {
+	return ((const linprog2d_window_data_t *)win)->len;
+}
+
+linprog2d_kinetic_t *linprog2d_kinetic_init(unsigned int capacity, char *mem) {
+	return linprog2d_kinetic_init_internal(
+	    (linprog2d_kinetic_data_t *)mem, capacity,
+	    mem + sizeof(linprog2d_kinetic_data_t));
+}
+
+int linprog2d_kinetic_prepare(linprog2d_kinetic_t *kin, double cx, double cy,
+                              const double *Gx, const double *Gy,
+                              const double *h, const double *v, unsigned int n,
+                              double t) {
+	return kin_prepare((linprog2d_kinetic_data_t *)kin, cx, cy, Gx, Gy, h, v,
+	                   n, t);
+}
+
+linprog2d_result_t linprog2d_kinetic_advance(linprog2d_kinetic_t *kin,
+                                             double t) {
+	return kin_advance((linprog2d_kinetic_data_t *)kin, t);
+}
+
+double linprog2d_kinetic_next_event(const linprog2d_kinetic_t *kin) {
+	const linprog2d_kinetic_data_t *d = (const linprog2d_kinetic_data_t *)kin;
+	return d->has_basis ? d->t_next : d->t;
+}
+
+linprog2d_sampling_t *linprog2d_sampling_init(unsigned int capacity,
+                                              char *mem) {
+	return linprog2d_sampling_init_internal(
+	    (linprog2d_sampling_data_t *)mem, capacity,
+	    mem + sizeof(linprog2d_sampling_data_t));
+}
+
+unsigned int linprog2d_violators_find(const linprog2d_violator_scan_t *scan,
+                                      unsigned int i0, unsigned int i1,
+                                      unsigned int *idx) {
+	return smp_violators_find(scan, i0, i1, idx);
+}
+
+void linprog2d_sampling_set_scanner(linprog2d_sampling_t *smp,
+                                    linprog2d_scanner_t scanner, void *data) {
+	linprog2d_sampling_data_t *d = (linprog2d_sampling_data_t *)smp;
+	d->scanner = scanner;
+	d->scanner_data = data;
+}
+
+linprog2d_result_t linprog2d_sampling_solve(linprog2d_sampling_t *smp,
+                                            double cx, double cy,
+                                            const double *Gx, const double *Gy,
+                                            const double *h, unsigned int n) {
+	return smp_solve((linprog2d_sampling_data_t *)smp, cx, cy, Gx, Gy, h, n);
+}
+
+linprog2d_cutting_t *linprog2d_cutting_init(unsigned int capacity, char *mem) {
+	return linprog2d_cutting_init_internal(
+	    (linprog2d_cutting_data_t *)mem, capacity,
+	    mem + sizeof(linprog2d_cutting_data_t));
+}
+
+linprog2d_result_t linprog2d_cutting_solve(linprog2d_cutting_t *cut, double cx,
+                                           double cy, const double *Gx,
+                                           const double *Gy, const double *h,
+                                           unsigned int n,
+                                           linprog2d_oracle_t oracle,
+                                           void *data) {
+	return cut_solve((linprog2d_cutting_data_t *)cut, cx, cy, Gx, Gy, h, n,
+	                 oracle, data);
+}
+
+linprog2d_cache_t *linprog2d_cache_init(unsigned int entries,
+                                        unsigned int capacity, char *mem) {
+	return linprog2d_cache_init_internal((linprog2d_cache_data_t *)mem,
+	                                     entries, capacity,
+	                                     mem + sizeof(linprog2d_cache_data_t));
+}
+
+linprog2d_result_t linprog2d_cache_solve(linprog2d_cache_t *cache, double cx,
+                                         double cy, const double *Gx,
+                                         const double *Gy, const double *h,
+                                         unsigned int n) {
+	return cache_solve((linprog2d_cache_data_t *)cache, cx, cy, Gx, Gy, h, n);
+}
+
+unsigned long int linprog2d_cache_hits(const linprog2d_cache_t *cache) {
+	return ((const linprog2d_cache_data_t *)cache)->n_hits;
+}
+
+unsigned long int linprog2d_cache_misses(const linprog2d_cache_t *cache) {
+	return ((const linprog2d_cache_data_t *)cache)->n_misses;
+}
+
+linprog2d_size_t linprog2d_batch_mem_size(unsigned int capacity) {
+	return linprog2d_mem_size(capacity);
+}
+
+linprog2d_batch_t *linprog2d_batch_init(unsigned int capacity, char *mem) {
+	return linprog2d_init(capacity, mem);
+}
+
+void linprog2d_batch_solve(linprog2d_batch_t *batch,
+                           const linprog2d_problem_t *problems,
+                           linprog2d_result_t *res, unsigned int m) {
+	unsigned int i;
+	for (i = 0U; i < m; i++) {
+		res[i] = linprog2d_solve(batch, problems[i].cx, problems[i].cy,
+		                         problems[i].Gx, problems[i].Gy, problems[i].h,
+		                         problems[i].n);
+	}
+}
+
+#ifdef LINPROG2D_CAPTURE
+int linprog2d_capture_start(const char *filename) {
+	linprog2d_capture_stop();
+	capture_file = fopen(filename, "ab");
+	if (!capture_file) {
+		return 0;
+	}
+	setvbuf(capture_file, NULL, _IOFBF, CAPTURE_BUF_SIZE);
+	fseek(capture_file, 0L, SEEK_END);
+	if (ftell(capture_file) == 0L) {
+		fwrite(CAPTURE_MAGIC, 1U, sizeof(CAPTURE_MAGIC) - 1U, capture_file);
+	}
+	linprog2d_capture_set_sink(capture_write, capture_file);
+	return 1;
+}
+
+void linprog2d_capture_set_sink(linprog2d_capture_sink_t sink, void *data) {
+	capture_sink = sink;
+	capture_sink_data = data;
+}
+
+void linprog2d_capture_stop(void) {
+	linprog2d_capture_set_sink(NULL, NULL);
+	if (capture_file) {
+		fclose(capture_file);
+		capture_file = NULL;
+	}
+}
+#endif /* LINPROG2D_CAPTURE */
+
+#ifdef LINPROG2D_METRICS
+void linprog2d_metrics_dump(FILE *f, int format) {
+	static const struct metrics_block zero;
+	struct metrics_block sum = zero;
+	unsigned int n_threads = metrics_merge(&sum);
+	if (format == LINPROG2D_METRICS_JSON) {
+		metrics_dump_json(f, &sum, n_threads);
+	} else {
+		metrics_dump_text(f, &sum, n_threads);
+	}
+}
+#endif /* LINPROG2D_METRICS */
+
+#ifndef LINPROG2D_REDUCED_INTERFACE
+linprog2d_t *linprog2d_create(unsigned int capacity) {
+#ifndef LINPROG2D_NO_ALLOC
+	return linprog2d_init(capacity,
+	                      (char *)malloc(linprog2d_mem_size(capacity)));
+#else
+	return NULL;
+#endif
+}
+
+void linprog2d_free(linprog2d_t *prog) {
+#ifndef LINPROG2D_NO_ALLOC
+	free(prog); /* Free the previously allocated memory */
+#endif
+}
+
+unsigned int linprog2d_capacity(const linprog2d_t *prog) {
+	return ((linprog2d_data_t *)prog)->capacity;
+}
+
+void linprog2d_set_presolve(linprog2d_t *prog, int presolve) {
+	((linprog2d_data_t *)prog)->presolve = presolve ? TRUE : FALSE;
+}
+
+unsigned int linprog2d_presolve_removed(const linprog2d_t *prog) {
+	return ((linprog2d_data_t *)prog)->n_removed;
+}
+
+linprog2d_result_t linprog2d_solve_simple(double cx, double cy,
+                                          const double *Gx, const double *Gy,
+                                          const double *h, unsigned int n) {
+#ifndef LINPROG2D_NO_ALLOC
+	linprog2d_t *prog = linprog2d_create(n);
+	if (prog) {
+		linprog2d_result_t res = linprog2d_solve(prog, cx, cy, Gx, Gy, h, n);
+		linprog2d_free(prog);
+		return res;
+	}
+#endif /* LINPROG2D_NO_ALLOC */
+	return linprog2d_result_err();
+}
+
+linprog2d_size_t linprog2d_region_mem_size(unsigned int capacity) {
+	linprog2d_size_t res = 0UL;
+
+	/* Main datastructure plus alignment */
+	res += sizeof(linprog2d_region_data_t) + 64UL;
+
+	/* Space for the dx, y0, bx, src_dx, src_y0 lists plus alignment */
+	res += sizeof(double) * 5UL * capacity + 64UL * 5UL;
+
+	/* Space for the idcs list plus alignment */
+	res += sizeof(unsigned int) * capacity + 64UL;
+
+	return res;
+}
+
+linprog2d_region_t *linprog2d_region_create(unsigned int capacity) {
+#ifndef LINPROG2D_NO_ALLOC
+	return linprog2d_region_init(
+	    capacity, (char *)malloc(linprog2d_region_mem_size(capacity)));
+#else
+	return NULL;
+#endif
+}
+
+void linprog2d_region_free(linprog2d_region_t *region) {
+#ifndef LINPROG2D_NO_ALLOC
+	free(region);
+#endif
+}
+
+linprog2d_size_t linprog2d_dynamic_mem_size(unsigned int capacity) {
+	linprog2d_size_t res = 0UL;
+
+	/* Main datastructure plus alignment */
+	res += sizeof(linprog2d_dynamic_data_t) + 64UL;
+
+	/* Space for the node pool and the tmp list plus alignment */
+	res += sizeof(linprog2d_dynamic_node_t) * 2UL * capacity + 64UL;
+	res += sizeof(unsigned int) * capacity + 64UL;
+
+	return res;
+}
+
+linprog2d_dynamic_t *linprog2d_dynamic_create(unsigned int capacity, double cx,
+                                              double cy) {
+#ifndef LINPROG2D_NO_ALLOC
+	return linprog2d_dynamic_init(
+	    capacity, (char *)malloc(linprog2d_dynamic_mem_size(capacity)), cx,
+	    cy);
+#else
+	return NULL;
+#endif
+}
+
+void linprog2d_dynamic_free(linprog2d_dynamic_t *dyn) {
+#ifndef LINPROG2D_NO_ALLOC
+	free(dyn);
+#endif
+}
+
+linprog2d_size_t linprog2d_window_mem_size(unsigned int width) {
+	linprog2d_size_t res = 0UL;
+
+	/* Main datastructure plus alignment */
+	res += sizeof(linprog2d_window_data_t) + 64UL;
+
+	/* Space for the ring buffer plus alignment */
+	res += sizeof(unsigned int) * width + 64UL;
+
+	/* Space for the dynamic constraint set, minus its main datastructure */
+	res += linprog2d_dynamic_mem_size(width) - sizeof(linprog2d_dynamic_data_t);
+
+	return res;
+}
+
+linprog2d_window_t *linprog2d_window_create(unsigned int width, double cx,
+                                            double cy) {
+#ifndef LINPROG2D_NO_ALLOC
+	return linprog2d_window_init(
+	    width, (char *)malloc(linprog2d_window_mem_size(width)), cx, cy);
+#else
+	return NULL;
+#endif
+}
+
+void linprog2d_window_free(linprog2d_window_t *win) {
+#ifndef LINPROG2D_NO_ALLOC
+	free(win);
+#endif
+}
+
+linprog2d_size_t linprog2d_kinetic_mem_size(unsigned int capacity) {
+	linprog2d_size_t res = 0UL;
+
+	/* Main datastructure plus alignment */
+	res += sizeof(linprog2d_kinetic_data_t) + 64UL;
+
+	/* Space for the Gx, Gy, h, v, ht lists plus alignment */
+	res += sizeof(double) * 5UL * capacity + 64UL * 5UL;
+
+	/* Space for the solver, minus its main datastructure */
+	res += linprog2d_mem_size(capacity) - sizeof(linprog2d_data_t);
+
+	return res;
+}
+
+linprog2d_kinetic_t *linprog2d_kinetic_create(unsigned int capacity) {
+#ifndef LINPROG2D_NO_ALLOC
+	return linprog2d_kinetic_init(
+	    capacity, (char *)malloc(linprog2d_kinetic_mem_size(capacity)));
+#else
+	return NULL;
+#endif
+}
+
+void linprog2d_kinetic_free(linprog2d_kinetic_t *kin) {
+#ifndef LINPROG2D_NO_ALLOC
+	free(kin);
+#endif
+}
+
+linprog2d_size_t linprog2d_sampling_mem_size(unsigned int capacity) {
+	const unsigned int w = smp_width(capacity) + 4U;
+	linprog2d_size_t res = 0UL;
+
+	/* Main datastructure plus alignment */
+	res += sizeof(linprog2d_sampling_data_t) + 64UL;
+
+	/* Space for the Gx, Gy, h lists of the working set plus alignment */
+	res += sizeof(double) * 3UL * w + 64UL * 3UL;
+
+	/* Space for the violator indices plus alignment */
+	res += sizeof(unsigned int) * w + 64UL;
+
+	/* Space for the solver, minus its main datastructure */
+	res += linprog2d_mem_size(w) - sizeof(linprog2d_data_t);
+
+	return res;
+}
+
+linprog2d_sampling_t *linprog2d_sampling_create(unsigned int capacity) {
+#ifndef LINPROG2D_NO_ALLOC
+	return linprog2d_sampling_init(
+	    capacity, (char *)malloc(linprog2d_sampling_mem_size(capacity)));
+#else
+	return NULL;
+#endif
+}
+
+void linprog2d_sampling_free(linprog2d_sampling_t *smp) {
+#ifndef LINPROG2D_NO_ALLOC
+	free(smp);
+#endif
+}
+
+linprog2d_size_t linprog2d_cutting_mem_size(unsigned int capacity) {
+	const unsigned int w = capacity + 5U;
+	linprog2d_size_t res = 0UL;
+
+	/* Main datastructure plus alignment */
+	res += sizeof(linprog2d_cutting_data_t) + 64UL;
+
+	/* Space for the ages of the active set plus alignment */
+	res += sizeof(unsigned int) * w + 64UL;
+
+	/* Space for the active set, minus its main datastructure */
+	res += linprog2d_kinetic_mem_size(w) - sizeof(linprog2d_kinetic_data_t);
+
+	return res;
+}
+
+linprog2d_cutting_t *linprog2d_cutting_create(unsigned int capacity) {
+#ifndef LINPROG2D_NO_ALLOC
+	return linprog2d_cutting_init(
+	    capacity, (char *)malloc(linprog2d_cutting_mem_size(capacity)));
+#else
+	return NULL;
+#endif
+}
+
+void linprog2d_cutting_free(linprog2d_cutting_t *cut) {
+#ifndef LINPROG2D_NO_ALLOC
+	free(cut);
+#endif
+}
+
+linprog2d_size_t linprog2d_cache_mem_size(unsigned int entries,
+                                          unsigned int capacity) {
+	const linprog2d_size_t pool = (linprog2d_size_t)entries * capacity;
+	linprog2d_size_t res = 0UL;
+
+	/* Main datastructure plus alignment */
+	res += sizeof(linprog2d_cache_data_t) + 64UL;
+
+	/* Space for the Gx, Gy, h pools plus alignment */
+	res += sizeof(double) * 3UL * pool + 64UL * 3UL;
+
+	/* Space for the per-entry lists and the buckets plus alignment */
+	res += (sizeof(double) * 2UL + sizeof(linprog2d_result_t) +
+	        sizeof(unsigned long int) + sizeof(unsigned int) * 4UL) *
+	           entries +
+	       64UL * 8UL;
+	res += sizeof(unsigned int) * (cache_mask(entries) + 1UL) + 64UL;
+
+	/* Space for the solver, minus its main datastructure */
+	res += linprog2d_mem_size(capacity) - sizeof(linprog2d_data_t);
+
+	return res;
+}
+
+linprog2d_cache_t *linprog2d_cache_create(unsigned int entries,
+                                          unsigned int capacity) {
+#ifndef LINPROG2D_NO_ALLOC
+	return linprog2d_cache_init(
+	    entries, capacity,
+	    (char *)malloc(linprog2d_cache_mem_size(entries, capacity)));
+#else
+	return NULL;
+#endif
+}
+
+void linprog2d_cache_free(linprog2d_cache_t *cache) {
+#ifndef LINPROG2D_NO_ALLOC
+	free(cache);
+#endif
+}
+
+linprog2d_batch_t *linprog2d_batch_create(unsigned int capacity) {
+	return linprog2d_create(capacity);
+}
+
+void linprog2d_batch_free(linprog2d_batch_t *batch) {
+	linprog2d_free(batch);
 }
 #endif /* LINPROG2D_REDUCED_INTERFACE */
@@ -97,6 +97,32 @@ struct linprog2d_result {
  */
 typedef struct linprog2d_result linprog2d_result_t;
 
+/**
+ * Structure describing a single problem, as passed to linprog2d_solve(). Used
+ * to pass multiple problems at once.
+ */
+struct linprog2d_problem {
+	/**
+	 * Gradient of the objective function.
+	 */
+	double cx, cy;
+
+	/**
+	 * Constraints of the form Gx[i] * x + Gy[i] * y >= h[i].
+	 */
+	const double *Gx, *Gy, *h;
+
+	/**
+	 * Number of constraints.
+	 */
+	unsigned int n;
+};
+
+/**
+ * Typedef of the above structure.
+ */
+typedef struct linprog2d_problem linprog2d_problem_t;
+
 /**
  * Opaque type used to represent a linprog2d instance.
  */
@@ -107,6 +133,12 @@ typedef void linprog2d_t;
  */
 typedef unsigned long int linprog2d_size_t;
 
+/**
+ * Computes the number of bytes required to store a Linprog2DSolver instance
+ * with the given capacity.
+ */
+linprog2d_size_t LP2D_EXPORT linprog2d_mem_size(unsigned int capacity);
+
 /**
  * Constructs a linprog2d instance with the given capacity inplace at the
  * given memory location. The required size of the memory region can be computed
@@ -131,12 +163,656 @@ linprog2d_result_t LP2D_EXPORT linprog2d_solve(linprog2d_t *prog, double cx,
                                                const double *Gy,
                                                const double *h, unsigned int n);
 
-#ifndef LINPROG2D_REDUCED_INTERFACE
 /**
- * Computes the number of bytes required to store a Linprog2DSolver instance
+ * Solves a two-dimensional linear programming problem in O(log n) time for
+ * constraints that are known to be sorted. The normals (Gx[i], Gy[i]) must be
+ * sorted by angle in counter-clockwise order (starting at an arbitrary
+ * constraint) and each constraint must contribute an edge to the non-empty
+ * feasible region, as is the case for constraints describing a convex hull.
+ * The result is undefined if these conditions are not met. The input arrays
+ * are not copied and no additional memory is required.
+ */
+linprog2d_result_t LP2D_EXPORT linprog2d_solve_sorted(double cx, double cy,
+                                                      const double *Gx,
+                                                      const double *Gy,
+                                                      const double *h,
+                                                      unsigned int n);
+
+/**
+ * Minimizes cx * x + cy * y over the convex polygon with the n vertices
+ * (x[i], y[i]) in O(log n) time. The vertices must be given in
+ * counter-clockwise order, and no three consecutive vertices may be collinear.
+ * Returns LP2D_INFEASIBLE if n is zero.
+ */
+linprog2d_result_t LP2D_EXPORT linprog2d_solve_polygon(double cx, double cy,
+                                                       const double *x,
+                                                       const double *y,
+                                                       unsigned int n);
+
+/**
+ * Location of the optimum relative to the median computed in an iteration of
+ * the prune loop in linprog2d_solve(), as reported to observers.
+ */
+enum linprog2d_verdict {
+	/**
+	 * No median was computed in this iteration because there were no
+	 * intersections left; the iteration only discarded constraints.
+	 */
+	LP2D_VERDICT_NONE = 0,
+
+	/**
+	 * The constraints are contradictory at the median; the problem is
+	 * infeasible.
+	 */
+	LP2D_VERDICT_INFEASIBLE = 1,
+
+	/**
+	 * The optimum is to the left of the median.
+	 */
+	LP2D_VERDICT_LEFT = 2,
+
+	/**
+	 * The optimum is to the right of the median.
+	 */
+	LP2D_VERDICT_RIGHT = 3,
+
+	/**
+	 * The optimum is a point on the median.
+	 */
+	LP2D_VERDICT_HERE = 4,
+
+	/**
+	 * The optimum is an edge through the median.
+	 */
+	LP2D_VERDICT_HERE_EDGE = 5
+};
+
+/**
+ * State of the prune loop after a single iteration, as passed to observers.
+ * Coordinates refer to the rotated and scaled coordinate system in which
+ * linprog2d_solve() minimizes y, not to the coordinates of the problem.
+ */
+struct linprog2d_iteration {
+	/**
+	 * Index of the iteration, starting at zero.
+	 */
+	unsigned int iteration;
+
+	/**
+	 * Median of the intersection points and its verdict. mx is only valid if
+	 * the verdict is not LP2D_VERDICT_NONE.
+	 */
+	double mx;
+	enum linprog2d_verdict verdict;
+
+	/**
+	 * Bracket [x0, x1] known to contain the optimum after this iteration.
+	 */
+	double x0, x1;
+
+	/**
+	 * Number of surviving ceil and floor constraints and the number of
+	 * intersection points the median was computed from.
+	 */
+	unsigned int ceil_len, floor_len, intersect_len;
+};
+
+/**
+ * Typedef of the above structure.
+ */
+typedef struct linprog2d_iteration linprog2d_iteration_t;
+
+/**
+ * Observer called by linprog2d_solve() after each iteration of the prune loop.
+ * The data pointer is passed through from linprog2d_set_observer().
+ */
+typedef void (*linprog2d_observer_t)(void *data, const linprog2d_t *prog,
+                                     const linprog2d_iteration_t *it);
+
+/**
+ * Sets the observer called after each iteration of the prune loop when
+ * solving problems with the given instance, or removes it if observer is
+ * null. Instances are created without an observer; while none is set, the
+ * only cost is a single branch per iteration.
+ */
+void LP2D_EXPORT linprog2d_set_observer(linprog2d_t *prog,
+                                        linprog2d_observer_t observer,
+                                        void *data);
+
+/**
+ * Opaque type used to represent a prepared feasible region. A region is built
+ * once from a set of constraints and can then be used to answer many point
+ * queries against the same constraints.
+ */
+typedef void linprog2d_region_t;
+
+/**
+ * Constructs a linprog2d_region instance with the given capacity inplace at the
+ * given memory location. The required size of the memory region can be
+ * computed by calling linprog2d_region_mem_size().
+ *
+ * @param capacity is the number of constraints the region should be able to
+ * be prepared from.
+ * @param mem is a pointer at the memory region the instance should be written
+ * to.
+ */
+linprog2d_region_t LP2D_EXPORT *linprog2d_region_init(unsigned int capacity,
+                                                      char *mem);
+
+/**
+ * Prepares the region described by the constraints
+ *
+ * Gx[i] * x + Gy[i] * y >= h[i] for all i.
+ *
+ * Internally, the boundary of the region is stored as a lower and an upper
+ * polygonal chain. Preparing the region takes O(n log n) time. Returns zero if
+ * the region does not have sufficient capacity, non-zero otherwise. Note that
+ * the prepared region may be empty; see linprog2d_region_empty().
+ */
+int LP2D_EXPORT linprog2d_region_prepare(linprog2d_region_t *region,
+                                         const double *Gx, const double *Gy,
+                                         const double *h, unsigned int n);
+
+/**
+ * Returns non-zero if the previously prepared region is empty, i.e. the
+ * constraints are infeasible.
+ */
+int LP2D_EXPORT linprog2d_region_empty(const linprog2d_region_t *region);
+
+/**
+ * Tests whether each of the m points (x[i], y[i]) is inside the region and
+ * writes one or zero to inside[i]. Each query takes O(log n) time, where n is
+ * the number of constraints the region was prepared from. Points on the
+ * boundary are considered to be inside, but no tolerance is applied.
+ */
+void LP2D_EXPORT linprog2d_region_contains(const linprog2d_region_t *region,
+                                           const double *x, const double *y,
+                                           unsigned char *inside,
+                                           unsigned int m);
+
+/**
+ * Computes the signed euclidean distance between each of the m points
+ * (x[i], y[i]) and the boundary of the region and writes it to dist[i]. The
+ * distance is negative for points inside the region. Each query takes time
+ * linear in the number of edges of the region (not the number of
+ * constraints). The distance to an empty region is infinity.
+ */
+void LP2D_EXPORT linprog2d_region_distance(const linprog2d_region_t *region,
+                                           const double *x, const double *y,
+                                           double *dist, unsigned int m);
+
+/**
+ * Solves the linear program
+ *
+ * minimize c.x * x + c.y * y
+ * w.r.t.   (x, y) in region and Gx[i] * x + Gy[i] * y >= h[i] for all i < k
+ *
+ * without copying the constraints the region was prepared from. Each of the k
+ * additional constraint lines is intersected with the region by binary search,
+ * resulting in O(k log n + k^2) time, where n is the number of constraints the
+ * region was prepared from. Intended for a small number k of additional
+ * constraints.
+ */
+linprog2d_result_t LP2D_EXPORT linprog2d_region_solve(
+    const linprog2d_region_t *region, double cx, double cy, const double *Gx,
+    const double *Gy, const double *h, unsigned int k);
+
+/**
+ * Handle value signifying that a constraint could not be inserted into a
+ * dynamic constraint set.
+ */
+#define LINPROG2D_INVALID_HANDLE 0xFFFFFFFFU
+
+/**
+ * Opaque type used to represent a dynamic constraint set. A dynamic constraint
+ * set maintains the optimum of a linear program with a fixed objective while
+ * constraints are inserted and removed.
+ */
+typedef void linprog2d_dynamic_t;
+
+/**
+ * Constructs a linprog2d_dynamic instance with the given capacity inplace at
+ * the given memory location. The required size of the memory region can be
+ * computed by calling linprog2d_dynamic_mem_size(). The constraint set is
+ * initially empty.
+ *
+ * @param capacity is the maximum number of constraints in the set.
+ * @param mem is a pointer at the memory region the instance should be written
+ * to.
+ * @param cx is the x-component of the gradient that should be minimized.
+ * @param cy is the y-component of the gradient that should be minimized.
+ */
+linprog2d_dynamic_t LP2D_EXPORT *linprog2d_dynamic_init(unsigned int capacity,
+                                                        char *mem, double cx,
+                                                        double cy);
+
+/**
+ * Inserts the constraint Gx * x + Gy * y >= h into the dynamic constraint set.
+ * Returns a handle that can be passed to linprog2d_dynamic_remove(), or
+ * LINPROG2D_INVALID_HANDLE if the capacity is exhausted. Runs in amortised
+ * O(log^3 n) time.
+ */
+unsigned int LP2D_EXPORT linprog2d_dynamic_insert(linprog2d_dynamic_t *dyn,
+                                                  double Gx, double Gy,
+                                                  double h);
+
+/**
+ * Removes the constraint with the given handle from the dynamic constraint
+ * set. Returns zero if the handle is invalid, non-zero otherwise. Handles
+ * carry a generation counter, so the handle of a removed constraint stays
+ * invalid when its slot is reused by a later insertion (the counter wraps
+ * around after 2^(32 - b) reuses of the same slot, where b is the number of
+ * bits required to store 2 * capacity). Runs in amortised O(log^3 n) time.
+ */
+int LP2D_EXPORT linprog2d_dynamic_remove(linprog2d_dynamic_t *dyn,
+                                         unsigned int handle);
+
+/**
+ * Returns the number of constraints currently in the dynamic constraint set.
+ */
+unsigned int LP2D_EXPORT
+linprog2d_dynamic_size(const linprog2d_dynamic_t *dyn);
+
+/**
+ * Returns the optimum for the current set of constraints. The result is
+ * computed in O(log^2 n) time after the constraint set has been changed and
+ * cached until the next change.
+ */
+linprog2d_result_t LP2D_EXPORT
+linprog2d_dynamic_result(linprog2d_dynamic_t *dyn);
+
+/**
+ * Opaque type used to represent a sliding window over a stream of constraints.
+ * The window holds the most recently pushed constraints and maintains the
+ * optimum of the linear program defined by them.
+ */
+typedef void linprog2d_window_t;
+
+/**
+ * Constructs a linprog2d_window instance inplace at the given memory location.
+ * The required size of the memory region can be computed by calling
+ * linprog2d_window_mem_size(). The window is initially empty.
+ *
+ * @param width is the maximum number of constraints in the window.
+ * @param mem is a pointer at the memory region the instance should be written
+ * to.
+ * @param cx is the x-component of the gradient that should be minimized.
+ * @param cy is the y-component of the gradient that should be minimized.
+ */
+linprog2d_window_t LP2D_EXPORT *linprog2d_window_init(unsigned int width,
+                                                      char *mem, double cx,
+                                                      double cy);
+
+/**
+ * Pushes the constraint Gx * x + Gy * y >= h into the window. If the window
+ * already contains width constraints, the oldest constraint is dropped.
+ * Returns the optimum over the constraints in the window. Runs in amortised
+ * O(log^3 width) time, in contrast to O(width) for solving the window from
+ * scratch.
+ */
+linprog2d_result_t LP2D_EXPORT linprog2d_window_push(linprog2d_window_t *win,
+                                                     double Gx, double Gy,
+                                                     double h);
+
+/**
+ * Returns the number of constraints currently in the window.
+ */
+unsigned int LP2D_EXPORT linprog2d_window_size(const linprog2d_window_t *win);
+
+/**
+ * Opaque type used to represent a kinetic problem. In a kinetic problem, the
+ * offset of each constraint changes linearly over time.
+ */
+typedef void linprog2d_kinetic_t;
+
+/**
+ * Constructs a linprog2d_kinetic instance with the given capacity inplace at
+ * the given memory location. The required size of the memory region can be
+ * computed by calling linprog2d_kinetic_mem_size().
+ *
+ * @param capacity is the maximum number of constraints in a problem.
+ * @param mem is a pointer at the memory region the instance should be written
+ * to.
+ */
+linprog2d_kinetic_t LP2D_EXPORT *linprog2d_kinetic_init(unsigned int capacity,
+                                                        char *mem);
+
+/**
+ * Copies the kinetic problem
+ *
+ * minimize c.x * x + c.y * y
+ * w.r.t.   Gx[i] * x + Gy[i] * y >= h[i] + v[i] * t for all i
+ *
+ * into the linprog2d_kinetic instance and solves it at time t. Returns zero if
+ * the instance does not have sufficient capacity, non-zero otherwise.
+ */
+int LP2D_EXPORT linprog2d_kinetic_prepare(linprog2d_kinetic_t *kin, double cx,
+                                          double cy, const double *Gx,
+                                          const double *Gy, const double *h,
+                                          const double *v, unsigned int n,
+                                          double t);
+
+/**
+ * Returns the optimum of the kinetic problem at time t. As long as the optimum
+ * is a single vertex, the optimal pair of constraints is tracked and updated
+ * at each event (the time at which another constraint becomes violated);
+ * queries between events take constant time. Each event takes O(n) time.
+ * Queries with decreasing t, and problems for which the optimum is not a
+ * single vertex, are solved from scratch.
+ */
+linprog2d_result_t LP2D_EXPORT
+linprog2d_kinetic_advance(linprog2d_kinetic_t *kin, double t);
+
+/**
+ * Returns the time of the next event after the last query, or HUGE_VAL if the
+ * optimal pair of constraints never changes. If the optimum at the time of the
+ * last query is not a single vertex, returns the time of the last query.
+ */
+double LP2D_EXPORT
+linprog2d_kinetic_next_event(const linprog2d_kinetic_t *kin);
+
+/**
+ * Opaque type used to represent a sampling solver. A sampling solver solves
+ * problems with a very large number of constraints using only O(sqrt(n))
+ * memory and a small expected number of passes over the constraints.
+ */
+typedef void linprog2d_sampling_t;
+
+/**
+ * Constructs a linprog2d_sampling instance with the given capacity inplace at
+ * the given memory location. The required size of the memory region can be
+ * computed by calling linprog2d_sampling_mem_size().
+ *
+ * @param capacity is the maximum number of constraints in a problem.
+ * @param mem is a pointer at the memory region the instance should be written
+ * to.
+ */
+linprog2d_sampling_t LP2D_EXPORT *linprog2d_sampling_init(unsigned int capacity,
+                                                          char *mem);
+
+/**
+ * Solves the same problem as linprog2d_solve() using Clarkson's random
+ * sampling algorithm. The problem is solved for a random sample of O(sqrt(n))
+ * constraints; a single pass over all constraints then determines the
+ * constraints violated by this solution, which are added to the next sample.
+ * The expected number of passes is a small constant, compared to O(log n)
+ * passes for linprog2d_solve(). The input arrays are not copied. Returns
+ * LP2D_ERROR if n exceeds the capacity or, with vanishing probability, if no
+ * solution was found after a fixed number of rounds. Solutions with
+ * coordinates beyond 1e100 are reported as unbounded.
+ */
+linprog2d_result_t LP2D_EXPORT linprog2d_sampling_solve(
+    linprog2d_sampling_t *smp, double cx, double cy, const double *Gx,
+    const double *Gy, const double *h, unsigned int n);
+
+/**
+ * A scan for constraints violated by the optimum of a subproblem of
+ * linprog2d_sampling_solve(). A constraint is violated if res.(x1, y1) or, for
+ * an edge, res.(x2, y2) violates it by more than the solver's tolerance.
+ */
+struct linprog2d_violator_scan {
+	const double *Gx, *Gy, *h;
+	unsigned int n;
+	linprog2d_result_t res;
+
+	/**
+	 * The scan may stop once more than max_k violators have been found.
+	 */
+	unsigned int max_k;
+};
+
+typedef struct linprog2d_violator_scan linprog2d_violator_scan_t;
+
+/**
+ * Finds the constraints with index in [i0, i1) violated according to the
+ * given scan. Writes the indices of the first min(k, max_k + 1) of the k
+ * violators in ascending order to idx and returns their number. Does not
+ * modify any shared state and may be called from several threads at once.
+ */
+unsigned int LP2D_EXPORT linprog2d_violators_find(
+    const linprog2d_violator_scan_t *scan, unsigned int i0, unsigned int i1,
+    unsigned int *idx);
+
+/**
+ * Callback performing a violator scan over all constraints, for example on
+ * several threads (see tools/linprog2d_scan.h). Must write the same indices to
+ * idx and return the same value as
+ * linprog2d_violators_find(scan, 0, scan->n, idx). The data pointer is passed
+ * through from linprog2d_sampling_set_scanner().
+ */
+typedef unsigned int (*linprog2d_scanner_t)(
+    void *data, const linprog2d_violator_scan_t *scan, unsigned int *idx);
+
+/**
+ * Replaces the sequential violator scan of linprog2d_sampling_solve() with
+ * the given callback. Passing null restores the sequential scan.
+ */
+void LP2D_EXPORT linprog2d_sampling_set_scanner(linprog2d_sampling_t *smp,
+                                                linprog2d_scanner_t scanner,
+                                                void *data);
+
+/**
+ * Separation oracle used by linprog2d_cutting_solve(). Given the point (x, y),
+ * the oracle writes up to max_k constraints Gx[i] * x + Gy[i] * y >= h[i]
+ * violated by this point to the given arrays and returns the number of
+ * constraints that were written. Returning zero signals that the point
+ * satisfies all constraints. The data pointer is passed through from
+ * linprog2d_cutting_solve().
+ */
+typedef unsigned int (*linprog2d_oracle_t)(void *data, double x, double y,
+                                           double *Gx, double *Gy, double *h,
+                                           unsigned int max_k);
+
+/**
+ * Opaque type used to represent a cutting plane solver. A cutting plane
+ * solver handles problems whose constraints are generated on demand by a
+ * separation oracle instead of being passed as arrays.
+ */
+typedef void linprog2d_cutting_t;
+
+/**
+ * Constructs a linprog2d_cutting instance with the given capacity inplace at
+ * the given memory location. The required size of the memory region can be
+ * computed by calling linprog2d_cutting_mem_size().
+ *
+ * @param capacity is the maximum number of constraints in the active set,
+ * i.e. the initial constraints plus those generated by the oracle.
+ * @param mem is a pointer at the memory region the instance should be written
+ * to.
+ */
+linprog2d_cutting_t LP2D_EXPORT *linprog2d_cutting_init(unsigned int capacity,
+                                                        char *mem);
+
+/**
+ * Solves the linear program
+ *
+ * minimize c.x * x + c.y * y
+ * w.r.t.   Gx[i] * x + Gy[i] * y >= h[i] for all i < n
+ *          and all constraints known to the oracle.
+ *
+ * The n initial constraints form the active set. The active set is solved
+ * repeatedly; after each solve, the oracle is queried at the optimum and the
+ * violated constraints it returns are added to the active set. Each solve
+ * starts from the optimal basis of the previous one. Oracle constraints that
+ * stay slack for several rounds are removed from the active set again.
+ * Solving stops once the oracle no longer finds a violated constraint. Returns
+ * LP2D_ERROR if the active set exceeds the capacity or, if the oracle keeps
+ * generating dropped constraints, after a fixed number of rounds. Solutions
+ * with coordinates beyond 1e100 are reported as unbounded.
+ */
+linprog2d_result_t LP2D_EXPORT linprog2d_cutting_solve(
+    linprog2d_cutting_t *cut, double cx, double cy, const double *Gx,
+    const double *Gy, const double *h, unsigned int n,
+    linprog2d_oracle_t oracle, void *data);
+
+/**
+ * Opaque type used to represent a result cache. A result cache remembers the
+ * results of recently solved problems and returns them without solving the
+ * problem again if an identical problem is passed.
+ */
+typedef void linprog2d_cache_t;
+
+/**
+ * Constructs a linprog2d_cache instance inplace at the given memory location.
+ * The required size of the memory region can be computed by calling
+ * linprog2d_cache_mem_size(). The cache is initially empty.
+ *
+ * @param entries is the maximum number of problems stored in the cache.
+ * @param capacity is the maximum number of constraints in a problem.
+ * @param mem is a pointer at the memory region the instance should be written
+ * to.
+ */
+linprog2d_cache_t LP2D_EXPORT *linprog2d_cache_init(unsigned int entries,
+                                                    unsigned int capacity,
+                                                    char *mem);
+
+/**
+ * Solves the same problem as linprog2d_solve(), but returns the stored result
+ * if the exact same problem is in the cache. Lookups hash the input in linear
+ * time and compare it against the stored copy of the problem, so a hit never
+ * returns the result of a different problem. On a miss, the problem is solved
+ * and replaces the least recently used entry. Note that a cache instance must
+ * not be shared between threads; use one instance per thread or the sharded
+ * cache in tools/linprog2d_shared_cache.h instead.
+ */
+linprog2d_result_t LP2D_EXPORT linprog2d_cache_solve(linprog2d_cache_t *cache,
+                                                     double cx, double cy,
+                                                     const double *Gx,
+                                                     const double *Gy,
+                                                     const double *h,
+                                                     unsigned int n);
+
+/**
+ * Returns the number of calls to linprog2d_cache_solve() that were answered
+ * from the cache.
+ */
+unsigned long int LP2D_EXPORT
+linprog2d_cache_hits(const linprog2d_cache_t *cache);
+
+/**
+ * Returns the number of calls to linprog2d_cache_solve() that had to solve the
+ * problem.
+ */
+unsigned long int LP2D_EXPORT
+linprog2d_cache_misses(const linprog2d_cache_t *cache);
+
+/**
+ * Opaque type used to represent a batch solver. A batch solver is a solver
+ * instance that solves several problems in a single call, one after another.
+ * This saves a call per problem, which matters when calling across a language
+ * boundary (see linprog2d.in.js).
+ */
+typedef void linprog2d_batch_t;
+
+/**
+ * Computes the number of bytes required to store a linprog2d_batch instance
  * with the given capacity.
  */
-linprog2d_size_t LP2D_EXPORT linprog2d_mem_size(unsigned int capacity);
+linprog2d_size_t LP2D_EXPORT linprog2d_batch_mem_size(unsigned int capacity);
+
+/**
+ * Constructs a linprog2d_batch instance inplace at the given memory location.
+ * The required size of the memory region can be computed by calling
+ * linprog2d_batch_mem_size().
+ *
+ * @param capacity is the maximum number of constraints in a problem.
+ * @param mem is a pointer at the memory region the instance should be written
+ * to.
+ */
+linprog2d_batch_t LP2D_EXPORT *linprog2d_batch_init(unsigned int capacity,
+                                                    char *mem);
+
+/**
+ * Solves the m given problems and writes the results to res. The results are
+ * the same as those returned by linprog2d_solve(); problems with more
+ * constraints than the capacity of the batch result in LP2D_ERROR. Each
+ * problem is captured and counted by the metrics like a call to
+ * linprog2d_solve().
+ */
+void LP2D_EXPORT linprog2d_batch_solve(linprog2d_batch_t *batch,
+                                       const linprog2d_problem_t *problems,
+                                       linprog2d_result_t *res, unsigned int m);
+
+#ifdef LINPROG2D_CAPTURE
+/**
+ * A problem passed to linprog2d_solve() or linprog2d_batch_solve() while
+ * capture is active, together with its result and the time in seconds it took
+ * to solve it.
+ */
+struct linprog2d_capture_record {
+	double cx, cy;
+	const double *Gx, *Gy, *h;
+	unsigned int n;
+	linprog2d_result_t res;
+	double seconds;
+};
+
+typedef struct linprog2d_capture_record linprog2d_capture_record_t;
+
+/**
+ * Receives captured problems. Called on the thread that solved the problem;
+ * the arrays are only valid during the call. The data pointer is passed
+ * through from linprog2d_capture_set_sink().
+ */
+typedef void (*linprog2d_capture_sink_t)(void *data,
+                                         const linprog2d_capture_record_t *rec);
+
+/**
+ * Starts capturing problems. While capture is active, each problem passed to
+ * linprog2d_solve() or linprog2d_batch_solve() is appended to the given file,
+ * together with its result and the time it took to solve it. Problems solved
+ * internally by the other solvers in this library are not captured. The file
+ * is created if it does not exist. Writes are buffered; the buffer is flushed
+ * when capture is stopped. Records written by concurrent solves are not
+ * interleaved, but the writes happen on the solving thread;
+ * tools/linprog2d_capture.h moves them to a background thread. Returns zero if
+ * the file cannot be opened, non-zero otherwise. Only available if the library
+ * has been compiled with the LINPROG2D_CAPTURE flag; use test/replay_linprog2d
+ * to re-run a capture file.
+ */
+int LP2D_EXPORT linprog2d_capture_start(const char *filename);
+
+/**
+ * Passes each problem solved by linprog2d_solve() or linprog2d_batch_solve()
+ * to the given sink instead of writing it to a file, or stops capture if sink
+ * is null. Capture is process-wide; this function, linprog2d_capture_start(),
+ * and linprog2d_capture_stop() must not be called while other threads solve
+ * problems.
+ */
+void LP2D_EXPORT linprog2d_capture_set_sink(linprog2d_capture_sink_t sink,
+                                            void *data);
+
+/**
+ * Stops capturing problems and closes the capture file.
+ */
+void LP2D_EXPORT linprog2d_capture_stop(void);
+#endif /* LINPROG2D_CAPTURE */
+
+#ifdef LINPROG2D_METRICS
+#include <stdio.h>
+
+#define LINPROG2D_METRICS_TEXT 0
+#define LINPROG2D_METRICS_JSON 1
+
+/**
+ * Writes the process-wide solver metrics to the given file, either as lines of
+ * text or as a single JSON object. The metrics comprise latency histograms of
+ * linprog2d_solve() and the problems of linprog2d_batch_solve() per problem
+ * size class, the number of results per status, a histogram of the number of
+ * prune iterations, the number of solver instances created per capacity class,
+ * and the number of problems exceeding the capacity of the instance. Only calls
+ * to the public interface are counted, not the solves other solvers in this
+ * library perform internally. Counters are kept per thread and merged when the
+ * metrics are written; they are cumulative over the lifetime of the process.
+ * The counters of exited threads are reused by new threads, so "threads" is the
+ * largest number of threads that recorded metrics at the same time. Only
+ * available if the library has been compiled with the LINPROG2D_METRICS flag,
+ * which requires POSIX threads.
+ */
+void LP2D_EXPORT linprog2d_metrics_dump(FILE *f, int format);
+#endif /* LINPROG2D_METRICS */
+
+#ifndef LINPROG2D_REDUCED_INTERFACE
 
 /**
  * Creates a new linprog2d instance that is able to represent at least n
@@ -159,6 +835,22 @@ void LP2D_EXPORT linprog2d_free(linprog2d_t *prog);
  */
 unsigned int LP2D_EXPORT linprog2d_capacity(const linprog2d_t *prog);
 
+/**
+ * Enables or disables the removal of duplicate constraints before solving
+ * problems with the given instance. Removing duplicates shrinks problems that
+ * contain many parallel constraints, but costs an extra pass with a hash table
+ * over every problem. Instances are created with presolving disabled.
+ */
+void LP2D_EXPORT linprog2d_set_presolve(linprog2d_t *prog, int presolve);
+
+/**
+ * Returns the number of constraints that were removed from the problem passed
+ * to the last call to linprog2d_solve() because a parallel constraint with the
+ * same normal direction and a tighter offset was present. Always zero unless
+ * presolving has been enabled with linprog2d_set_presolve().
+ */
+unsigned int LP2D_EXPORT linprog2d_presolve_removed(const linprog2d_t *prog);
+
 /**
  * Convenience function which allocates a new linprog2d_t instance, calls
  * its solve function, destroys the instance and returns the result. If you
@@ -176,6 +868,159 @@ linprog2d_result_t LP2D_EXPORT linprog2d_solve_simple(double cx, double cy,
                                                       const double *Gy,
                                                       const double *h,
                                                       unsigned int n);
+
+/**
+ * Computes the number of bytes required to store a linprog2d_region instance
+ * with the given capacity.
+ */
+linprog2d_size_t LP2D_EXPORT linprog2d_region_mem_size(unsigned int capacity);
+
+/**
+ * Creates a new linprog2d_region instance that can be prepared from at most
+ * capacity constraints. The returned pointer must be freed using
+ * linprog2d_region_free. Returns null if a failure occurs or the library has
+ * been compiled with the LINPROG2D_NO_ALLOC flag.
+ */
+linprog2d_region_t LP2D_EXPORT *linprog2d_region_create(unsigned int capacity);
+
+/**
+ * Frees a previously created linprog2d_region instance.
+ */
+void LP2D_EXPORT linprog2d_region_free(linprog2d_region_t *region);
+
+/**
+ * Computes the number of bytes required to store a linprog2d_dynamic instance
+ * with the given capacity.
+ */
+linprog2d_size_t LP2D_EXPORT linprog2d_dynamic_mem_size(unsigned int capacity);
+
+/**
+ * Creates a new, empty dynamic constraint set that can hold at most capacity
+ * constraints and minimizes cx * x + cy * y. The returned pointer must be
+ * freed using linprog2d_dynamic_free. Returns null if a failure occurs or the
+ * library has been compiled with the LINPROG2D_NO_ALLOC flag.
+ */
+linprog2d_dynamic_t LP2D_EXPORT *linprog2d_dynamic_create(unsigned int capacity,
+                                                          double cx, double cy);
+
+/**
+ * Frees a previously created linprog2d_dynamic instance.
+ */
+void LP2D_EXPORT linprog2d_dynamic_free(linprog2d_dynamic_t *dyn);
+
+/**
+ * Computes the number of bytes required to store a linprog2d_window instance
+ * with the given width.
+ */
+linprog2d_size_t LP2D_EXPORT linprog2d_window_mem_size(unsigned int width);
+
+/**
+ * Creates a new, empty sliding window holding at most width constraints that
+ * minimizes cx * x + cy * y. The returned pointer must be freed using
+ * linprog2d_window_free. Returns null if a failure occurs or the library has
+ * been compiled with the LINPROG2D_NO_ALLOC flag.
+ */
+linprog2d_window_t LP2D_EXPORT *linprog2d_window_create(unsigned int width,
+                                                        double cx, double cy);
+
+/**
+ * Frees a previously created linprog2d_window instance.
+ */
+void LP2D_EXPORT linprog2d_window_free(linprog2d_window_t *win);
+
+/**
+ * Computes the number of bytes required to store a linprog2d_kinetic instance
+ * with the given capacity.
+ */
+linprog2d_size_t LP2D_EXPORT linprog2d_kinetic_mem_size(unsigned int capacity);
+
+/**
+ * Creates a new linprog2d_kinetic instance that can hold problems with at most
+ * capacity constraints. The returned pointer must be freed using
+ * linprog2d_kinetic_free. Returns null if a failure occurs or the library has
+ * been compiled with the LINPROG2D_NO_ALLOC flag.
+ */
+linprog2d_kinetic_t LP2D_EXPORT *linprog2d_kinetic_create(unsigned int capacity);
+
+/**
+ * Frees a previously created linprog2d_kinetic instance.
+ */
+void LP2D_EXPORT linprog2d_kinetic_free(linprog2d_kinetic_t *kin);
+
+/**
+ * Computes the number of bytes required to store a linprog2d_sampling instance
+ * with the given capacity. The required memory grows with the square root of
+ * the capacity.
+ */
+linprog2d_size_t LP2D_EXPORT linprog2d_sampling_mem_size(unsigned int capacity);
+
+/**
+ * Creates a new linprog2d_sampling instance that can solve problems with at
+ * most capacity constraints. The returned pointer must be freed using
+ * linprog2d_sampling_free. Returns null if a failure occurs or the library has
+ * been compiled with the LINPROG2D_NO_ALLOC flag.
+ */
+linprog2d_sampling_t LP2D_EXPORT *linprog2d_sampling_create(
+    unsigned int capacity);
+
+/**
+ * Frees a previously created linprog2d_sampling instance.
+ */
+void LP2D_EXPORT linprog2d_sampling_free(linprog2d_sampling_t *smp);
+
+/**
+ * Computes the number of bytes required to store a linprog2d_cutting instance
+ * with the given capacity.
+ */
+linprog2d_size_t LP2D_EXPORT linprog2d_cutting_mem_size(unsigned int capacity);
+
+/**
+ * Creates a new linprog2d_cutting instance with an active set of at most
+ * capacity constraints. The returned pointer must be freed using
+ * linprog2d_cutting_free. Returns null if a failure occurs or the library has
+ * been compiled with the LINPROG2D_NO_ALLOC flag.
+ */
+linprog2d_cutting_t LP2D_EXPORT *linprog2d_cutting_create(unsigned int capacity);
+
+/**
+ * Frees a previously created linprog2d_cutting instance.
+ */
+void LP2D_EXPORT linprog2d_cutting_free(linprog2d_cutting_t *cut);
+
+/**
+ * Computes the number of bytes required to store a linprog2d_cache instance
+ * with the given number of entries and capacity. The cache stores a copy of
+ * each problem, so the required memory grows with entries * capacity.
+ */
+linprog2d_size_t LP2D_EXPORT linprog2d_cache_mem_size(unsigned int entries,
+                                                      unsigned int capacity);
+
+/**
+ * Creates a new, empty linprog2d_cache instance holding at most entries
+ * problems with at most capacity constraints each. The returned pointer must be
+ * freed using linprog2d_cache_free. Returns null if a failure occurs or the
+ * library has been compiled with the LINPROG2D_NO_ALLOC flag.
+ */
+linprog2d_cache_t LP2D_EXPORT *linprog2d_cache_create(unsigned int entries,
+                                                      unsigned int capacity);
+
+/**
+ * Frees a previously created linprog2d_cache instance.
+ */
+void LP2D_EXPORT linprog2d_cache_free(linprog2d_cache_t *cache);
+
+/**
+ * Creates a new linprog2d_batch instance that can hold problems with at most
+ * capacity constraints. The returned pointer must be freed using
+ * linprog2d_batch_free. Returns null if a failure occurs or the library has
+ * been compiled with the LINPROG2D_NO_ALLOC flag.
+ */
+linprog2d_batch_t LP2D_EXPORT *linprog2d_batch_create(unsigned int capacity);
+
+/**
+ * Frees a previously created linprog2d_batch instance.
+ */
+void LP2D_EXPORT linprog2d_batch_free(linprog2d_batch_t *batch);
 #endif /* LINPROG2D_REDUCED_INTERFACE */
 
 #ifdef __cplusplus
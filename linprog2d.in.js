@@ -20,7 +20,9 @@
  * @file linprog2d.js
  *
  * JavaScript implementation of 2D linear programming. Uses the C library in
- * this repository compiled to WebAssembly.
+ * this repository compiled to WebAssembly. Under Node.js, the native addon
+ * linprog2d.node ("make node") is used instead if it is found next to this
+ * script; set the environment variable LINPROG2D_NATIVE=0 to disable this.
  *
  * @author Andreas Stöckel
  */
@@ -29,13 +31,65 @@ this.linprog2d = (function(global) {
 	'use strict';
 
 	/* Base64 encoded WASM code gets injected here. Run "make wasm" to build the
-	   final JavaScript file. */
+	   final JavaScript file. The sidecar build leaves the string empty and
+	   loads the module from a separate linprog2d.wasm file instead. */
 	const WASM_CODE = '<_WASM_CODE_HERE_>';
 
+	/* Whether we are running in Node.js */
+	const _is_node = (typeof process !== 'undefined') && !!process.versions &&
+	                 !!process.versions.node;
+
+	/* URL of this script in browsers, captured while it is being executed */
+	const _script_url = (typeof document !== 'undefined' &&
+	                     document.currentScript) ? document.currentScript.src : null;
+
+	/* Returns the location of the given sidecar file; next to this script by
+	   default */
+	function _sidecar(file) {
+		if (_is_node) {
+			const dir = (typeof __dirname !== 'undefined') ? __dirname : '.';
+			return dir + '/' + file;
+		} else if (_script_url) {
+			return new URL(file, _script_url).href;
+		}
+		return file;
+	}
+
+	/* Whether the WebAssembly engine supports SIMD128. Validates a minimal
+	   module containing a v128 instruction. */
+	const _has_simd = WebAssembly.validate(new Uint8Array([
+		0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10,
+		1, 8, 0, 65, 0, 253, 15, 253, 98, 11]));
+
+	/* Native Node.js addon providing the same functions, or null */
+	const _addon = (function() {
+		if (!_is_node || typeof require === 'undefined' ||
+		    process.env.LINPROG2D_NATIVE === '0') {
+			return null;
+		}
+		try {
+			return require(_sidecar('linprog2d.node'));
+		} catch (e) {
+			return null;
+		}
+	})();
+
 	/**
 	 * Decodes a base64 string into a Uint8Array.
 	 */
 	function _decode_base64(s) {
+		/* Use the native decoders where available */
+		if (typeof Buffer !== 'undefined') {
+			const buf = Buffer.from(s, 'base64');
+			return new Uint8Array(buf.buffer, buf.byteOffset, buf.length);
+		} else if (typeof atob !== 'undefined') {
+			const bin = atob(s), data = new Uint8Array(bin.length);
+			for (let i = 0; i < bin.length; i++) {
+				data[i] = bin.charCodeAt(i);
+			}
+			return data;
+		}
+
 		/* Determine the length of the encoded string */
 		let len = Math.ceil(s.length / 4 * 3) | 0;
 		if (s.charAt(s.length - 1) == '=') { len--; };
@@ -64,22 +118,216 @@ this.linprog2d = (function(global) {
 		return data;
 	}
 
+	/**
+	 * Fetches the sidecar module from the given path or URL and compiles it.
+	 * Browsers compile the module while it is being downloaded.
+	 */
+	function _compile_file(file) {
+		if (_is_node) {
+			/* The file is small; reading it synchronously avoids waiting for
+			   the thread pool in short-lived processes */
+			return new Promise(resolve => resolve(require('fs').readFileSync(file)))
+				.then(buf => WebAssembly.compile(buf));
+		}
+		const res = fetch(file);
+		if (WebAssembly.compileStreaming) {
+			/* Streaming compilation requires the application/wasm MIME type;
+			   fall back to compiling the downloaded bytes otherwise. */
+			return WebAssembly.compileStreaming(res).catch(
+				() => fetch(file).then(r => r.arrayBuffer()).then(
+					buf => WebAssembly.compile(buf)));
+		}
+		return res.then(r => r.arrayBuffer()).then(
+			buf => WebAssembly.compile(buf));
+	}
+
 	let _module; /* WASM module instance. */
 	let _memory; /* Global memory space used in the module. */
+	let _compiled = null;
 	let _init = null;
+	let _native = null; /* The addon once init() has selected it */
+
+	/* The first pages hold the static data of the module; the workspace
+	   starts after them. */
+	const WORKSPACE_OFFS = 0x80000, PAGE_SIZE = 0x10000;
+
+	/* Sizes of linprog2d_problem_t and linprog2d_result_t in wasm32 */
+	const PROBLEM_SIZE = 32, RESULT_SIZE = 40;
+
+	/* The workspace consists of two regions. The batch region holds the
+	   problems passed to solve_batch(); it only moves when batch() is called.
+	   The solver region follows it and holds the input arrays of solve() and a
+	   linprog2d_batch instance for at most _capacity constraints.
+	   Both solve() and solve_batch() use this instance. Until batch() is
+	   called, the batch region is empty and the solver region starts at
+	   WORKSPACE_OFFS. */
+	let _batch_m = 0, _batch_total = 0;
+	let _c_ptr = WORKSPACE_OFFS, _n_ptr = WORKSPACE_OFFS;
+	let _problems_ptr = WORKSPACE_OFFS, _results_ptr = WORKSPACE_OFFS;
+	let _bGx_ptr = WORKSPACE_OFFS, _bGy_ptr = WORKSPACE_OFFS;
+	let _bh_ptr = WORKSPACE_OFFS;
+	let _capacity = 0, _inst = 0, _Gx_ptr = 0, _Gy_ptr = 0, _h_ptr = 0;
+	let _problem_ptr = 0, _res_ptr = 0;
+	let _batch = null; /* Object returned by the last call to batch() */
+
+	/* Views onto the memory; recreated whenever the memory has grown. */
+	let _mf64 = null, _mu32 = null;
+
+	/**
+	 * Returns the smallest multiple of 64 greater or equal to x.
+	 */
+	function _align64(x) {
+		return Math.ceil(x / 64) * 64;
+	}
+
+	/**
+	 * Makes sure the memory views refer to the current buffer.
+	 */
+	function _update_views() {
+		if (!_mf64 || _mf64.buffer !== _memory.buffer) {
+			_mf64 = new Float64Array(_memory.buffer);
+			_mu32 = new Uint32Array(_memory.buffer);
+		}
+	}
+
+	/**
+	 * Computes the location of the solver region for the given capacity,
+	 * grows the memory if required, and recreates the solver instance.
+	 */
+	function _layout(capacity) {
+		const Gx_ptr = _bh_ptr + _align64(_batch_total * 8);
+		const Gy_ptr = Gx_ptr + _align64(capacity * 8);
+		const h_ptr = Gy_ptr + _align64(capacity * 8);
+		const problem_ptr = h_ptr + _align64(capacity * 8);
+		const res_ptr = problem_ptr + _align64(PROBLEM_SIZE);
+		const inst_ptr = res_ptr + _align64(RESULT_SIZE);
+		const end = inst_ptr + _module._linprog2d_batch_mem_size(capacity);
+
+		/* Grow the memory; this fails if the address space is exhausted */
+		const pages = Math.ceil(end / PAGE_SIZE) - _memory.buffer.byteLength / PAGE_SIZE;
+		if (pages > 0) {
+			try {
+				_memory.grow(pages);
+			} catch (e) {
+				throw 'Out of memory';
+			}
+		}
+
+		_capacity = capacity;
+		_Gx_ptr = Gx_ptr, _Gy_ptr = Gy_ptr, _h_ptr = h_ptr;
+		_problem_ptr = problem_ptr, _res_ptr = res_ptr;
+		_inst = _module._linprog2d_batch_init(capacity, inst_ptr);
+		_update_views();
+	}
+
+	/**
+	 * Makes sure the solver instance can hold a problem with n constraints.
+	 * Grows the capacity geometrically.
+	 */
+	function _reserve(n) {
+		if (n > _capacity) {
+			_layout(Math.max(n, 2 * _capacity, 64));
+		}
+		_update_views();
+	}
+
+	/**
+	 * Writes a linprog2d_problem_t structure to the given location.
+	 */
+	function _write_problem(ptr, cx, cy, Gx_ptr, Gy_ptr, h_ptr, n) {
+		_mf64[ptr / 8 + 0] = cx;
+		_mf64[ptr / 8 + 1] = cy;
+		_mu32[ptr / 4 + 4] = Gx_ptr;
+		_mu32[ptr / 4 + 5] = Gy_ptr;
+		_mu32[ptr / 4 + 6] = h_ptr;
+		_mu32[ptr / 4 + 7] = n;
+	}
+
+	/**
+	 * Copies the linprog2d_result_t structure at the given location to the
+	 * record with index i in out.
+	 */
+	function _read_result(ptr, out, i) {
+		out[5 * i + 0] = _mf64[ptr / 8 + 0];
+		out[5 * i + 1] = _mf64[ptr / 8 + 1];
+		out[5 * i + 2] = _mf64[ptr / 8 + 2];
+		out[5 * i + 3] = _mf64[ptr / 8 + 3];
+		out[5 * i + 4] = _mu32[ptr / 4 + 8];
+	}
+
+	/**
+	 * Compiles the WASM module without instantiating it. Returns a promise for
+	 * the WebAssembly.Module; the module is cached and may be passed to init()
+	 * in this or another context (for example a worker) to skip compilation.
+	 * The source is either the module itself, its code as an ArrayBuffer or a
+	 * typed array, or the path or URL of the sidecar file. If no source is
+	 * given, the embedded code is used if available, otherwise the sidecar
+	 * file linprog2d.wasm located next to this script. The SIMD build
+	 * ("make wasm-simd") is only used if its path is passed explicitly, e.g.
+	 * compile(linprog2d.SIMD ? 'linprog2d.simd.wasm' : undefined); it is not
+	 * consistently faster than the scalar build. If no source is given and the
+	 * native addon is available, nothing is compiled and the promise resolves
+	 * to null.
+	 */
+	function compile(source) {
+		if (!_compiled) {
+			if (!source && _addon) {
+				_compiled = Promise.resolve(null);
+			} else if (source instanceof WebAssembly.Module) {
+				_compiled = Promise.resolve(source);
+			} else if (source instanceof ArrayBuffer ||
+			           ArrayBuffer.isView(source)) {
+				_compiled = WebAssembly.compile(source);
+			} else if (!source && WASM_CODE) {
+				_compiled = WebAssembly.compile(_decode_base64(WASM_CODE));
+			} else if (source) {
+				_compiled = _compile_file(source);
+			} else {
+				_compiled = _compile_file(_sidecar('linprog2d.wasm'));
+			}
+		}
+		return _compiled;
+	}
+
+	/**
+	 * Implementations of the C library functions the compiler may emit calls
+	 * to (for example for structure copies), under both the prefixed and the
+	 * plain symbol name. Addresses are unsigned 32-bit offsets into _memory.
+	 */
+	function _libc_imports() {
+		const bytes = () => new Uint8Array(_memory.buffer);
+		const memmove = (dst, src, n) => {
+			bytes().copyWithin(dst >>> 0, src >>> 0, (src >>> 0) + (n >>> 0));
+			return dst;
+		};
+		const memset = (dst, c, n) => {
+			bytes().fill(c & 0xFF, dst >>> 0, (dst >>> 0) + (n >>> 0));
+			return dst;
+		};
+		return {
+			'_memcpy': memmove, 'memcpy': memmove,
+			'_memmove': memmove, 'memmove': memmove,
+			'_memset': memset, 'memset': memset
+		};
+	}
 
 	/**
 	 * Loads and initialises the WASM module. Returns a promise which, for
-	 * convenience, provides a reference at the solve() function.
+	 * convenience, provides a reference at the solve() function. The optional
+	 * source is passed to compile(); without a source, the native addon is
+	 * used if it is available.
 	 */
-	function init() {
-		if (!_init) {
+	function init(source) {
+		if (!_init && !source && _addon) {
+			_native = _addon;
+			_init = _native.init().then(() => solve);
+		} else if (!_init) {
 			/* Instantiate the global memory object. */
-			_memory = new WebAssembly.Memory({ initial: 256, maximum: 256 });
+			_memory = new WebAssembly.Memory({ initial: 256 });
 
 			/* Compile and instantiate the WASM code. */
-			_init = WebAssembly.instantiate(_decode_base64(WASM_CODE), {
-				'env': {
+			_init = compile(source).then(module => WebAssembly.instantiate(module, {
+				'env': Object.assign({
 					'table': new WebAssembly.Table({
 						'initial': 8,
 						'element': 'anyfunc'
@@ -88,13 +336,13 @@ this.linprog2d = (function(global) {
 					'memory': _memory,
 					'memoryBase': 0,
 					'abort': (i) => { throw null; }
-				},
+				}, _libc_imports()),
 				'global': {
 					'Infinity': Infinity
 				}
-			}).then(module => {
+			})).then(instance => {
 				/* Store the module in the global variable */
-				_module = module.instance.exports;
+				_module = instance.exports;
 
 				/* Run post-initialisation code */
 				_module.__post_instantiate();
@@ -124,31 +372,32 @@ this.linprog2d = (function(global) {
 	 * }
 	 */
 	function solve(cx, cy, Gx, Gy, h) {
+		if (_native) {
+			return _native.solve(cx, cy, Gx, Gy, h);
+		}
+
 		/* Make sure the input is valid */
 		if ((Gx.length != Gy.length) || (Gy.length != h.length)) {
 			throw 'Invalid input';
 		}
 
-		/* Compute all target pointers */
-		const n = Gx.length, offs = 0x80000; /* skip the first page */
-		const Gx_ptr = offs, Gy_ptr = Gx_ptr + n * 8;
-		const h_ptr = Gy_ptr + n * 8, res_ptr = h_ptr + n * 8;
-		const base_ptr = res_ptr + 5 * 8;
+		/* Make sure the workspace is large enough */
+		const n = Gx.length;
+		_reserve(n);
 
 		/* Copy the input to the WebAssembly memory */
-		const mu32 = new Uint32Array(_memory.buffer);
-		const mf64 = new Float64Array(_memory.buffer);
+		const mf64 = _mf64, mu32 = _mu32;
+		const Gx_ptr = _Gx_ptr, Gy_ptr = _Gy_ptr, h_ptr = _h_ptr;
+		const res_ptr = _res_ptr;
 		for (let i = 0; i < n; i++) {
 			mf64[Gx_ptr / 8 + i] = Gx[i];
 			mf64[Gy_ptr / 8 + i] = Gy[i];
 			mf64[h_ptr / 8 + i] = h[i];
 		}
 
-		/* Instantiate the linprog2d instance */
-		const prog = _module._linprog2d_init(n, base_ptr);
-
 		/* Solve the problem */
-		_module._linprog2d_solve(res_ptr, prog, cx, cy, Gx_ptr, Gy_ptr, h_ptr, n);
+		_write_problem(_problem_ptr, cx, cy, Gx_ptr, Gy_ptr, h_ptr, n);
+		_module._linprog2d_batch_solve(_inst, _problem_ptr, res_ptr, 1);
 
 		/* Read the result */
 		return {
@@ -160,9 +409,170 @@ this.linprog2d = (function(global) {
 		}
 	}
 
+	/**
+	 * Reserves WebAssembly memory for a batch of m problems with a total of
+	 * total constraints and returns an object providing views onto it. The
+	 * caller writes the problems directly into these views and then calls
+	 * solve() on the returned object, which is equivalent to calling
+	 * solve_batch() with the views as arguments but does not copy the input.
+	 * The object has the following properties:
+	 * {
+	 *     'c': <Float64Array of length 2 * m; gradients cx, cy of the problems>,
+	 *     'n': <Uint32Array of length m; number of constraints per problem>,
+	 *     'Gx', 'Gy', 'h': <Float64Array of length total; the constraints of
+	 *                       all problems one after another>,
+	 *     'solve': <function(out) solving all problems, see solve_batch()>
+	 * }
+	 * Growing the memory invalidates typed arrays; the properties always
+	 * return views onto the current memory, so they should be accessed again
+	 * after calling solve() or solve_batch(). There is a single batch region;
+	 * calling batch() again invalidates the previous object and its contents.
+	 * This function must only be called after init() has completed.
+	 */
+	function batch(m, total) {
+		if (_native) {
+			/* The addon reads the arrays in place */
+			const b = {
+				'c': new Float64Array(2 * m),
+				'n': new Uint32Array(m),
+				'Gx': new Float64Array(total),
+				'Gy': new Float64Array(total),
+				'h': new Float64Array(total),
+				'solve': (out) => _native.solve_batch(b.c, b.n, b.Gx, b.Gy, b.h, out)
+			};
+			return b;
+		}
+
+		/* Place the batch region at the start of the workspace and move the
+		   solver region behind it */
+		_c_ptr = WORKSPACE_OFFS;
+		_n_ptr = _c_ptr + _align64(m * 16);
+		_problems_ptr = _n_ptr + _align64(m * 4);
+		_results_ptr = _problems_ptr + _align64(m * PROBLEM_SIZE);
+		_bGx_ptr = _results_ptr + _align64(m * RESULT_SIZE);
+		_bGy_ptr = _bGx_ptr + _align64(total * 8);
+		_bh_ptr = _bGy_ptr + _align64(total * 8);
+		_batch_m = m, _batch_total = total;
+		_layout(Math.max(_capacity, 64));
+
+		const b = {
+			'solve': (out) => _solve_batch(b, m, total, out)
+		};
+		const view = (type, ptr, len) => () => {
+			if (b !== _batch) {
+				throw 'Invalid batch';
+			}
+			_update_views();
+			return new type(_memory.buffer, ptr, len);
+		};
+		Object.defineProperty(b, 'c', {get: view(Float64Array, _c_ptr, 2 * m)});
+		Object.defineProperty(b, 'n', {get: view(Uint32Array, _n_ptr, m)});
+		Object.defineProperty(b, 'Gx', {get: view(Float64Array, _bGx_ptr, total)});
+		Object.defineProperty(b, 'Gy', {get: view(Float64Array, _bGy_ptr, total)});
+		Object.defineProperty(b, 'h', {get: view(Float64Array, _bh_ptr, total)});
+		_batch = b;
+		return b;
+	}
+
+	/**
+	 * Solves the problems in the batch region in a single call into the
+	 * WebAssembly module.
+	 */
+	function _solve_batch(b, m, total, out) {
+		if (b !== _batch) {
+			throw 'Invalid batch';
+		}
+		_update_views();
+
+		/* Check the problem sizes and find the largest problem */
+		let max_n = 0, offs = 0;
+		for (let i = 0; i < m; i++) {
+			const n = _mu32[_n_ptr / 4 + i];
+			max_n = Math.max(max_n, n);
+			offs += n;
+		}
+		if (offs > total) {
+			throw 'Invalid input';
+		}
+		_reserve(max_n);
+
+		/* Fill in the problem descriptors and solve */
+		offs = 0;
+		for (let i = 0; i < m; i++) {
+			const n = _mu32[_n_ptr / 4 + i];
+			_write_problem(_problems_ptr + i * PROBLEM_SIZE,
+			               _mf64[_c_ptr / 8 + 2 * i], _mf64[_c_ptr / 8 + 2 * i + 1],
+			               _bGx_ptr + offs * 8, _bGy_ptr + offs * 8, _bh_ptr + offs * 8,
+			               n);
+			offs += n;
+		}
+		_module._linprog2d_batch_solve(_inst, _problems_ptr, _results_ptr, m);
+
+		/* Convert the results to records */
+		out = out || new Float64Array(5 * m);
+		for (let i = 0; i < m; i++) {
+			_read_result(_results_ptr + i * RESULT_SIZE, out, i);
+		}
+		return out;
+	}
+
+	/**
+	 * Solves m = n.length problems in a single call into the WebAssembly
+	 * module. c is an array of length 2 * m containing the gradients cx, cy of
+	 * the problems, n contains the number of constraints in each problem, and
+	 * Gx, Gy, h contain the constraints of all problems one after another. The
+	 * inputs are copied as a whole if they are typed arrays; use batch() to
+	 * avoid the copy. The native addon reads Float64Array (and, for n,
+	 * Uint32Array) inputs in place. Returns a Float64Array of m records (x1,
+	 * y1, x2, y2, status), written to out if given. This function must only be
+	 * called after init() has completed.
+	 */
+	function solve_batch(c, n, Gx, Gy, h, out) {
+		if (_native) {
+			return _native.solve_batch(c, n, Gx, Gy, h, out);
+		}
+		const m = n.length, total = Gx.length;
+		if ((c.length != 2 * m) || (Gy.length != total) || (h.length != total)) {
+			throw 'Invalid input';
+		}
+		if (!_batch || m > _batch_m || total > _batch_total) {
+			batch(Math.max(m, 2 * _batch_m), Math.max(total, 2 * _batch_total));
+		}
+		const b = _batch;
+		b.c.set(c);
+		b.n.set(n);
+		b.Gx.set(Gx);
+		b.Gy.set(Gy);
+		b.h.set(h);
+		if (m < _batch_m) {
+			/* Solve only the first m problems */
+			return _solve_batch(b, m, total, out);
+		}
+		return b.solve(out);
+	}
+
+	/**
+	 * Same as solve_batch(), but returns a promise for the results. The native
+	 * addon solves the batch on the libuv thread pool without blocking the
+	 * event loop; the input arrays must not be modified until the promise has
+	 * settled. Without the addon, the batch is solved on the main thread.
+	 */
+	function solve_batch_async(c, n, Gx, Gy, h) {
+		if (_native) {
+			return _native.solve_batch_async(c, n, Gx, Gy, h);
+		}
+		return new Promise(resolve => resolve(solve_batch(c, n, Gx, Gy, h)));
+	}
+
 	return {
+		'compile': compile,
 		'init': init,
 		'solve': solve,
+		'batch': batch,
+		'solve_batch': solve_batch,
+		'solve_batch_async': solve_batch_async,
+		'SIMD': _has_simd,
+		'NATIVE': !!_addon,
 		'ERROR': 0,
 		'INFEASIBLE': 1,
 		'UNBOUNDED': 2,
@@ -0,0 +1,200 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/bench_async.c
+ *
+ * Compares solving a set of problems with linprog2d_solve on the calling
+ * thread against submitting them to the asynchronous worker pool, once
+ * polling for completion and once using completion callbacks. The results
+ * of the asynchronous runs are checked against the synchronous ones. Results
+ * are written to stdout as a JSON array with one object per run.
+ *
+ * Usage: bench_async [-j threads] [-m problems] [-n constraints]
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "../tools/linprog2d_async.h"
+
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * Helper functions                                                           *
+ ******************************************************************************/
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+static double bench_rand(unsigned long int *state) {
+	*state = (*state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+	return (double)(*state) / (double)0x40000000UL - 1.0;
+}
+
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static int bench_first = 1;
+
+static void bench_report(const char *name, unsigned int m, unsigned int n,
+                         double seconds, unsigned int n_mismatch) {
+	printf("%s\n  {\"benchmark\": \"%s\", \"problems\": %u, \"n\": %u, "
+	       "\"seconds\": %.6f, \"problems_per_second\": %.1f, "
+	       "\"mismatches\": %u}",
+	       bench_first ? "" : ",", name, m, n, seconds,
+	       (seconds > 0.0) ? (double)m / seconds : 0.0, n_mismatch);
+	bench_first = 0;
+}
+
+static int bench_match(linprog2d_result_t a, linprog2d_result_t b) {
+	return a.status == b.status && a.x1 == b.x1 && a.y1 == b.y1 &&
+	       a.x2 == b.x2 && a.y2 == b.y2;
+}
+
+/* Number of jobs completed through the callback */
+static unsigned int n_completed = 0U;
+
+static void bench_callback(linprog2d_async_job_t *job) {
+	(void)job;
+	__atomic_add_fetch(&n_completed, 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * Submits all jobs, retrying while the queue is full, and waits until all of
+ * them have completed.
+ */
+static double bench_async(linprog2d_async_t *a, linprog2d_async_job_t *jobs,
+                          unsigned int m, int use_callback) {
+	unsigned int i;
+	double t0 = bench_now();
+	__atomic_store_n(&n_completed, 0U, __ATOMIC_RELEASE);
+	for (i = 0U; i < m; i++) {
+		jobs[i].callback = use_callback ? bench_callback : NULL;
+		while (!linprog2d_async_submit(a, &jobs[i])) {
+			sched_yield();
+		}
+	}
+	if (use_callback) {
+		while (__atomic_load_n(&n_completed, __ATOMIC_ACQUIRE) < m) {
+			sched_yield();
+		}
+	} else {
+		for (i = 0U; i < m; i++) {
+			while (!linprog2d_async_done(&jobs[i])) {
+				sched_yield();
+			}
+		}
+	}
+	return bench_now() - t0;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+int main(int argc, char *argv[]) {
+	unsigned int i, m = 10000U, n = 256U, n_mismatch, n_total = 0U;
+	unsigned int n_threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned long int j, seed = 4917UL;
+	double *Gx, *Gy, *h, t0;
+	linprog2d_async_job_t *jobs;
+	linprog2d_result_t *expected;
+	linprog2d_async_t *a;
+	linprog2d_t *prog;
+	int opt, pass;
+
+	while ((opt = getopt(argc, argv, "j:m:n:")) != -1) {
+		if (opt == 'j' && atoi(optarg) > 0) {
+			n_threads = (unsigned int)atoi(optarg);
+		} else if (opt == 'm' && atoi(optarg) > 0) {
+			m = (unsigned int)atoi(optarg);
+		} else if (opt == 'n' && atoi(optarg) > 0) {
+			n = (unsigned int)atoi(optarg);
+		} else {
+			fprintf(stderr, "Usage: %s [-j threads] [-m problems] "
+			                "[-n constraints]\n",
+			        argv[0]);
+			return 1;
+		}
+	}
+	n_threads = (n_threads > 0U) ? n_threads : 1U;
+
+	j = (unsigned long int)m * n;
+	Gx = (double *)malloc(sizeof(double) * j);
+	Gy = (double *)malloc(sizeof(double) * j);
+	h = (double *)malloc(sizeof(double) * j);
+	jobs = (linprog2d_async_job_t *)calloc(m, sizeof(linprog2d_async_job_t));
+	expected = (linprog2d_result_t *)malloc(sizeof(linprog2d_result_t) * m);
+	prog = linprog2d_create(n);
+	a = linprog2d_async_create(n_threads, 1024U, n);
+	if (!Gx || !Gy || !h || !jobs || !expected || !prog || !a) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	for (j = 0UL; j < (unsigned long int)m * n; j++) {
+		Gx[j] = bench_rand(&seed);
+		Gy[j] = bench_rand(&seed);
+		h[j] = -(0.1 + fabs(bench_rand(&seed)));
+	}
+	for (i = 0U; i < m; i++) {
+		jobs[i].cx = bench_rand(&seed), jobs[i].cy = bench_rand(&seed);
+		jobs[i].Gx = Gx + (unsigned long int)i * n;
+		jobs[i].Gy = Gy + (unsigned long int)i * n;
+		jobs[i].h = h + (unsigned long int)i * n;
+		jobs[i].n = n;
+	}
+
+	printf("[");
+	t0 = bench_now();
+	for (i = 0U; i < m; i++) {
+		expected[i] = linprog2d_solve(prog, jobs[i].cx, jobs[i].cy, jobs[i].Gx,
+		                              jobs[i].Gy, jobs[i].h, jobs[i].n);
+	}
+	bench_report("sync", m, n, bench_now() - t0, 0U);
+
+	for (pass = 0; pass < 2; pass++) {
+		t0 = bench_async(a, jobs, m, pass);
+		for (i = 0U, n_mismatch = 0U; i < m; i++) {
+			n_mismatch += bench_match(jobs[i].result, expected[i]) ? 0U : 1U;
+		}
+		bench_report(pass ? "async_callback" : "async_poll", m, n, t0,
+		             n_mismatch);
+		n_total += n_mismatch;
+	}
+	printf("\n]\n");
+
+	linprog2d_async_free(a);
+	linprog2d_free(prog);
+	free(expected);
+	free(jobs);
+	free(h);
+	free(Gy);
+	free(Gx);
+	return n_total ? 1 : 0;
+}
@@ -0,0 +1,225 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file test/bench_capture.c
+ *
+ * Measures the cost of problem capture while several threads solve problems:
+ * once without capture, once writing the capture file on the solving threads
+ * with linprog2d_capture_start(), and once with the background writer from
+ * tools/linprog2d_capture.c. Checks that each capture file contains one
+ * record per solved (and not dropped) problem. Results are written to stdout
+ * as a JSON array with one object per run.
+ *
+ * Usage: bench_capture [-j threads] [-m problems] [-n constraints]
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "../tools/linprog2d_capture.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * Helper functions                                                           *
+ ******************************************************************************/
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+static double bench_rand(unsigned long int *state) {
+	*state = (*state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+	return (double)(*state) / (double)0x40000000UL - 1.0;
+}
+
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static int bench_first = 1;
+
+static void bench_report(const char *name, unsigned int m, unsigned int n,
+                         double seconds, unsigned long int n_records,
+                         unsigned long int n_dropped) {
+	printf("%s\n  {\"benchmark\": \"%s\", \"problems\": %u, \"n\": %u, "
+	       "\"seconds\": %.6f, \"problems_per_second\": %.1f, "
+	       "\"records\": %lu, \"dropped\": %lu}",
+	       bench_first ? "" : ",", name, m, n, seconds,
+	       (seconds > 0.0) ? (double)m / seconds : 0.0, n_records, n_dropped);
+	bench_first = 0;
+}
+
+/**
+ * Counts the records in a capture file, or returns -1 if it is malformed.
+ */
+static long int bench_count_records(const char *filename) {
+	unsigned int head[2];
+	double vals[7];
+	char magic[8];
+	long int n_records = 0L;
+	FILE *f = fopen(filename, "rb");
+	if (!f || fread(magic, 1U, 8U, f) != 8U) {
+		return -1L;
+	}
+	while (fread(head, sizeof(unsigned int), 2U, f) == 2U) {
+		if (fread(vals, sizeof(double), 7U, f) != 7U ||
+		    fseek(f, (long int)(3U * sizeof(double) * head[0]), SEEK_CUR) !=
+		        0) {
+			n_records = -1L;
+			break;
+		}
+		n_records++;
+	}
+	fclose(f);
+	return n_records;
+}
+
+/* Problems shared by all threads */
+static unsigned int m_problems, n_constraints;
+static double *Gx, *Gy, *h, *c;
+
+static void *worker_main(void *arg) {
+	linprog2d_t *prog = linprog2d_create(n_constraints);
+	unsigned long int offs;
+	unsigned int i;
+	(void)arg;
+	if (!prog) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	for (i = 0U; i < m_problems; i++) {
+		offs = (unsigned long int)i * n_constraints;
+		linprog2d_solve(prog, c[2U * i], c[2U * i + 1U], Gx + offs, Gy + offs,
+		                h + offs, n_constraints);
+	}
+	linprog2d_free(prog);
+	return NULL;
+}
+
+static double bench_run(unsigned int n_threads) {
+	pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * n_threads);
+	unsigned int i;
+	double t0 = bench_now();
+	if (!threads) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	for (i = 0U; i < n_threads; i++) {
+		if (pthread_create(&threads[i], NULL, worker_main, NULL) != 0) {
+			fprintf(stderr, "Cannot create thread\n");
+			exit(1);
+		}
+	}
+	for (i = 0U; i < n_threads; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	free(threads);
+	return bench_now() - t0;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+int main(int argc, char *argv[]) {
+	const char *filename = "bench_capture.bin";
+	unsigned int n_threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned long int j, n_dropped, n_total, seed = 4917UL;
+	linprog2d_capture_writer_t *writer;
+	int opt, ok = 1;
+	double t;
+
+	m_problems = 10000U, n_constraints = 64U;
+	while ((opt = getopt(argc, argv, "j:m:n:")) != -1) {
+		if (opt == 'j' && atoi(optarg) > 0) {
+			n_threads = (unsigned int)atoi(optarg);
+		} else if (opt == 'm' && atoi(optarg) > 0) {
+			m_problems = (unsigned int)atoi(optarg);
+		} else if (opt == 'n' && atoi(optarg) > 0) {
+			n_constraints = (unsigned int)atoi(optarg);
+		} else {
+			fprintf(stderr, "Usage: %s [-j threads] [-m problems] "
+			                "[-n constraints]\n",
+			        argv[0]);
+			return 1;
+		}
+	}
+	n_threads = (n_threads > 0U) ? n_threads : 1U;
+	n_total = (unsigned long int)m_problems * n_threads;
+
+	j = (unsigned long int)m_problems * n_constraints;
+	Gx = (double *)malloc(sizeof(double) * j);
+	Gy = (double *)malloc(sizeof(double) * j);
+	h = (double *)malloc(sizeof(double) * j);
+	c = (double *)malloc(sizeof(double) * 2U * m_problems);
+	if (!Gx || !Gy || !h || !c) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	for (j = 0UL; j < (unsigned long int)m_problems * n_constraints; j++) {
+		Gx[j] = bench_rand(&seed);
+		Gy[j] = bench_rand(&seed);
+		h[j] = -(0.1 + fabs(bench_rand(&seed)));
+	}
+	for (j = 0UL; j < 2UL * m_problems; j++) {
+		c[j] = bench_rand(&seed);
+	}
+
+	printf("[");
+	bench_report("no_capture", n_total, n_constraints, bench_run(n_threads),
+	             0UL, 0UL);
+
+	remove(filename);
+	if (!linprog2d_capture_start(filename)) {
+		fprintf(stderr, "Cannot open %s\n", filename);
+		return 1;
+	}
+	t = bench_run(n_threads);
+	linprog2d_capture_stop();
+	ok = ok && bench_count_records(filename) == (long int)n_total;
+	bench_report("capture_file", n_total, n_constraints, t,
+	             (unsigned long int)bench_count_records(filename), 0UL);
+
+	remove(filename);
+	if (!(writer = linprog2d_capture_writer_start(filename, 1UL << 24))) {
+		fprintf(stderr, "Cannot open %s\n", filename);
+		return 1;
+	}
+	t = bench_run(n_threads);
+	n_dropped = linprog2d_capture_writer_dropped(writer);
+	linprog2d_capture_writer_stop(writer);
+	ok = ok && bench_count_records(filename) == (long int)(n_total - n_dropped);
+	bench_report("capture_writer", n_total, n_constraints, t,
+	             (unsigned long int)bench_count_records(filename), n_dropped);
+	printf("\n]\n");
+	remove(filename);
+
+	free(c);
+	free(h);
+	free(Gy);
+	free(Gx);
+	return ok ? 0 : 1;
+}
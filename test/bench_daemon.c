@@ -0,0 +1,247 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/bench_daemon.c
+ *
+ * Load generator for the solve daemon. Each client thread opens its own
+ * connection and keeps a fixed number of requests in flight until it has
+ * received the given number of responses. The results of every response are
+ * compared against a local solve of the same problems. A JSON object with the
+ * throughput and latency is written to stdout.
+ *
+ * Usage: bench_daemon [-s socket] [-k clients] [-d depth] [-b batch]
+ *                     [-n constraints] [-r requests]
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "../tools/linprog2d_client.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * Helper functions                                                           *
+ ******************************************************************************/
+
+/* Default socket path, must match the daemon */
+#define DEFAULT_SOCKET "/tmp/linprog2d.sock"
+
+/* Maximum number of requests in flight per client */
+#define MAX_DEPTH 64U
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+static double bench_rand(unsigned long int *state) {
+	*state = (*state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+	return (double)(*state) / (double)0x40000000UL - 1.0;
+}
+
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/**
+ * Benchmark parameters and the problems sent in every request.
+ */
+struct bench {
+	const char *path;
+	unsigned int n_clients, depth, batch, n, n_requests;
+	double *Gx, *Gy, *h;
+	linprog2d_problem_t *problems;
+	linprog2d_result_t *expected;
+};
+
+/**
+ * State of a single client thread.
+ */
+struct client {
+	const struct bench *b;
+	double sent[MAX_DEPTH], latency;
+	unsigned int n_mismatch;
+	int ok;
+};
+
+static int bench_match(linprog2d_result_t a, linprog2d_result_t b) {
+	return a.status == b.status && a.x1 == b.x1 && a.y1 == b.y1 &&
+	       a.x2 == b.x2 && a.y2 == b.y2;
+}
+
+/******************************************************************************
+ * Client threads                                                             *
+ ******************************************************************************/
+
+static void *client_main(void *arg) {
+	struct client *c = (struct client *)arg;
+	const struct bench *b = c->b;
+	unsigned int i, id, m, n_sent = 0U, n_recv = 0U;
+	linprog2d_result_t *res;
+	linprog2d_client_t *conn;
+
+	res = (linprog2d_result_t *)malloc(sizeof(linprog2d_result_t) * b->batch);
+	if (!res || !(conn = linprog2d_client_connect(b->path))) {
+		free(res);
+		return NULL;
+	}
+
+	/* Keep depth requests in flight; ids are assigned sequentially */
+	while (n_recv < b->n_requests) {
+		while (n_sent < b->n_requests && n_sent - n_recv < b->depth) {
+			c->sent[n_sent % MAX_DEPTH] = bench_now();
+			if (!linprog2d_client_send(conn, b->problems, b->batch, &id)) {
+				goto out;
+			}
+			n_sent++;
+		}
+		if (!linprog2d_client_recv(conn, &id, res, b->batch, &m) ||
+		    m != b->batch) {
+			goto out;
+		}
+		c->latency += bench_now() - c->sent[id % MAX_DEPTH];
+		for (i = 0U; i < m; i++) {
+			c->n_mismatch += bench_match(res[i], b->expected[i]) ? 0U : 1U;
+		}
+		n_recv++;
+	}
+	c->ok = 1;
+out:
+	linprog2d_client_close(conn);
+	free(res);
+	return NULL;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+static void usage(const char *name) {
+	fprintf(stderr,
+	        "Usage: %s [-s socket] [-k clients] [-d depth] [-b batch] "
+	        "[-n constraints] [-r requests]\n",
+	        name);
+}
+
+int main(int argc, char *argv[]) {
+	struct bench b;
+	struct client *clients;
+	pthread_t *threads;
+	linprog2d_t *prog;
+	unsigned long int seed = 4917UL, j;
+	unsigned int i, n_mismatch = 0U, ok = 1U;
+	double t0, t1, latency = 0.0;
+	int opt;
+
+	b.path = DEFAULT_SOCKET;
+	b.n_clients = 4U, b.depth = 8U, b.batch = 64U, b.n = 64U;
+	b.n_requests = 1000U;
+	while ((opt = getopt(argc, argv, "s:k:d:b:n:r:")) != -1) {
+		if (opt == 's') {
+			b.path = optarg;
+		} else if (opt == 'k' && atoi(optarg) > 0) {
+			b.n_clients = (unsigned int)atoi(optarg);
+		} else if (opt == 'd' && atoi(optarg) > 0 &&
+		           atoi(optarg) <= (int)MAX_DEPTH) {
+			b.depth = (unsigned int)atoi(optarg);
+		} else if (opt == 'b' && atoi(optarg) > 0) {
+			b.batch = (unsigned int)atoi(optarg);
+		} else if (opt == 'n' && atoi(optarg) > 0) {
+			b.n = (unsigned int)atoi(optarg);
+		} else if (opt == 'r' && atoi(optarg) > 0) {
+			b.n_requests = (unsigned int)atoi(optarg);
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	/* Generate a batch of random problems and solve them locally */
+	j = (unsigned long int)b.batch * b.n;
+	b.Gx = (double *)malloc(sizeof(double) * j);
+	b.Gy = (double *)malloc(sizeof(double) * j);
+	b.h = (double *)malloc(sizeof(double) * j);
+	b.problems =
+	    (linprog2d_problem_t *)malloc(sizeof(linprog2d_problem_t) * b.batch);
+	b.expected =
+	    (linprog2d_result_t *)malloc(sizeof(linprog2d_result_t) * b.batch);
+	clients = (struct client *)calloc(b.n_clients, sizeof(struct client));
+	threads = (pthread_t *)calloc(b.n_clients, sizeof(pthread_t));
+	prog = linprog2d_create(b.n);
+	if (!b.Gx || !b.Gy || !b.h || !b.problems || !b.expected || !clients ||
+	    !threads || !prog) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	for (j = 0UL; j < (unsigned long int)b.batch * b.n; j++) {
+		b.Gx[j] = bench_rand(&seed);
+		b.Gy[j] = bench_rand(&seed);
+		b.h[j] = -(0.1 + fabs(bench_rand(&seed)));
+	}
+	for (i = 0U; i < b.batch; i++) {
+		linprog2d_problem_t *p = &b.problems[i];
+		p->cx = bench_rand(&seed), p->cy = bench_rand(&seed);
+		p->Gx = b.Gx + (unsigned long int)i * b.n;
+		p->Gy = b.Gy + (unsigned long int)i * b.n;
+		p->h = b.h + (unsigned long int)i * b.n;
+		p->n = b.n;
+		b.expected[i] = linprog2d_solve(prog, p->cx, p->cy, p->Gx, p->Gy,
+		                                p->h, p->n);
+	}
+
+	t0 = bench_now();
+	for (i = 0U; i < b.n_clients; i++) {
+		clients[i].b = &b;
+		pthread_create(&threads[i], NULL, client_main, &clients[i]);
+	}
+	for (i = 0U; i < b.n_clients; i++) {
+		pthread_join(threads[i], NULL);
+		ok = ok && clients[i].ok;
+		n_mismatch += clients[i].n_mismatch;
+		latency += clients[i].latency;
+	}
+	t1 = bench_now();
+
+	printf("{\"benchmark\": \"daemon\", \"clients\": %u, \"depth\": %u, "
+	       "\"batch\": %u, \"n\": %u, \"requests\": %u, \"seconds\": %.6f, "
+	       "\"problems_per_second\": %.1f, \"mean_latency\": %.6f, "
+	       "\"mismatches\": %u, \"ok\": %s}\n",
+	       b.n_clients, b.depth, b.batch, b.n, b.n_requests, t1 - t0,
+	       (double)b.n_clients * b.n_requests * b.batch / (t1 - t0),
+	       latency / ((double)b.n_clients * b.n_requests), n_mismatch,
+	       ok ? "true" : "false");
+
+	linprog2d_free(prog);
+	free(threads);
+	free(clients);
+	free(b.expected);
+	free(b.problems);
+	free(b.h);
+	free(b.Gy);
+	free(b.Gx);
+	return (ok && !n_mismatch) ? 0 : 1;
+}
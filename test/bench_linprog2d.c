@@ -0,0 +1,330 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/bench_linprog2d.c
+ *
+ * Micro-benchmarks for the linprog2d library. Results are written to stdout as
+ * a JSON array with one object per benchmark run.
+ *
+ * @author Andreas Stöckel
+ */
+
+#include <linprog2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/******************************************************************************
+ * Helper functions                                                           *
+ ******************************************************************************/
+
+/* Number of constraints in the generated constraint stream */
+#define N_STREAM 20000U
+
+/* Upper bound on the number of constraints processed when re-solving each
+   window from scratch; keeps the baseline from dominating the runtime. */
+#define RESOLVE_BUDGET (1UL << 24)
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+static double bench_rand(unsigned long int *state) {
+	*state = (*state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+	return (double)(*state) / (double)0x40000000UL - 1.0;
+}
+
+/**
+ * Generates a stream of random constraints that all contain the origin.
+ */
+static void bench_generate_stream(double *Gx, double *Gy, double *h,
+                                  unsigned int n, unsigned long int seed) {
+	unsigned int i;
+	for (i = 0U; i < n; i++) {
+		Gx[i] = bench_rand(&seed);
+		Gy[i] = bench_rand(&seed);
+		h[i] = -(0.1 + fabs(bench_rand(&seed)));
+	}
+}
+
+static double bench_seconds(clock_t t0, clock_t t1) {
+	return (double)(t1 - t0) / (double)CLOCKS_PER_SEC;
+}
+
+static int bench_first = 1;
+
+static void bench_report(const char *name, unsigned int width,
+                         unsigned int events, double seconds,
+                         double checksum) {
+	printf("%s\n  {\"benchmark\": \"%s\", \"width\": %u, \"events\": %u, "
+	       "\"seconds\": %.6f, \"events_per_second\": %.1f, "
+	       "\"checksum\": %.6g}",
+	       bench_first ? "" : ",", name, width, events, seconds,
+	       (seconds > 0.0) ? (double)events / seconds : 0.0, checksum);
+	bench_first = 0;
+}
+
+/******************************************************************************
+ * Benchmarks                                                                 *
+ ******************************************************************************/
+
+/**
+ * Pushes the entire stream through a sliding window of the given width.
+ */
+static void bench_window(const double *Gx, const double *Gy, const double *h,
+                         unsigned int width) {
+	unsigned int i;
+	double checksum = 0.0;
+	clock_t t0, t1;
+	linprog2d_window_t *win = linprog2d_window_create(width, 0.3, -0.8);
+	if (!win) {
+		return;
+	}
+
+	t0 = clock();
+	for (i = 0U; i < N_STREAM; i++) {
+		linprog2d_result_t res = linprog2d_window_push(win, Gx[i], Gy[i], h[i]);
+		checksum += res.y1;
+	}
+	t1 = clock();
+
+	bench_report("window", width, N_STREAM, bench_seconds(t0, t1), checksum);
+	linprog2d_window_free(win);
+}
+
+/**
+ * Baseline: solves each window from scratch using linprog2d_solve.
+ */
+static void bench_resolve(const double *Gx, const double *Gy, const double *h,
+                          unsigned int width) {
+	unsigned int i, n, events = N_STREAM;
+	double checksum = 0.0;
+	clock_t t0, t1;
+	linprog2d_t *prog = linprog2d_create(width);
+	if (!prog) {
+		return;
+	}
+
+	if ((unsigned long int)events * width > RESOLVE_BUDGET) {
+		events = (unsigned int)(RESOLVE_BUDGET / width);
+	}
+
+	t0 = clock();
+	for (i = 0U; i < events; i++) {
+		n = (i + 1U < width) ? i + 1U : width;
+		checksum += linprog2d_solve(prog, 0.3, -0.8, Gx + i + 1U - n,
+		                            Gy + i + 1U - n, h + i + 1U - n, n)
+		                .y1;
+	}
+	t1 = clock();
+
+	bench_report("resolve", width, events, bench_seconds(t0, t1), checksum);
+	linprog2d_free(prog);
+}
+
+/**
+ * Solves problems consisting of a shared base region of the given size and
+ * N_EXTRA additional constraints, once using a prepared region and once by
+ * solving the concatenated problem from scratch.
+ */
+#define N_EXTRA 8U
+#define N_REGION_QUERIES 2000U
+static void bench_region(const double *Gx, const double *Gy, const double *h,
+                         unsigned int n) {
+	unsigned int i, j;
+	double checksum_region = 0.0, checksum_solve = 0.0, cx, cy;
+	double *Gxc, *Gyc, *hc;
+	unsigned long int seed = 1234UL;
+	clock_t t0, t1, t2;
+	linprog2d_region_t *region = linprog2d_region_create(n);
+	linprog2d_t *prog = linprog2d_create(n + N_EXTRA);
+	Gxc = (double *)malloc(sizeof(double) * (n + N_EXTRA));
+	Gyc = (double *)malloc(sizeof(double) * (n + N_EXTRA));
+	hc = (double *)malloc(sizeof(double) * (n + N_EXTRA));
+	if (!region || !prog || !Gxc || !Gyc || !hc) {
+		return;
+	}
+	for (i = 0U; i < n; i++) {
+		Gxc[i] = Gx[i], Gyc[i] = Gy[i], hc[i] = h[i];
+	}
+	linprog2d_region_prepare(region, Gx, Gy, h, n);
+
+	t0 = clock();
+	for (i = 0U; i < N_REGION_QUERIES; i++) {
+		for (j = n; j < n + N_EXTRA; j++) {
+			Gxc[j] = bench_rand(&seed), Gyc[j] = bench_rand(&seed);
+			hc[j] = -0.5 * fabs(bench_rand(&seed));
+		}
+		cx = bench_rand(&seed), cy = bench_rand(&seed);
+		checksum_region += linprog2d_region_solve(region, cx, cy, Gxc + n,
+		                                          Gyc + n, hc + n, N_EXTRA)
+		                       .y1;
+	}
+	t1 = clock();
+	seed = 1234UL;
+	for (i = 0U; i < N_REGION_QUERIES; i++) {
+		for (j = n; j < n + N_EXTRA; j++) {
+			Gxc[j] = bench_rand(&seed), Gyc[j] = bench_rand(&seed);
+			hc[j] = -0.5 * fabs(bench_rand(&seed));
+		}
+		cx = bench_rand(&seed), cy = bench_rand(&seed);
+		checksum_solve +=
+		    linprog2d_solve(prog, cx, cy, Gxc, Gyc, hc, n + N_EXTRA).y1;
+	}
+	t2 = clock();
+
+	bench_report("region_solve", n, N_REGION_QUERIES, bench_seconds(t0, t1),
+	             checksum_region);
+	bench_report("concat_solve", n, N_REGION_QUERIES, bench_seconds(t1, t2),
+	             checksum_solve);
+	free(Gxc);
+	free(Gyc);
+	free(hc);
+	linprog2d_region_free(region);
+	linprog2d_free(prog);
+}
+#undef N_EXTRA
+#undef N_REGION_QUERIES
+
+/**
+ * Solves problems consisting of the first n constraints of the stream with
+ * random objectives, once using the sampling solver and once using
+ * linprog2d_solve.
+ */
+#define N_SAMPLING_QUERIES 200U
+static void bench_sampling(const double *Gx, const double *Gy, const double *h,
+                           unsigned int n) {
+	unsigned int i;
+	double checksum_sampling = 0.0, checksum_solve = 0.0, cx, cy;
+	unsigned long int seed = 4321UL;
+	clock_t t0, t1, t2;
+	linprog2d_sampling_t *smp = linprog2d_sampling_create(n);
+	linprog2d_t *prog = linprog2d_create(n);
+	if (!smp || !prog) {
+		return;
+	}
+
+	t0 = clock();
+	for (i = 0U; i < N_SAMPLING_QUERIES; i++) {
+		cx = bench_rand(&seed), cy = bench_rand(&seed);
+		checksum_sampling +=
+		    linprog2d_sampling_solve(smp, cx, cy, Gx, Gy, h, n).y1;
+	}
+	t1 = clock();
+	seed = 4321UL;
+	for (i = 0U; i < N_SAMPLING_QUERIES; i++) {
+		cx = bench_rand(&seed), cy = bench_rand(&seed);
+		checksum_solve += linprog2d_solve(prog, cx, cy, Gx, Gy, h, n).y1;
+	}
+	t2 = clock();
+
+	bench_report("sampling_solve", n, N_SAMPLING_QUERIES,
+	             bench_seconds(t0, t1), checksum_sampling);
+	bench_report("solve", n, N_SAMPLING_QUERIES, bench_seconds(t1, t2),
+	             checksum_solve);
+	linprog2d_sampling_free(smp);
+	linprog2d_free(prog);
+}
+#undef N_SAMPLING_QUERIES
+
+/**
+ * Solves windows of the given width at different offsets into the stream with
+ * random objectives, once calling linprog2d_solve for each problem and once
+ * passing all problems to the batch solver in a single call.
+ */
+#define N_BATCH_PROBLEMS 256U
+static void bench_batch(const double *Gx, const double *Gy, const double *h,
+                        unsigned int width) {
+	unsigned int i, offs;
+	double checksum_solve = 0.0, checksum_batch = 0.0;
+	unsigned long int seed = 8765UL;
+	clock_t t0, t1, t2;
+	linprog2d_problem_t problems[N_BATCH_PROBLEMS];
+	linprog2d_result_t res[N_BATCH_PROBLEMS];
+	linprog2d_batch_t *batch = linprog2d_batch_create(width);
+	linprog2d_t *prog = linprog2d_create(width);
+	if (!batch || !prog) {
+		return;
+	}
+
+	for (i = 0U; i < N_BATCH_PROBLEMS; i++) {
+		offs = (i * 7919U) % (N_STREAM - width);
+		problems[i].cx = bench_rand(&seed), problems[i].cy = bench_rand(&seed);
+		problems[i].Gx = Gx + offs, problems[i].Gy = Gy + offs;
+		problems[i].h = h + offs, problems[i].n = width;
+	}
+
+	t0 = clock();
+	for (i = 0U; i < N_BATCH_PROBLEMS; i++) {
+		checksum_solve +=
+		    linprog2d_solve(prog, problems[i].cx, problems[i].cy, problems[i].Gx,
+		                    problems[i].Gy, problems[i].h, problems[i].n)
+		        .y1;
+	}
+	t1 = clock();
+	linprog2d_batch_solve(batch, problems, res, N_BATCH_PROBLEMS);
+	for (i = 0U; i < N_BATCH_PROBLEMS; i++) {
+		checksum_batch += res[i].y1;
+	}
+	t2 = clock();
+
+	bench_report("sequential_solve", width, N_BATCH_PROBLEMS,
+	             bench_seconds(t0, t1), checksum_solve);
+	bench_report("batch_solve", width, N_BATCH_PROBLEMS, bench_seconds(t1, t2),
+	             checksum_batch);
+	linprog2d_batch_free(batch);
+	linprog2d_free(prog);
+}
+#undef N_BATCH_PROBLEMS
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+int main() {
+	unsigned int width;
+	double *Gx = (double *)malloc(sizeof(double) * N_STREAM);
+	double *Gy = (double *)malloc(sizeof(double) * N_STREAM);
+	double *h = (double *)malloc(sizeof(double) * N_STREAM);
+	if (!Gx || !Gy || !h) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	bench_generate_stream(Gx, Gy, h, N_STREAM, 4711UL);
+
+	printf("[");
+	for (width = 16U; width <= 16384U; width *= 4U) {
+		bench_window(Gx, Gy, h, width);
+		bench_resolve(Gx, Gy, h, width);
+	}
+	for (width = 256U; width <= 16384U; width *= 4U) {
+		bench_region(Gx, Gy, h, width);
+	}
+	bench_sampling(Gx, Gy, h, N_STREAM);
+	for (width = 256U; width <= 16384U; width *= 4U) {
+		bench_batch(Gx, Gy, h, width);
+	}
+	printf("\n]\n");
+
+	free(Gx);
+	free(Gy);
+	free(h);
+	return 0;
+}
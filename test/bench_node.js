@@ -0,0 +1,161 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/bench_node.js
+ *
+ * Compares the native Node-API addon against the WebAssembly module. Both are
+ * loaded through the sidecar build of the JavaScript wrapper and solve the
+ * same random problems, once by calling solve() per problem and once through
+ * solve_batch(); the results of the addon are checked against the WebAssembly
+ * module. For the addon, solve_batch_async() is measured as well, together
+ * with the largest delay of a timer on the event loop while it runs. Results
+ * are written to stdout as a JSON array with one object per run.
+ *
+ * Usage: node test/bench_node.js [build directory]
+ *
+ * @author Andreas Stöckel
+ */
+
+'use strict';
+
+const path = require('path');
+
+const dir = path.resolve(process.argv[2] || 'build');
+
+/* Number of constraints processed per problem size */
+const CONSTRAINT_BUDGET = 1 << 22;
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+function make_rand(seed) {
+	return () => {
+		seed = (seed * 1103515245 + 12345) % 2147483648;
+		return seed / 1073741824 - 1;
+	};
+}
+
+/**
+ * Loads a fresh instance of the wrapper; uses the WebAssembly module if file
+ * is given, the native addon otherwise.
+ */
+function load(file) {
+	const script = path.join(dir, 'linprog2d.sidecar.js');
+	delete require.cache[require.resolve(script)];
+	const lp = require(script).linprog2d;
+	if (!file && !lp.NATIVE) {
+		throw 'build/linprog2d.node not found, run "make node"';
+	}
+	return lp.init(file && path.join(dir, file)).then(() => lp);
+}
+
+function generate(m, n) {
+	const rand = make_rand(4711);
+	const c = new Float64Array(2 * m), counts = new Uint32Array(m).fill(n);
+	const Gx = new Float64Array(m * n), Gy = new Float64Array(m * n);
+	const h = new Float64Array(m * n);
+	for (let i = 0; i < 2 * m; i++) {
+		c[i] = rand();
+	}
+	for (let i = 0; i < m * n; i++) {
+		Gx[i] = rand(), Gy[i] = rand(), h[i] = -(0.1 + Math.abs(rand()));
+	}
+	return [c, counts, Gx, Gy, h];
+}
+
+function solve_each(lp, c, counts, Gx, Gy, h) {
+	const m = counts.length, out = new Float64Array(5 * m);
+	for (let i = 0, o = 0; i < m; o += counts[i++]) {
+		const r = lp.solve(c[2 * i], c[2 * i + 1], Gx.subarray(o, o + counts[i]),
+		                   Gy.subarray(o, o + counts[i]), h.subarray(o, o + counts[i]));
+		out.set([r.x1, r.y1, r.x2, r.y2, r.status], 5 * i);
+	}
+	return out;
+}
+
+/**
+ * Runs solve_batch_async() while a timer is ticking on the event loop.
+ * Returns the results, the elapsed seconds, and the largest timer delay.
+ */
+async function solve_async(lp, problem) {
+	let last = process.hrtime.bigint(), max_delay = 0n;
+	const timer = setInterval(() => {
+		const t = process.hrtime.bigint();
+		max_delay = (t - last > max_delay) ? t - last : max_delay;
+		last = t;
+	}, 1);
+	const t0 = process.hrtime.bigint();
+	const out = await lp.solve_batch_async(...problem);
+	const seconds = Number(process.hrtime.bigint() - t0) * 1e-9;
+	clearInterval(timer);
+	return [out, seconds, Number(max_delay) * 1e-9];
+}
+
+async function main() {
+	const lps = [await load('linprog2d.wasm'), await load(null)];
+	const results = [];
+	for (let n = 16; n <= 65536; n *= 4) {
+		const m = Math.max(1, CONSTRAINT_BUDGET / n | 0);
+		const problem = generate(m, n);
+		const runs = [['solve', (lp) => solve_each(lp, ...problem)],
+		              ['solve_batch', (lp) => lp.solve_batch(...problem)]];
+		for (const [name, fn] of runs) {
+			let expected = null;
+			for (let k = 0; k < 2; k++) {
+				fn(lps[k]); /* Warm up */
+				const t0 = process.hrtime.bigint();
+				const out = fn(lps[k]);
+				const seconds = Number(process.hrtime.bigint() - t0) * 1e-9;
+				let mismatches = 0;
+				for (let i = 0; expected && i < out.length; i++) {
+					mismatches += (out[i] === expected[i]) ? 0 : 1;
+				}
+				expected = expected || out;
+				results.push({
+					'benchmark': name,
+					'backend': k ? 'native' : 'wasm',
+					'n': n,
+					'problems': m,
+					'seconds': seconds,
+					'ns_per_constraint': 1e9 * seconds / (m * n),
+					'mismatches': mismatches
+				});
+			}
+		}
+		const expected = lps[1].solve_batch(...problem);
+		const [out, seconds, max_delay] = await solve_async(lps[1], problem);
+		let mismatches = 0;
+		for (let i = 0; i < out.length; i++) {
+			mismatches += (out[i] === expected[i]) ? 0 : 1;
+		}
+		results.push({
+			'benchmark': 'solve_batch_async',
+			'backend': 'native',
+			'n': n,
+			'problems': m,
+			'seconds': seconds,
+			'ns_per_constraint': 1e9 * seconds / (m * n),
+			'max_event_loop_delay_ms': 1e3 * max_delay,
+			'mismatches': mismatches
+		});
+	}
+	console.log(JSON.stringify(results, null, 2));
+}
+
+main();
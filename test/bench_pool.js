@@ -0,0 +1,107 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/bench_pool.js
+ *
+ * Measures how solving a batch with the worker thread pool scales with the
+ * number of workers, compared to calling solve_batch() on the main thread.
+ * The inputs are passed in SharedArrayBuffers, so they are not copied on the
+ * main thread. The results of the pool are checked against the main thread.
+ * Results are written to stdout as a JSON array with one object per run.
+ *
+ * Usage: node test/bench_pool.js [build directory] [max threads] [problems]
+ *                                [constraints]
+ *
+ * @author Andreas Stöckel
+ */
+
+'use strict';
+
+const os = require('os');
+const path = require('path');
+const pool_lib = require('../tools/linprog2d_pool.js');
+
+const dir = path.resolve(process.argv[2] || 'build');
+const max_threads = parseInt(process.argv[3] || os.cpus().length, 10);
+const m = parseInt(process.argv[4] || '4096', 10);
+const n = parseInt(process.argv[5] || '256', 10);
+const script = path.join(dir, 'linprog2d.sidecar.js');
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+let seed = 4917;
+function rand() {
+	seed = (seed * 1103515245 + 12345) % 2147483648;
+	return seed / 1073741824 - 1;
+}
+
+function shared(type, len) {
+	return new type(new SharedArrayBuffer(type.BYTES_PER_ELEMENT * len));
+}
+
+const c = shared(Float64Array, 2 * m), counts = shared(Uint32Array, m);
+const Gx = shared(Float64Array, m * n), Gy = shared(Float64Array, m * n);
+const h = shared(Float64Array, m * n);
+for (let i = 0; i < 2 * m; i++) {
+	c[i] = rand();
+}
+counts.fill(n);
+for (let i = 0; i < m * n; i++) {
+	Gx[i] = rand(), Gy[i] = rand(), h[i] = -(0.1 + Math.abs(rand()));
+}
+
+function report(results, name, threads, seconds, mismatches) {
+	results.push({
+		'benchmark': name,
+		'threads': threads,
+		'problems': m,
+		'n': n,
+		'seconds': seconds,
+		'problems_per_second': m / seconds,
+		'mismatches': mismatches
+	});
+}
+
+async function main() {
+	const results = [];
+	const lp = require(script).linprog2d;
+	await lp.init();
+	lp.solve_batch(c, counts, Gx, Gy, h); /* Warm up */
+	let t0 = process.hrtime.bigint();
+	const expected = lp.solve_batch(c, counts, Gx, Gy, h).slice();
+	report(results, 'main_thread', 1, Number(process.hrtime.bigint() - t0) * 1e-9, 0);
+
+	for (let threads = 1; threads <= max_threads; threads *= 2) {
+		const pool = await pool_lib.create({threads, script});
+		await pool.solveBatch(c, counts, Gx, Gy, h); /* Warm up */
+		t0 = process.hrtime.bigint();
+		const res = await pool.solveBatch(c, counts, Gx, Gy, h);
+		const seconds = Number(process.hrtime.bigint() - t0) * 1e-9;
+		let mismatches = 0;
+		for (let i = 0; i < res.length; i++) {
+			mismatches += (res[i] === expected[i]) ? 0 : 1;
+		}
+		report(results, 'pool', threads, seconds, mismatches);
+		await pool.close();
+	}
+	console.log(JSON.stringify(results, null, 2));
+}
+
+main();
@@ -0,0 +1,157 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file test/bench_scan.c
+ *
+ * Compares linprog2d_sampling_solve with the sequential violator scan against
+ * the parallel scan from tools/linprog2d_scan.c on problems with many
+ * constraints. The results of the parallel runs are checked against the
+ * sequential ones. Results are written to stdout as a JSON array with one
+ * object per run.
+ *
+ * Usage: bench_scan [-j threads] [-m problems] [-n constraints]
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "../tools/linprog2d_scan.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * Helper functions                                                           *
+ ******************************************************************************/
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+static double bench_rand(unsigned long int *state) {
+	*state = (*state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+	return (double)(*state) / (double)0x40000000UL - 1.0;
+}
+
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static int bench_first = 1;
+
+static void bench_report(const char *name, unsigned int m, unsigned int n,
+                         double seconds, unsigned int n_mismatch) {
+	printf("%s\n  {\"benchmark\": \"%s\", \"problems\": %u, \"n\": %u, "
+	       "\"seconds\": %.6f, \"problems_per_second\": %.1f, "
+	       "\"mismatches\": %u}",
+	       bench_first ? "" : ",", name, m, n, seconds,
+	       (seconds > 0.0) ? (double)m / seconds : 0.0, n_mismatch);
+	bench_first = 0;
+}
+
+static int bench_match(linprog2d_result_t a, linprog2d_result_t b) {
+	return a.status == b.status && a.x1 == b.x1 && a.y1 == b.y1 &&
+	       a.x2 == b.x2 && a.y2 == b.y2;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+int main(int argc, char *argv[]) {
+	unsigned int i, m = 20U, n = 1000000U, n_mismatch = 0U;
+	unsigned int n_threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned long int j, seed = 4917UL;
+	double *Gx, *Gy, *h, *c, t0;
+	linprog2d_result_t *expected, res;
+	linprog2d_sampling_t *smp;
+	linprog2d_scan_t *scan;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:m:n:")) != -1) {
+		if (opt == 'j' && atoi(optarg) > 0) {
+			n_threads = (unsigned int)atoi(optarg);
+		} else if (opt == 'm' && atoi(optarg) > 0) {
+			m = (unsigned int)atoi(optarg);
+		} else if (opt == 'n' && atoi(optarg) > 0) {
+			n = (unsigned int)atoi(optarg);
+		} else {
+			fprintf(stderr, "Usage: %s [-j threads] [-m problems] "
+			                "[-n constraints]\n",
+			        argv[0]);
+			return 1;
+		}
+	}
+	n_threads = (n_threads > 0U) ? n_threads : 1U;
+
+	Gx = (double *)malloc(sizeof(double) * n);
+	Gy = (double *)malloc(sizeof(double) * n);
+	h = (double *)malloc(sizeof(double) * n);
+	c = (double *)malloc(sizeof(double) * 2U * m);
+	expected = (linprog2d_result_t *)malloc(sizeof(linprog2d_result_t) * m);
+	smp = linprog2d_sampling_create(n);
+	scan = linprog2d_scan_create(n_threads, 4096U);
+	if (!Gx || !Gy || !h || !c || !expected || !smp || !scan) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	for (j = 0UL; j < n; j++) {
+		Gx[j] = bench_rand(&seed);
+		Gy[j] = bench_rand(&seed);
+		h[j] = -(0.1 + fabs(bench_rand(&seed)));
+	}
+	for (i = 0U; i < 2U * m; i++) {
+		c[i] = bench_rand(&seed);
+	}
+
+	printf("[");
+	t0 = bench_now();
+	for (i = 0U; i < m; i++) {
+		expected[i] = linprog2d_sampling_solve(smp, c[2U * i], c[2U * i + 1U],
+		                                       Gx, Gy, h, n);
+	}
+	bench_report("sequential", m, n, bench_now() - t0, 0U);
+
+	/* Restart the random number generator so both runs draw the same
+	   samples */
+	linprog2d_sampling_free(smp);
+	smp = linprog2d_sampling_create(n);
+	linprog2d_sampling_set_scanner(smp, linprog2d_scan, scan);
+	t0 = bench_now();
+	for (i = 0U; i < m; i++) {
+		res = linprog2d_sampling_solve(smp, c[2U * i], c[2U * i + 1U], Gx, Gy,
+		                               h, n);
+		n_mismatch += bench_match(res, expected[i]) ? 0U : 1U;
+	}
+	bench_report("parallel", m, n, bench_now() - t0, n_mismatch);
+	printf("\n]\n");
+
+	linprog2d_scan_free(scan);
+	linprog2d_sampling_free(smp);
+	free(expected);
+	free(c);
+	free(h);
+	free(Gy);
+	free(Gx);
+	return n_mismatch ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file test/bench_shared_cache.c
+ *
+ * Several threads solve problems drawn at random from a fixed pool, once
+ * without cache, once with one linprog2d_cache per thread, and once with a
+ * single sharded cache from tools/linprog2d_shared_cache.c shared by all
+ * threads. The results are checked against solving each problem directly.
+ * Results are written to stdout as a JSON array with one object per run.
+ *
+ * Usage: bench_shared_cache [-j threads] [-m solves] [-p pool] [-n constraints]
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "../tools/linprog2d_shared_cache.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * Helper functions                                                           *
+ ******************************************************************************/
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+static double bench_rand(unsigned long int *state) {
+	*state = (*state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+	return (double)(*state) / (double)0x40000000UL - 1.0;
+}
+
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static int bench_first = 1;
+
+static void bench_report(const char *name, unsigned int m, unsigned int n,
+                         double seconds, unsigned long int n_hits,
+                         unsigned int n_mismatch) {
+	printf("%s\n  {\"benchmark\": \"%s\", \"solves\": %u, \"n\": %u, "
+	       "\"seconds\": %.6f, \"solves_per_second\": %.1f, \"hits\": %lu, "
+	       "\"mismatches\": %u}",
+	       bench_first ? "" : ",", name, m, n, seconds,
+	       (seconds > 0.0) ? (double)m / seconds : 0.0, n_hits, n_mismatch);
+	bench_first = 0;
+}
+
+static int bench_match(linprog2d_result_t a, linprog2d_result_t b) {
+	return a.status == b.status && a.x1 == b.x1 && a.y1 == b.y1 &&
+	       a.x2 == b.x2 && a.y2 == b.y2;
+}
+
+/* Problem pool shared by all threads */
+static unsigned int pool_size, n_constraints, n_solves;
+static double *pool_c, *pool_Gx, *pool_Gy, *pool_h;
+static linprog2d_result_t *expected;
+
+#define MODE_NONE 0
+#define MODE_LOCAL 1
+#define MODE_SHARED 2
+
+struct worker {
+	pthread_t thread;
+	int mode;
+	unsigned long int seed, n_hits;
+	unsigned int n_mismatch;
+	linprog2d_shared_cache_t *shared;
+};
+
+static void *worker_main(void *arg) {
+	struct worker *w = (struct worker *)arg;
+	const unsigned int n = n_constraints;
+	linprog2d_t *prog = linprog2d_create(n);
+	linprog2d_cache_t *local = linprog2d_cache_create(pool_size / 4U + 1U, n);
+	linprog2d_result_t res;
+	unsigned long int offs;
+	unsigned int i, p;
+	if (!prog || !local) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	for (i = 0U; i < n_solves; i++) {
+		/* Skewed distribution, some problems are drawn much more often */
+		p = (unsigned int)(pool_size * pow(0.5 + 0.5 * bench_rand(&w->seed),
+		                                   3.0));
+		p = (p < pool_size) ? p : pool_size - 1U;
+		offs = (unsigned long int)p * n;
+		if (w->mode == MODE_NONE) {
+			res = linprog2d_solve(prog, pool_c[2U * p], pool_c[2U * p + 1U],
+			                      pool_Gx + offs, pool_Gy + offs, pool_h + offs,
+			                      n);
+		} else if (w->mode == MODE_LOCAL) {
+			res = linprog2d_cache_solve(local, pool_c[2U * p],
+			                            pool_c[2U * p + 1U], pool_Gx + offs,
+			                            pool_Gy + offs, pool_h + offs, n);
+		} else {
+			res = linprog2d_shared_cache_solve(
+			    w->shared, pool_c[2U * p], pool_c[2U * p + 1U], pool_Gx + offs,
+			    pool_Gy + offs, pool_h + offs, n);
+		}
+		w->n_mismatch += bench_match(res, expected[p]) ? 0U : 1U;
+	}
+	w->n_hits = (w->mode == MODE_LOCAL) ? linprog2d_cache_hits(local) : 0UL;
+	linprog2d_cache_free(local);
+	linprog2d_free(prog);
+	return NULL;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+int main(int argc, char *argv[]) {
+	static const char *names[3] = {"no_cache", "local_cache", "shared_cache"};
+	unsigned int i, n_threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int n_mismatch, n_total = 0U;
+	unsigned long int j, n_hits, seed = 4917UL;
+	linprog2d_shared_cache_t *shared;
+	struct worker *workers;
+	linprog2d_t *prog;
+	int opt, mode;
+	double t0;
+
+	pool_size = 1024U, n_constraints = 256U, n_solves = 20000U;
+	while ((opt = getopt(argc, argv, "j:m:p:n:")) != -1) {
+		if (opt == 'j' && atoi(optarg) > 0) {
+			n_threads = (unsigned int)atoi(optarg);
+		} else if (opt == 'm' && atoi(optarg) > 0) {
+			n_solves = (unsigned int)atoi(optarg);
+		} else if (opt == 'p' && atoi(optarg) > 0) {
+			pool_size = (unsigned int)atoi(optarg);
+		} else if (opt == 'n' && atoi(optarg) > 0) {
+			n_constraints = (unsigned int)atoi(optarg);
+		} else {
+			fprintf(stderr, "Usage: %s [-j threads] [-m solves] [-p pool] "
+			                "[-n constraints]\n",
+			        argv[0]);
+			return 1;
+		}
+	}
+	n_threads = (n_threads > 0U) ? n_threads : 1U;
+
+	j = (unsigned long int)pool_size * n_constraints;
+	pool_c = (double *)malloc(sizeof(double) * 2U * pool_size);
+	pool_Gx = (double *)malloc(sizeof(double) * j);
+	pool_Gy = (double *)malloc(sizeof(double) * j);
+	pool_h = (double *)malloc(sizeof(double) * j);
+	expected = (linprog2d_result_t *)malloc(sizeof(linprog2d_result_t) *
+	                                        pool_size);
+	workers = (struct worker *)calloc(n_threads, sizeof(struct worker));
+	prog = linprog2d_create(n_constraints);
+	/* All caches together hold the same number of entries in both modes */
+	shared = linprog2d_shared_cache_create(4U * n_threads,
+	                                       (pool_size / 4U + 1U) / 4U + 1U,
+	                                       n_constraints);
+	if (!pool_c || !pool_Gx || !pool_Gy || !pool_h || !expected || !workers ||
+	    !prog || !shared) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	for (j = 0UL; j < (unsigned long int)pool_size * n_constraints; j++) {
+		pool_Gx[j] = bench_rand(&seed);
+		pool_Gy[j] = bench_rand(&seed);
+		pool_h[j] = -(0.1 + fabs(bench_rand(&seed)));
+	}
+	for (i = 0U; i < pool_size; i++) {
+		pool_c[2U * i] = bench_rand(&seed);
+		pool_c[2U * i + 1U] = bench_rand(&seed);
+		j = (unsigned long int)i * n_constraints;
+		expected[i] = linprog2d_solve(prog, pool_c[2U * i],
+		                              pool_c[2U * i + 1U], pool_Gx + j,
+		                              pool_Gy + j, pool_h + j, n_constraints);
+	}
+
+	printf("[");
+	for (mode = MODE_NONE; mode <= MODE_SHARED; mode++) {
+		t0 = bench_now();
+		for (i = 0U; i < n_threads; i++) {
+			workers[i].mode = mode;
+			workers[i].seed = 7919UL * (i + 1U);
+			workers[i].n_mismatch = 0U;
+			workers[i].shared = shared;
+			if (pthread_create(&workers[i].thread, NULL, worker_main,
+			                   &workers[i]) != 0) {
+				fprintf(stderr, "Cannot create thread\n");
+				return 1;
+			}
+		}
+		for (i = 0U, n_hits = 0UL, n_mismatch = 0U; i < n_threads; i++) {
+			pthread_join(workers[i].thread, NULL);
+			n_hits += workers[i].n_hits;
+			n_mismatch += workers[i].n_mismatch;
+		}
+		if (mode == MODE_SHARED) {
+			n_hits = linprog2d_shared_cache_hits(shared);
+		}
+		bench_report(names[mode], n_solves * n_threads, n_constraints,
+		             bench_now() - t0, n_hits, n_mismatch);
+		n_total += n_mismatch;
+	}
+	printf("\n]\n");
+
+	linprog2d_shared_cache_free(shared);
+	linprog2d_free(prog);
+	free(workers);
+	free(expected);
+	free(pool_h);
+	free(pool_Gy);
+	free(pool_Gx);
+	free(pool_c);
+	return n_total ? 1 : 0;
+}
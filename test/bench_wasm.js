@@ -0,0 +1,94 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/bench_wasm.js
+ *
+ * Measures the cold-start time of the JavaScript/WebAssembly library under
+ * Node.js, i.e. the time from loading the script until init() has resolved.
+ * Each run happens in a fresh process with the native addon disabled.
+ * Compares the build with the embedded base64 module against the sidecar
+ * build, once compiling linprog2d.wasm and once instantiating a module that
+ * has been compiled beforehand (as a worker does when it receives the module
+ * from the main thread). Results are written to stdout as a JSON array with
+ * one object per variant.
+ *
+ * Usage: node test/bench_wasm.js [build directory] [runs]
+ *
+ * @author Andreas Stöckel
+ */
+
+'use strict';
+
+const child_process = require('child_process');
+const fs = require('fs');
+const path = require('path');
+
+const dir = path.resolve(process.argv[2] || 'build');
+const runs = parseInt(process.argv[3] || '20', 10);
+
+/* Code run in the child process; prints the elapsed milliseconds */
+function child_code(file, precompile) {
+	return `
+		const t_start = process.hrtime.bigint();
+		const file = ${JSON.stringify(file)};
+		const pre = ${precompile} ? new WebAssembly.Module(
+			require('fs').readFileSync(${JSON.stringify(dir + '/linprog2d.wasm')})) : undefined;
+		const t0 = ${precompile} ? process.hrtime.bigint() : t_start;
+		const lp = require(file).linprog2d;
+		lp.init(pre).then(solve => {
+			const t1 = process.hrtime.bigint();
+			if (solve(1, 1, [-2, 1, -1], [-1, 1, -3], [-70, 40, -90]).status != lp.EDGE) {
+				process.exit(1);
+			}
+			console.log(Number(t1 - t0) * 1e-6);
+		});`;
+}
+
+function median(xs) {
+	const s = xs.slice().sort((a, b) => a - b);
+	return s[s.length >> 1];
+}
+
+const variants = [
+	['inline', 'linprog2d.js', false],
+	['sidecar', 'linprog2d.sidecar.js', false],
+	['sidecar_precompiled', 'linprog2d.sidecar.js', true]
+];
+
+const results = [];
+for (const [name, file, precompile] of variants) {
+	const times = [];
+	for (let i = 0; i < runs; i++) {
+		const out = child_process.execFileSync(process.execPath,
+			['-e', child_code(path.join(dir, file), precompile)],
+			{env: Object.assign({}, process.env, {LINPROG2D_NATIVE: '0'})});
+		times.push(parseFloat(out.toString()));
+	}
+	const bytes = fs.statSync(path.join(dir, file)).size +
+		(name == 'sidecar' ? fs.statSync(path.join(dir, 'linprog2d.wasm')).size : 0);
+	results.push({
+		'benchmark': 'wasm_startup',
+		'variant': name,
+		'runs': runs,
+		'bytes': bytes,
+		'median_ms': median(times),
+		'min_ms': Math.min(...times)
+	});
+}
+console.log(JSON.stringify(results, null, 2));
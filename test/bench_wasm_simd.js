@@ -0,0 +1,104 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/bench_wasm_simd.js
+ *
+ * Compares the scalar and the SIMD128 build of the WebAssembly module under
+ * Node.js. Both modules are loaded through the sidecar build of the JavaScript
+ * wrapper and solve the same random problems through solve_batch(); the
+ * results of the SIMD build are checked against the scalar build. Results are
+ * written to stdout as a JSON array with one object per module and problem
+ * size.
+ *
+ * Usage: node test/bench_wasm_simd.js [build directory]
+ *
+ * @author Andreas Stöckel
+ */
+
+'use strict';
+
+const path = require('path');
+
+const dir = path.resolve(process.argv[2] || 'build');
+
+/* Number of constraints processed per problem size */
+const CONSTRAINT_BUDGET = 1 << 22;
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+function make_rand(seed) {
+	return () => {
+		seed = (seed * 1103515245 + 12345) % 2147483648;
+		return seed / 1073741824 - 1;
+	};
+}
+
+/**
+ * Loads a fresh instance of the wrapper using the given module file.
+ */
+function load(file) {
+	const script = path.join(dir, 'linprog2d.sidecar.js');
+	delete require.cache[require.resolve(script)];
+	const lp = require(script).linprog2d;
+	return lp.init(path.join(dir, file)).then(() => lp);
+}
+
+function generate(m, n) {
+	const rand = make_rand(4711);
+	const c = new Float64Array(2 * m), counts = new Uint32Array(m).fill(n);
+	const Gx = new Float64Array(m * n), Gy = new Float64Array(m * n);
+	const h = new Float64Array(m * n);
+	for (let i = 0; i < 2 * m; i++) {
+		c[i] = rand();
+	}
+	for (let i = 0; i < m * n; i++) {
+		Gx[i] = rand(), Gy[i] = rand(), h[i] = -(0.1 + Math.abs(rand()));
+	}
+	return [c, counts, Gx, Gy, h];
+}
+
+Promise.all([load('linprog2d.wasm'), load('linprog2d.simd.wasm')]).then(lps => {
+	const results = [];
+	for (let n = 256; n <= 65536; n *= 4) {
+		const m = Math.max(1, CONSTRAINT_BUDGET / n | 0);
+		const problem = generate(m, n);
+		const out = [];
+		for (let k = 0; k < 2; k++) {
+			lps[k].solve_batch(...problem); /* Warm up */
+			const t0 = process.hrtime.bigint();
+			out.push(lps[k].solve_batch(...problem));
+			const seconds = Number(process.hrtime.bigint() - t0) * 1e-9;
+			let mismatches = 0;
+			for (let i = 0; k > 0 && i < out[0].length; i++) {
+				mismatches += (out[0][i] === out[k][i]) ? 0 : 1;
+			}
+			results.push({
+				'benchmark': 'wasm_simd',
+				'module': k ? 'simd' : 'scalar',
+				'n': n,
+				'problems': m,
+				'seconds': seconds,
+				'ns_per_constraint': 1e9 * seconds / (m * n),
+				'mismatches': mismatches
+			});
+		}
+	}
+	console.log(JSON.stringify(results, null, 2));
+});
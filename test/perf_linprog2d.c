@@ -0,0 +1,263 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/perf_linprog2d.c
+ *
+ * Measures hardware performance counters for the individual phases of
+ * linprog2d_solve() using the Linux perf_event_open interface. The counters
+ * only count user-space events of this process, which the kernel allows
+ * without privileges as long as kernel.perf_event_paranoid is at most two.
+ * Counters that cannot be opened (for example in virtual machines without a
+ * PMU) are reported as null. Results are written to stdout as a JSON array
+ * with one object per problem size and phase.
+ *
+ * The counters are read once at each phase boundary; the cost of these reads
+ * is included in the measurements and is only negligible for larger problems.
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _GNU_SOURCE
+
+#include "../linprog2d.c"
+
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * Performance counters                                                       *
+ ******************************************************************************/
+
+#define CNT_CYCLES 0
+#define CNT_INSTRUCTIONS 1
+#define CNT_LLC_MISSES 2
+#define CNT_BRANCHES 3
+#define CNT_BRANCH_MISSES 4
+#define N_COUNTERS 5
+
+/* Number of values read at each phase boundary: the counters and the time */
+#define N_VALUES (N_COUNTERS + 1)
+
+static const unsigned long int counter_config[N_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+/**
+ * Group of counters. The counters that could be opened are read at once
+ * through the group leader; slot maps each counter to its position in the
+ * group, or -1 if the counter is not available.
+ */
+struct counters {
+	int leader, fd[N_COUNTERS], slot[N_COUNTERS], n_open;
+};
+
+static void counters_open(struct counters *c) {
+	struct perf_event_attr attr;
+	int i, fd;
+	c->leader = -1, c->n_open = 0;
+	for (i = 0; i < N_COUNTERS; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = counter_config[i];
+		attr.read_format = PERF_FORMAT_GROUP;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, c->leader, 0);
+		c->fd[i] = fd;
+		c->slot[i] = (fd < 0) ? -1 : c->n_open++;
+		if (fd >= 0 && c->leader < 0) {
+			c->leader = fd;
+		}
+	}
+}
+
+/**
+ * Reads the current counter values and the time into v. Unavailable counters
+ * read as zero.
+ */
+static void counters_read(const struct counters *c, double *v) {
+	unsigned long int buf[N_COUNTERS + 1];
+	struct timespec ts;
+	int i;
+	memset(buf, 0, sizeof(buf));
+	if (c->leader >= 0 && read(c->leader, buf, sizeof(buf)) < 0) {
+		memset(buf, 0, sizeof(buf));
+	}
+	for (i = 0; i < N_COUNTERS; i++) {
+		v[i] = (c->slot[i] < 0) ? 0.0 : (double)buf[1 + c->slot[i]];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	v[N_COUNTERS] = (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/******************************************************************************
+ * Phases                                                                     *
+ ******************************************************************************/
+
+#define N_PHASES 4
+
+static const char *phase_names[N_PHASES] = {"condition", "presolve",
+                                            "categorize", "prune"};
+
+/**
+ * Solves the problem in the same way as linprog2d_solve(), reading the
+ * counters at each phase boundary and adding the differences to sum.
+ */
+static double perf_solve(linprog2d_data_t *prog, const struct counters *c,
+                         double cx, double cy, const double *Gx,
+                         const double *Gy, const double *h, unsigned int n,
+                         double sum[N_PHASES][N_VALUES]) {
+	double v[N_PHASES + 1][N_VALUES];
+	linprog2d_result_t res = linprog2d_result_err();
+	bool_t feasible;
+	int i, j;
+
+	counters_read(c, v[0]);
+	linprog2d_reset(prog, n);
+	linprog2d_condition_problem(prog, cx, cy, Gx, Gy, h);
+	counters_read(c, v[1]);
+	linprog2d_presolve(prog);
+	counters_read(c, v[2]);
+	if ((feasible = linprog2d_categorize_constraints(prog))) {
+		linprog2d_calculate_yoffset_form(prog->ceil, prog->ceil_len, prog->Gx,
+		                                 prog->Gy, prog->h, prog->dx, prog->y0);
+		linprog2d_calculate_yoffset_form(prog->floor, prog->floor_len,
+		                                 prog->Gx, prog->Gy, prog->h, prog->dx,
+		                                 prog->y0);
+	}
+	counters_read(c, v[3]);
+	if (feasible) {
+		while (!linprog2d_solve_step(prog, &res)) {
+			/* Prune until the result is known */
+		}
+	}
+	counters_read(c, v[4]);
+
+	for (i = 0; i < N_PHASES; i++) {
+		for (j = 0; j < N_VALUES; j++) {
+			sum[i][j] += v[i + 1][j] - v[i][j];
+		}
+	}
+	return res.y1;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+/* Number of constraints in the generated constraint stream */
+#define N_STREAM 65536U
+
+/* Number of constraints processed per problem size */
+#define CONSTRAINT_BUDGET (1UL << 23)
+
+/**
+ * Simple linear congruential generator returning values in [-1, 1).
+ */
+static double perf_rand(unsigned long int *state) {
+	*state = (*state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+	return (double)(*state) / (double)0x40000000UL - 1.0;
+}
+
+/**
+ * Prints value / div, or null if the counter is unavailable or div is zero.
+ */
+static void perf_print(const char *name, const struct counters *c, int i,
+                       double value, double div) {
+	if (c->slot[i] < 0 || div <= 0.0) {
+		printf(", \"%s\": null", name);
+	} else {
+		printf(", \"%s\": %.4f", name, value / div);
+	}
+}
+
+int main() {
+	static double Gx[N_STREAM], Gy[N_STREAM], h[N_STREAM];
+	double sum[N_PHASES][N_VALUES], checksum, total;
+	unsigned long int seed = 4711UL;
+	unsigned int i, n, offs, n_problems;
+	struct counters c;
+	linprog2d_t *prog;
+	int p, first = 1;
+
+	for (i = 0U; i < N_STREAM; i++) {
+		Gx[i] = perf_rand(&seed);
+		Gy[i] = perf_rand(&seed);
+		h[i] = -(0.1 + fabs(perf_rand(&seed)));
+	}
+	counters_open(&c);
+	if (c.n_open < N_COUNTERS) {
+		fprintf(stderr, "Only %d of %d hardware counters are available\n",
+		        c.n_open, N_COUNTERS);
+	}
+
+	printf("[");
+	for (n = 256U; n <= N_STREAM; n *= 4U) {
+		if (!(prog = linprog2d_create(n))) {
+			fprintf(stderr, "Out of memory\n");
+			return 1;
+		}
+		memset(sum, 0, sizeof(sum));
+		checksum = 0.0;
+		n_problems = (unsigned int)(CONSTRAINT_BUDGET / n);
+		for (i = 0U; i < n_problems; i++) {
+			offs = (n < N_STREAM) ? (i * 7919U) % (N_STREAM - n) : 0U;
+			checksum += perf_solve((linprog2d_data_t *)prog, &c,
+			                       perf_rand(&seed), perf_rand(&seed),
+			                       Gx + offs, Gy + offs, h + offs, n, sum);
+		}
+		total = (double)n_problems * n;
+		for (p = 0; p < N_PHASES; p++) {
+			const double *s = sum[p];
+			printf("%s\n  {\"benchmark\": \"perf\", \"phase\": \"%s\", "
+			       "\"n\": %u, \"problems\": %u, \"seconds\": %.6f, "
+			       "\"ns_per_constraint\": %.4f",
+			       first ? "" : ",", phase_names[p], n, n_problems,
+			       s[N_COUNTERS], 1e9 * s[N_COUNTERS] / total);
+			perf_print("cycles_per_constraint", &c, CNT_CYCLES, s[CNT_CYCLES],
+			           total);
+			perf_print("instructions_per_constraint", &c, CNT_INSTRUCTIONS,
+			           s[CNT_INSTRUCTIONS], total);
+			perf_print("ipc", &c, CNT_INSTRUCTIONS, s[CNT_INSTRUCTIONS],
+			           (c.slot[CNT_CYCLES] < 0) ? 0.0 : s[CNT_CYCLES]);
+			perf_print("llc_misses_per_constraint", &c, CNT_LLC_MISSES,
+			           s[CNT_LLC_MISSES], total);
+			perf_print("branch_miss_rate", &c, CNT_BRANCH_MISSES,
+			           s[CNT_BRANCH_MISSES],
+			           (c.slot[CNT_BRANCHES] < 0) ? 0.0 : s[CNT_BRANCHES]);
+			printf(", \"checksum\": %.6g}", checksum);
+			first = 0;
+		}
+		linprog2d_free(prog);
+	}
+	printf("\n]\n");
+
+	for (p = 0; p < N_COUNTERS; p++) {
+		if (c.fd[p] >= 0) {
+			close(c.fd[p]);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/replay_linprog2d.c
+ *
+ * Re-runs the problems in a capture file written by a library compiled with
+ * the LINPROG2D_CAPTURE flag against the current build. Results are written to
+ * stdout as a JSON array with one object per problem, containing the captured
+ * and the replayed solve time, and whether the result still matches.
+ *
+ * Usage: replay_linprog2d <capture file> [repeats]
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <linprog2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/******************************************************************************
+ * Helper functions                                                           *
+ ******************************************************************************/
+
+/* Magic bytes at the beginning of each capture file */
+#define CAPTURE_MAGIC "LP2DCAP1"
+
+/* Tolerance used when comparing captured and replayed results */
+#define REPLAY_EPS 1e-9
+
+/**
+ * Returns the time in seconds; the capture records wall-clock durations
+ * measured the same way.
+ */
+static double replay_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/**
+ * A single captured problem. The arrays grow as larger problems are read.
+ */
+struct replay_problem {
+	unsigned int n, capacity;
+	double cx, cy, seconds;
+	double *Gx, *Gy, *h;
+	linprog2d_result_t res;
+};
+
+/**
+ * Reads the next record from the capture file. Returns zero at the end of the
+ * file or if the record is truncated.
+ */
+static int replay_read(FILE *f, struct replay_problem *p) {
+	unsigned int head[2];
+	double vals[7];
+	if (fread(head, sizeof(unsigned int), 2U, f) != 2U ||
+	    fread(vals, sizeof(double), 7U, f) != 7U) {
+		return 0;
+	}
+	p->n = head[0];
+	p->res.status = (enum linprog2d_status)head[1];
+	p->cx = vals[0], p->cy = vals[1];
+	p->res.x1 = vals[2], p->res.y1 = vals[3];
+	p->res.x2 = vals[4], p->res.y2 = vals[5];
+	p->seconds = vals[6];
+	if (p->n > p->capacity) {
+		free(p->Gx);
+		free(p->Gy);
+		free(p->h);
+		p->capacity = p->n;
+		p->Gx = (double *)malloc(sizeof(double) * p->capacity);
+		p->Gy = (double *)malloc(sizeof(double) * p->capacity);
+		p->h = (double *)malloc(sizeof(double) * p->capacity);
+		if (!p->Gx || !p->Gy || !p->h) {
+			return 0;
+		}
+	}
+	return fread(p->Gx, sizeof(double), p->n, f) == p->n &&
+	       fread(p->Gy, sizeof(double), p->n, f) == p->n &&
+	       fread(p->h, sizeof(double), p->n, f) == p->n;
+}
+
+static int replay_near(double x, double y) {
+	return fabs(x - y) <= REPLAY_EPS * (1.0 + fabs(x) + fabs(y));
+}
+
+/**
+ * Returns non-zero if the two results are the same up to a small tolerance.
+ */
+static int replay_match(linprog2d_result_t a, linprog2d_result_t b) {
+	if (a.status != b.status) {
+		return 0;
+	}
+	if (a.status >= LP2D_EDGE &&
+	    (!replay_near(a.x1, b.x1) || !replay_near(a.y1, b.y1))) {
+		return 0;
+	}
+	if (a.status == LP2D_EDGE &&
+	    (!replay_near(a.x2, b.x2) || !replay_near(a.y2, b.y2))) {
+		return 0;
+	}
+	return 1;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+int main(int argc, char *argv[]) {
+	struct replay_problem p;
+	linprog2d_t *prog = NULL;
+	linprog2d_result_t res;
+	unsigned int i, idx = 0U, repeats = 10U, n_mismatch = 0U;
+	double seconds, total_captured = 0.0, total_replayed = 0.0;
+	char magic[sizeof(CAPTURE_MAGIC) - 1U];
+	double t0;
+	FILE *f;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s <capture file> [repeats]\n", argv[0]);
+		return 1;
+	}
+	if (argc == 3 && (repeats = (unsigned int)atoi(argv[2])) == 0U) {
+		fprintf(stderr, "Invalid number of repeats\n");
+		return 1;
+	}
+	if (!(f = fopen(argv[1], "rb"))) {
+		fprintf(stderr, "Cannot open %s\n", argv[1]);
+		return 1;
+	}
+	if (fread(magic, 1U, sizeof(magic), f) != sizeof(magic) ||
+	    memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0) {
+		fprintf(stderr, "%s is not a capture file\n", argv[1]);
+		fclose(f);
+		return 1;
+	}
+
+	memset(&p, 0, sizeof(p));
+	printf("[");
+	while (replay_read(f, &p)) {
+		/* Grow the solver if necessary */
+		if (!prog || linprog2d_capacity(prog) < p.n) {
+			linprog2d_free(prog);
+			if (!(prog = linprog2d_create(p.n))) {
+				fprintf(stderr, "Out of memory\n");
+				break;
+			}
+		}
+
+		/* Solve the problem repeatedly to get above the clock resolution */
+		t0 = replay_now();
+		for (i = 0U; i < repeats; i++) {
+			res = linprog2d_solve(prog, p.cx, p.cy, p.Gx, p.Gy, p.h, p.n);
+		}
+		seconds = (replay_now() - t0) / repeats;
+
+		total_captured += p.seconds;
+		total_replayed += seconds;
+		n_mismatch += replay_match(p.res, res) ? 0U : 1U;
+		printf("%s\n  {\"problem\": %u, \"n\": %u, \"captured_seconds\": %.9f, "
+		       "\"replayed_seconds\": %.9f, \"speedup\": %.3f, "
+		       "\"match\": %s}",
+		       idx ? "," : "", idx, p.n, p.seconds, seconds,
+		       (seconds > 0.0) ? p.seconds / seconds : 0.0,
+		       replay_match(p.res, res) ? "true" : "false");
+		idx++;
+	}
+	printf("\n]\n");
+	fprintf(stderr,
+	        "Replayed %u problems; captured %.6f s, replayed %.6f s; "
+	        "%u mismatches\n",
+	        idx, total_captured, total_replayed, n_mismatch);
+
+	fclose(f);
+	free(p.Gx);
+	free(p.Gy);
+	free(p.h);
+	linprog2d_free(prog);
+	return n_mismatch ? 1 : 0;
+}
@@ -34,6 +34,7 @@
 
 #include <setjmp.h> /* Jikes. Required as an exception replacement in ASSERT. */
 #include <stdio.h>
+#include <string.h>
 
 static volatile int n_failed = 0;
 static volatile int n_success = 0;
@@ -674,6 +675,45 @@ void test_linprog2d_condition_problem_offset_and_rescale() {
 	EXPECT_EQ(2.5, prog.o.y);
 }
 
+void test_linprog2d_presolve() {
+	linprog2d_data_t prog;
+	double Gx[6] = {1.0, 2.0, -1.0, 0.5, 1.0, 1.0};
+	double Gy[6] = {1.0, 2.0, 0.0, 0.5, 0.5, 1.0};
+	double h[6] = {1.0, 4.0, -3.0, -1.0, 0.0, 1.5};
+	unsigned int ceil[6], floor[6];
+
+	/* Manually setup the linprog2d_data_t structure; the constraints are
+	   already normalized */
+	linprog2d_reset(&prog, 6U);
+	prog.Gx = Gx, prog.Gy = Gy, prog.h = h;
+	prog.ceil = ceil, prog.floor = floor;
+	Gx[1] = 1.0, Gy[1] = 1.0, h[1] = 2.0;
+	Gx[3] = 1.0, Gy[3] = 1.0, h[3] = -2.0;
+
+	/* Constraints 1, 3, 5 have the same direction as constraint 0 */
+	EXPECT_EQ(3U, linprog2d_presolve(&prog));
+	EXPECT_EQ(3U, prog.n);
+	EXPECT_EQ(3U, prog.n_removed);
+	EXPECT_EQ(1.0, Gx[0]);
+	EXPECT_EQ(1.0, Gy[0]);
+	EXPECT_EQ(2.0, h[0]);
+	EXPECT_EQ(-1.0, Gx[1]);
+	EXPECT_EQ(-3.0, h[1]);
+	EXPECT_EQ(0.5, Gy[2]);
+	EXPECT_EQ(0.0, h[2]);
+
+	/* Directions within the tolerance on either side of a grid cell border
+	   are merged; the second pair is further apart */
+	Gx[0] = 0.5 - 1e-13, Gy[0] = 1.0, h[0] = 1.0;
+	Gx[1] = 0.5 + 1e-13, Gy[1] = 1.0, h[1] = 2.0;
+	Gx[2] = 0.25, Gy[2] = 1.0, h[2] = 1.0;
+	Gx[3] = 0.25 + 1e-11, Gy[3] = 1.0, h[3] = 2.0;
+	linprog2d_reset(&prog, 4U);
+	EXPECT_EQ(1U, linprog2d_presolve(&prog));
+	EXPECT_EQ(3U, prog.n);
+	EXPECT_EQ(2.0, h[0]);
+}
+
 void test_linprog2d_categorize() {
 	linprog2d_data_t prog;
 
@@ -918,7 +958,8 @@ void test_linprog2d_track_min_max() {
 	prog.Gx = Gx, prog.Gy = Gy, prog.h = h, prog.dx = dx, prog.y0 = y0;   \
 	prog.x_intersect = x_intersect, prog.ceil = ceil, prog.floor = floor; \
 	prog.capacity = C;                                                    \
-	prog.tmp = tmp;
+	prog.tmp = tmp;                                                       \
+	prog.observer = NULL, prog.presolve = FALSE;
 
 void test_linprog2d_empty() {
 	MKPROG(1U)
@@ -1596,6 +1637,1313 @@ void test_linprog2d_solve_simple_fail() {
 	EXPECT_EQ(LP2D_ERROR, res.status);
 }
 
+void test_sort_indices() {
+	double key[6] = {3.0, -1.0, 2.0, 2.0, 7.0, 0.0};
+	unsigned int idcs[6] = {0, 1, 2, 3, 4, 5};
+	unsigned int i;
+
+	sort_indices(idcs, 0, key); /* Should do nothing */
+	sort_indices(idcs, 6, key);
+	for (i = 1; i < 6; i++) {
+		EXPECT_LE(key[idcs[i - 1]], key[idcs[i]]);
+	}
+	EXPECT_EQ(1U, idcs[0]);
+	EXPECT_EQ(4U, idcs[5]);
+}
+
+/* Simple linear congruential generator returning values in [-1, 1) */
+static double test_rand(unsigned long int *state) {
+	*state = (*state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+	return ((double)(*state) / (double)0x40000000UL) - 1.0;
+}
+
+void test_linprog2d_region_square() {
+	/* Unit square with some redundant constraints */
+	const double Gx[6] = {1.0, -1.0, 0.0, 0.0, 1.0, -2.0};
+	const double Gy[6] = {0.0, 0.0, 1.0, -1.0, 1.0, 0.0};
+	const double h[6] = {0.0, -1.0, 0.0, -1.0, -1.0, -4.0};
+	const double x[5] = {0.5, 0.0, 2.0, 2.0, -0.5};
+	const double y[5] = {0.5, 1.0, 0.5, 2.0, 0.5};
+	unsigned char inside[5];
+	double dist[5];
+
+	linprog2d_region_t *region = linprog2d_region_create(6U);
+	ASSERT_NE(NULL, region);
+	EXPECT_TRUE(linprog2d_region_prepare(region, Gx, Gy, h, 6U));
+	EXPECT_FALSE(linprog2d_region_empty(region));
+
+	linprog2d_region_contains(region, x, y, inside, 5U);
+	EXPECT_EQ(1, inside[0]);
+	EXPECT_EQ(1, inside[1]);
+	EXPECT_EQ(0, inside[2]);
+	EXPECT_EQ(0, inside[3]);
+	EXPECT_EQ(0, inside[4]);
+
+	linprog2d_region_distance(region, x, y, dist, 5U);
+	EXPECT_NEAR(-0.5, dist[0], 1e-12);
+	EXPECT_NEAR(0.0, dist[1], 1e-12);
+	EXPECT_NEAR(1.0, dist[2], 1e-12);
+	EXPECT_NEAR(sqrt(2.0), dist[3], 1e-12);
+	EXPECT_NEAR(0.5, dist[4], 1e-12);
+
+	/* The capacity of the region must not be exceeded */
+	EXPECT_FALSE(linprog2d_region_prepare(region, Gx, Gy, h, 7U));
+
+	linprog2d_region_free(region);
+}
+
+void test_linprog2d_region_unbounded() {
+	/* Region above the vee y >= |x| and below the line y <= 2 + 0.5 x */
+	const double Gx[3] = {1.0, -1.0, 0.5};
+	const double Gy[3] = {1.0, 1.0, -1.0};
+	const double h[3] = {0.0, 0.0, -2.0};
+	const double x[4] = {0.0, 0.0, 5.0, -1.0};
+	const double y[4] = {1.0, -1.0, 4.0, 1.2};
+	unsigned char inside[4];
+	double dist[4];
+
+	linprog2d_region_t *region = linprog2d_region_create(3U);
+	ASSERT_NE(NULL, region);
+	EXPECT_TRUE(linprog2d_region_prepare(region, Gx, Gy, h, 2U));
+
+	/* Only the vee; the region is unbounded */
+	linprog2d_region_contains(region, x, y, inside, 4U);
+	EXPECT_EQ(1, inside[0]);
+	EXPECT_EQ(0, inside[1]);
+	EXPECT_EQ(0, inside[2]);
+	EXPECT_EQ(1, inside[3]);
+	linprog2d_region_distance(region, x, y, dist, 4U);
+	EXPECT_NEAR(-sqrt(0.5), dist[0], 1e-12);
+	EXPECT_NEAR(1.0, dist[1], 1e-12);
+	EXPECT_NEAR(sqrt(0.5), dist[2], 1e-12);
+
+	/* Add the ceiling; the region is a triangle with the tips (0, 0),
+	   (-4/3, 4/3) and (4, 4) */
+	EXPECT_TRUE(linprog2d_region_prepare(region, Gx, Gy, h, 3U));
+	linprog2d_region_contains(region, x, y, inside, 4U);
+	EXPECT_EQ(1, inside[0]);
+	EXPECT_EQ(0, inside[1]);
+	EXPECT_EQ(0, inside[2]);
+	EXPECT_EQ(1, inside[3]);
+	linprog2d_region_distance(region, x, y, dist, 4U);
+	EXPECT_NEAR(hypot_(1.0, 0.0), dist[2], 1e-12);
+
+	linprog2d_region_free(region);
+}
+
+void test_linprog2d_region_empty() {
+	const double Gx[3] = {1.0, -1.0, 0.0};
+	const double Gy[3] = {1.0, -1.0, 0.0};
+	const double h[3] = {1.0, 1.0, 1.0};
+	const double x[1] = {0.0}, y[1] = {0.0};
+	unsigned char inside[1];
+	double dist[1];
+
+	linprog2d_region_t *region = linprog2d_region_create(3U);
+	ASSERT_NE(NULL, region);
+
+	/* Parallel floor and ceiling, the floor is above the ceiling */
+	EXPECT_TRUE(linprog2d_region_prepare(region, Gx, Gy, h, 2U));
+	EXPECT_TRUE(linprog2d_region_empty(region));
+	linprog2d_region_contains(region, x, y, inside, 1U);
+	EXPECT_EQ(0, inside[0]);
+	linprog2d_region_distance(region, x, y, dist, 1U);
+	EXPECT_EQ(HUGE_VAL, dist[0]);
+
+	/* Constraint of the form 0 >= 1 */
+	EXPECT_TRUE(linprog2d_region_prepare(region, Gx + 2, Gy + 2, h + 2, 1U));
+	EXPECT_TRUE(linprog2d_region_empty(region));
+
+	/* No constraints at all */
+	EXPECT_TRUE(linprog2d_region_prepare(region, Gx, Gy, h, 0U));
+	EXPECT_FALSE(linprog2d_region_empty(region));
+	linprog2d_region_contains(region, x, y, inside, 1U);
+	EXPECT_EQ(1, inside[0]);
+
+	linprog2d_region_free(region);
+}
+
+void test_linprog2d_region_random() {
+#define N_CONSTRAINTS 200U
+#define N_QUERIES 1001U
+	double Gx[N_CONSTRAINTS], Gy[N_CONSTRAINTS], h[N_CONSTRAINTS];
+	double x[N_QUERIES], y[N_QUERIES], dist[N_QUERIES], slack, min_slack;
+	unsigned char inside[N_QUERIES];
+	unsigned long int state = 4217UL;
+	unsigned int i, j, n_inside = 0U;
+	linprog2d_region_t *region;
+
+	/* Random constraints that all contain the origin */
+	for (i = 0U; i < N_CONSTRAINTS; i++) {
+		Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+		h[i] = -(0.1 + fabs(test_rand(&state)));
+	}
+	for (i = 0U; i < N_QUERIES; i++) {
+		x[i] = 4.0 * test_rand(&state), y[i] = 4.0 * test_rand(&state);
+	}
+
+	region = linprog2d_region_create(N_CONSTRAINTS);
+	ASSERT_NE(NULL, region);
+	EXPECT_TRUE(
+	    linprog2d_region_prepare(region, Gx, Gy, h, N_CONSTRAINTS));
+	linprog2d_region_contains(region, x, y, inside, N_QUERIES);
+	linprog2d_region_distance(region, x, y, dist, N_QUERIES);
+
+	/* Compare with a brute-force implementation */
+	for (i = 0U; i < N_QUERIES; i++) {
+		min_slack = HUGE_VAL;
+		for (j = 0U; j < N_CONSTRAINTS; j++) {
+			slack = (Gx[j] * x[i] + Gy[j] * y[i] - h[j]) / hypot_(Gx[j], Gy[j]);
+			min_slack = fmin_(min_slack, slack);
+		}
+		if (fabs(min_slack) > 1e-9) {
+			EXPECT_EQ(min_slack > 0.0, inside[i]);
+		}
+		if (min_slack > 0.0) {
+			/* Inside the distance is the smallest slack */
+			EXPECT_NEAR(-min_slack, dist[i], 1e-9);
+			n_inside++;
+		} else {
+			/* Outside the distance is at least the largest violation */
+			EXPECT_GE(dist[i] + 1e-9, -min_slack);
+		}
+	}
+	EXPECT_LT(0U, n_inside);
+
+	linprog2d_region_free(region);
+#undef N_CONSTRAINTS
+#undef N_QUERIES
+}
+
+/* Compares two results up to the given tolerance */
+static void expect_result_near(linprog2d_result_t should, linprog2d_result_t is,
+                               double err) {
+	EXPECT_EQ(should.status, is.status);
+	if (should.status == is.status && should.status >= LP2D_EDGE) {
+		EXPECT_NEAR(should.x1, is.x1, err);
+		EXPECT_NEAR(should.y1, is.y1, err);
+	}
+	if (should.status == is.status && should.status == LP2D_EDGE) {
+		EXPECT_NEAR(should.x2, is.x2, err);
+		EXPECT_NEAR(should.y2, is.y2, err);
+	}
+}
+
+void test_linprog2d_dynamic_simple() {
+	/* Example from Numerical Recipes 3rd ed. pp. 529; see p. 534 for fig. */
+	const double Gx[3] = {-2.0, 1.0, -1.0};
+	const double Gy[3] = {-1.0, 1.0, -3.0};
+	const double h[3] = {-70.0, 40.0, -90.0};
+	unsigned int handles[3], i;
+	linprog2d_result_t res;
+
+	linprog2d_dynamic_t *dyn = linprog2d_dynamic_create(3U, -40.0, -60.0);
+	ASSERT_NE(NULL, dyn);
+
+	res = linprog2d_dynamic_result(dyn);
+	EXPECT_EQ(LP2D_UNBOUNDED, res.status);
+
+	for (i = 0U; i < 3U; i++) {
+		handles[i] = linprog2d_dynamic_insert(dyn, Gx[i], Gy[i], h[i]);
+		EXPECT_NE(LINPROG2D_INVALID_HANDLE, handles[i]);
+	}
+	EXPECT_EQ(3U, linprog2d_dynamic_size(dyn));
+	EXPECT_EQ(LINPROG2D_INVALID_HANDLE,
+	          linprog2d_dynamic_insert(dyn, 1.0, 1.0, 1.0));
+
+	res = linprog2d_dynamic_result(dyn);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_NEAR(24.0, res.x1, 1e-4);
+	EXPECT_NEAR(22.0, res.y1, 1e-4);
+
+	/* Without the first constraint, the problem is unbounded */
+	EXPECT_TRUE(linprog2d_dynamic_remove(dyn, handles[0]));
+	EXPECT_FALSE(linprog2d_dynamic_remove(dyn, handles[0]));
+	EXPECT_FALSE(linprog2d_dynamic_remove(dyn, 1000U));
+	res = linprog2d_dynamic_result(dyn);
+	EXPECT_EQ(LP2D_UNBOUNDED, res.status);
+
+	/* Add a constraint that is always false; it reuses the slot of the
+	   removed constraint, whose stale handle must not remove it */
+	i = handles[0];
+	handles[0] = linprog2d_dynamic_insert(dyn, 0.0, 0.0, 1.0);
+	EXPECT_NE(i, handles[0]);
+	EXPECT_FALSE(linprog2d_dynamic_remove(dyn, i));
+	res = linprog2d_dynamic_result(dyn);
+	EXPECT_EQ(LP2D_INFEASIBLE, res.status);
+	EXPECT_TRUE(linprog2d_dynamic_remove(dyn, handles[0]));
+
+	/* Re-add the first constraint */
+	handles[0] = linprog2d_dynamic_insert(dyn, Gx[0], Gy[0], h[0]);
+	res = linprog2d_dynamic_result(dyn);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_NEAR(24.0, res.x1, 1e-4);
+	EXPECT_NEAR(22.0, res.y1, 1e-4);
+
+	linprog2d_dynamic_free(dyn);
+}
+
+void test_linprog2d_dynamic_edges() {
+	/* Box [-1, 2] x [-3, 4] with some redundant parallel constraints */
+	const double Gx[8] = {1.0, -1.0, 0.0, 0.0, 2.0, 0.0, 0.0, -1.0};
+	const double Gy[8] = {0.0, 0.0, 1.0, -1.0, 0.0, 3.0, 1.0, 0.0};
+	const double h[8] = {-1.0, -2.0, -3.0, -4.0, -4.0, -10.0, -3.0, -1.5};
+	const double c[4][2] = {{0.0, 1.0}, {0.0, -1.0}, {1.0, 0.0}, {1.0, 1.0}};
+	unsigned int i, j;
+	linprog2d_t *prog = linprog2d_create(8U);
+	ASSERT_NE(NULL, prog);
+
+	for (i = 0U; i < 4U; i++) {
+		linprog2d_dynamic_t *dyn =
+		    linprog2d_dynamic_create(8U, c[i][0], c[i][1]);
+		ASSERT_NE(NULL, dyn);
+		for (j = 0U; j < 8U; j++) {
+			linprog2d_dynamic_insert(dyn, Gx[j], Gy[j], h[j]);
+			expect_result_near(
+			    linprog2d_solve(prog, c[i][0], c[i][1], Gx, Gy, h, j + 1U),
+			    linprog2d_dynamic_result(dyn), 1e-9);
+		}
+		linprog2d_dynamic_free(dyn);
+	}
+	linprog2d_free(prog);
+}
+
+void test_linprog2d_dynamic_random() {
+#define CAPACITY 64U
+	double Gx[CAPACITY], Gy[CAPACITY], h[CAPACITY];
+	unsigned int handles[CAPACITY], n = 0U, i, j, round;
+	unsigned long int state = 9931UL;
+	linprog2d_result_t res_static, res_dynamic;
+	linprog2d_dynamic_t *dyn;
+	linprog2d_t *prog = linprog2d_create(CAPACITY);
+	ASSERT_NE(NULL, prog);
+
+	for (round = 0U; round < 10U; round++) {
+		const double cx = test_rand(&state), cy = test_rand(&state);
+		dyn = linprog2d_dynamic_create(CAPACITY, cx, cy);
+		ASSERT_NE(NULL, dyn);
+		n = 0U;
+		for (i = 0U; i < 500U; i++) {
+			if (n < CAPACITY && (n < 4U || test_rand(&state) > -0.2)) {
+				/* Insert a random constraint containing the origin */
+				Gx[n] = test_rand(&state), Gy[n] = test_rand(&state);
+				h[n] = -(0.1 + fabs(test_rand(&state)));
+				handles[n] = linprog2d_dynamic_insert(dyn, Gx[n], Gy[n], h[n]);
+				ASSERT_NE(LINPROG2D_INVALID_HANDLE, handles[n]);
+				n++;
+			} else {
+				/* Remove a random constraint */
+				j = (unsigned int)((test_rand(&state) + 1.0) * 0.5 * n);
+				ASSERT_TRUE(linprog2d_dynamic_remove(dyn, handles[j]));
+				n--;
+				Gx[j] = Gx[n], Gy[j] = Gy[n], h[j] = h[n];
+				handles[j] = handles[n];
+			}
+			ASSERT_EQ(n, linprog2d_dynamic_size(dyn));
+
+			res_static = linprog2d_solve(prog, cx, cy, Gx, Gy, h, n);
+			res_dynamic = linprog2d_dynamic_result(dyn);
+			expect_result_near(res_static, res_dynamic, 1e-6);
+		}
+		linprog2d_dynamic_free(dyn);
+	}
+	linprog2d_free(prog);
+#undef CAPACITY
+}
+
+void test_linprog2d_window_random() {
+#define N_STREAM 400U
+	double Gx[N_STREAM], Gy[N_STREAM], h[N_STREAM];
+	const unsigned int widths[4] = {1U, 3U, 17U, 64U};
+	unsigned long int state = 1723UL;
+	unsigned int i, j, n;
+	linprog2d_window_t *win;
+	linprog2d_t *prog = linprog2d_create(N_STREAM);
+	ASSERT_NE(NULL, prog);
+
+	/* Generate a stream of constraints containing the origin */
+	for (i = 0U; i < N_STREAM; i++) {
+		Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+		h[i] = -(0.1 + fabs(test_rand(&state)));
+	}
+
+	for (j = 0U; j < 4U; j++) {
+		win = linprog2d_window_create(widths[j], 0.3, -0.8);
+		ASSERT_NE(NULL, win);
+		EXPECT_EQ(0U, linprog2d_window_size(win));
+		for (i = 0U; i < N_STREAM; i++) {
+			linprog2d_result_t res =
+			    linprog2d_window_push(win, Gx[i], Gy[i], h[i]);
+			n = (i + 1U < widths[j]) ? i + 1U : widths[j];
+			EXPECT_EQ(n, linprog2d_window_size(win));
+			expect_result_near(linprog2d_solve(prog, 0.3, -0.8, Gx + i + 1U - n,
+			                                   Gy + i + 1U - n, h + i + 1U - n, n),
+			                   res, 1e-6);
+		}
+		linprog2d_window_free(win);
+	}
+	linprog2d_free(prog);
+#undef N_STREAM
+}
+
+void test_linprog2d_kinetic_simple() {
+	/* minimize y w.r.t. y >= x, y >= -x, y >= 0.5 * x + t - 1 */
+	const double Gx[3] = {-1.0, 1.0, -0.5};
+	const double Gy[3] = {1.0, 1.0, 1.0};
+	const double h[3] = {0.0, 0.0, -1.0};
+	const double v[3] = {0.0, 0.0, 1.0};
+	linprog2d_result_t res;
+
+	linprog2d_kinetic_t *kin = linprog2d_kinetic_create(3U);
+	ASSERT_NE(NULL, kin);
+	EXPECT_FALSE(
+	    linprog2d_kinetic_prepare(kin, 0.0, 1.0, Gx, Gy, h, v, 4U, 0.0));
+	ASSERT_TRUE(
+	    linprog2d_kinetic_prepare(kin, 0.0, 1.0, Gx, Gy, h, v, 3U, 0.0));
+	EXPECT_NEAR(1.0, linprog2d_kinetic_next_event(kin), 1e-12);
+
+	res = linprog2d_kinetic_advance(kin, 0.5);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_NEAR(0.0, res.x1, 1e-12);
+	EXPECT_NEAR(0.0, res.y1, 1e-12);
+
+	res = linprog2d_kinetic_advance(kin, 2.0);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_NEAR(-2.0 / 3.0, res.x1, 1e-12);
+	EXPECT_NEAR(2.0 / 3.0, res.y1, 1e-12);
+	EXPECT_EQ(1U, ((linprog2d_kinetic_data_t *)kin)->n_events);
+	EXPECT_TRUE(linprog2d_kinetic_next_event(kin) >= HUGE_VAL);
+
+	/* Going back in time re-solves the problem */
+	res = linprog2d_kinetic_advance(kin, 0.0);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_NEAR(0.0, res.x1, 1e-12);
+	EXPECT_NEAR(0.0, res.y1, 1e-12);
+
+	linprog2d_kinetic_free(kin);
+}
+
+void test_linprog2d_kinetic_random() {
+#define N 32U
+	double Gx[N], Gy[N], h[N], v[N], ht[N], t;
+	unsigned long int state = 8231UL;
+	unsigned int i, k, round, n_steps;
+	linprog2d_result_t res_static, res_kinetic;
+	linprog2d_kinetic_t *kin = linprog2d_kinetic_create(N);
+	linprog2d_t *prog = linprog2d_create(N);
+	ASSERT_NE(NULL, kin);
+	ASSERT_NE(NULL, prog);
+
+	for (round = 0U; round < 20U; round++) {
+		const double cx = test_rand(&state), cy = test_rand(&state);
+		const double wx = test_rand(&state), wy = test_rand(&state);
+		for (i = 0U; i < N; i++) {
+			/* All constraints contain the point (wx, wy) * t, but the slack
+			   w.r.t. this point varies over time */
+			Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+			h[i] = -(0.1 + fabs(test_rand(&state)));
+			v[i] = Gx[i] * wx + Gy[i] * wy - 0.05 * test_rand(&state) - 0.04;
+		}
+		ASSERT_TRUE(
+		    linprog2d_kinetic_prepare(kin, cx, cy, Gx, Gy, h, v, N, 0.0));
+		n_steps = 0U;
+		for (t = 0.0; t < 10.0; t += 0.01, n_steps++) {
+			for (k = 0U; k < N; k++) {
+				ht[k] = h[k] + v[k] * t;
+			}
+			res_static = linprog2d_solve(prog, cx, cy, Gx, Gy, ht, N);
+			res_kinetic = linprog2d_kinetic_advance(kin, t);
+			expect_result_near(res_static, res_kinetic, 1e-6);
+		}
+
+		/* Events should be much rarer than timesteps */
+		EXPECT_GT(n_steps, ((linprog2d_kinetic_data_t *)kin)->n_events);
+	}
+	linprog2d_kinetic_free(kin);
+	linprog2d_free(prog);
+#undef N
+}
+
+void test_linprog2d_kinetic_infeasible() {
+#define N 16U
+	double Gx[N], Gy[N], h[N], v[N], ht[N], t;
+	unsigned long int state = 5417UL;
+	unsigned int i, k, round, n_infeasible = 0U;
+	linprog2d_result_t res_static, res_kinetic;
+	linprog2d_kinetic_t *kin = linprog2d_kinetic_create(N);
+	linprog2d_t *prog = linprog2d_create(N);
+	ASSERT_NE(NULL, kin);
+	ASSERT_NE(NULL, prog);
+
+	for (round = 0U; round < 200U; round++) {
+		const double cx = test_rand(&state), cy = test_rand(&state);
+		for (i = 0U; i < N; i++) {
+			/* Arbitrary offsets and drifts; the feasible region appears,
+			   moves, and becomes empty again */
+			Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+			h[i] = test_rand(&state), v[i] = test_rand(&state);
+		}
+		ASSERT_TRUE(
+		    linprog2d_kinetic_prepare(kin, cx, cy, Gx, Gy, h, v, N, 0.0));
+		for (t = 0.0; t < 10.0; t += 0.05) {
+			for (k = 0U; k < N; k++) {
+				ht[k] = h[k] + v[k] * t;
+			}
+			res_static = linprog2d_solve(prog, cx, cy, Gx, Gy, ht, N);
+			res_kinetic = linprog2d_kinetic_advance(kin, t);
+			expect_result_near(res_static, res_kinetic, 1e-6);
+			n_infeasible += (res_static.status == LP2D_INFEASIBLE) ? 1U : 0U;
+		}
+	}
+
+	/* Make sure the problems actually drift into infeasibility */
+	EXPECT_LT(1000U, n_infeasible);
+	linprog2d_kinetic_free(kin);
+	linprog2d_free(prog);
+#undef N
+}
+
+/* Generates a random convex polygon with n vertices in counter-clockwise order
+   and the corresponding angle-sorted constraints */
+static void test_random_polygon(double *x, double *y, double *Gx, double *Gy,
+                                double *h, unsigned int n,
+                                unsigned long int *state) {
+	double theta = 0.0, inc[64], sum = 0.0;
+	const double a = 1.5 + test_rand(state), b = 1.5 + test_rand(state);
+	const double ox = test_rand(state), oy = test_rand(state);
+	unsigned int i, j;
+	for (i = 0U; i < n; i++) {
+		inc[i] = 1.1 + test_rand(state);
+		sum += inc[i];
+	}
+	for (i = 0U; i < n; i++) {
+		x[i] = ox + a * cos(theta), y[i] = oy + b * sin(theta);
+		theta += inc[i] * TWO_PI / sum;
+	}
+	for (i = 0U; i < n; i++) {
+		j = (i + 1U == n) ? 0U : i + 1U;
+		Gx[i] = y[i] - y[j], Gy[i] = x[j] - x[i];
+		h[i] = Gx[i] * x[i] + Gy[i] * y[i];
+	}
+}
+
+void test_sorted_angle() {
+	const struct vec2 ref = vec2_create(0.6, -0.8);
+	struct vec2 v;
+	double prev = -1.0, a, theta;
+	unsigned int i;
+
+	/* The pseudo-angle increases monotonically with the angle */
+	for (i = 0U; i < 720U; i++) {
+		theta = atan2(ref.y, ref.x) + (i + 0.5) * TWO_PI / 720.0;
+		v = vec2_create(3.0 * cos(theta), 3.0 * sin(theta));
+		a = sorted_angle(ref, v);
+		EXPECT_GE(a, 0.0);
+		EXPECT_LT(a, 4.0);
+		EXPECT_GT(a, prev);
+		prev = a;
+	}
+	EXPECT_EQ(0.0, sorted_angle(ref, ref));
+	EXPECT_NEAR(1.0, sorted_angle(ref, vec2_create(0.8, 0.6)), 1e-12);
+	EXPECT_NEAR(2.0, sorted_angle(ref, vec2_create(-0.6, 0.8)), 1e-12);
+	EXPECT_NEAR(3.0, sorted_angle(ref, vec2_create(-0.8, -0.6)), 1e-12);
+	EXPECT_EQ(0.0, sorted_angle(ref, vec2_create(0.0, 0.0)));
+}
+
+void test_linprog2d_solve_sorted_polygon() {
+	double x[64], y[64], Gx[64], Gy[64], h[64], cx, cy;
+	unsigned long int state = 4421UL;
+	unsigned int i, j, k, n, m;
+	linprog2d_result_t res;
+	linprog2d_t *prog = linprog2d_create(64U);
+	ASSERT_NE(NULL, prog);
+
+	for (i = 0U; i < 200U; i++) {
+		n = 3U + i % 61U;
+		test_random_polygon(x, y, Gx, Gy, h, n, &state);
+		for (j = 0U; j < 8U; j++) {
+			cx = test_rand(&state), cy = test_rand(&state);
+			expect_result_near(linprog2d_solve(prog, cx, cy, Gx, Gy, h, n),
+			                   linprog2d_solve_polygon(cx, cy, x, y, n), 1e-9);
+			expect_result_near(linprog2d_solve(prog, cx, cy, Gx, Gy, h, n),
+			                   linprog2d_solve_sorted(cx, cy, Gx, Gy, h, n),
+			                   1e-9);
+
+			/* A contiguous subset of constraints is still sorted, but the
+			   problem may be unbounded */
+			m = 1U + (unsigned int)((test_rand(&state) + 1.0) * 0.5 * n);
+			m = (m > n) ? n : m;
+			expect_result_near(linprog2d_solve(prog, cx, cy, Gx, Gy, h, m),
+			                   linprog2d_solve_sorted(cx, cy, Gx, Gy, h, m),
+			                   1e-9);
+
+			/* Using an edge normal as gradient results in that edge */
+			m = (unsigned int)((test_rand(&state) + 1.0) * 0.5 * n);
+			k = (m + 1U == n) ? 0U : m + 1U;
+			res = linprog2d_solve_polygon(Gx[m], Gy[m], x, y, n);
+			EXPECT_EQ(LP2D_EDGE, res.status);
+			EXPECT_EQ(fmin_(x[m], x[k]), fmin_(res.x1, res.x2));
+			EXPECT_EQ(fmax_(x[m], x[k]), fmax_(res.x1, res.x2));
+			expect_result_near(res,
+			                   linprog2d_solve_sorted(Gx[m], Gy[m], Gx, Gy, h, n),
+			                   1e-9);
+		}
+	}
+	linprog2d_free(prog);
+}
+
+void test_linprog2d_solve_polygon_degenerate() {
+	const double x[4] = {0.0, 1.0, 1.0, 0.0};
+	const double y[4] = {0.0, 0.0, 1.0, 1.0};
+	linprog2d_result_t res;
+
+	res = linprog2d_solve_polygon(1.0, 1.0, x, y, 0U);
+	EXPECT_EQ(LP2D_INFEASIBLE, res.status);
+
+	res = linprog2d_solve_polygon(1.0, 1.0, x + 2, y + 2, 1U);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_EQ(1.0, res.x1);
+	EXPECT_EQ(1.0, res.y1);
+
+	res = linprog2d_solve_polygon(-1.0, 1.0, x, y, 2U);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_EQ(1.0, res.x1);
+	EXPECT_EQ(0.0, res.y1);
+
+	res = linprog2d_solve_polygon(0.0, 1.0, x, y, 2U);
+	EXPECT_EQ(LP2D_EDGE, res.status);
+
+	res = linprog2d_solve_polygon(-1.0, -1.0, x, y, 4U);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_EQ(1.0, res.x1);
+	EXPECT_EQ(1.0, res.y1);
+
+	res = linprog2d_solve_polygon(0.0, 0.0, x, y, 4U);
+	EXPECT_EQ(LP2D_ERROR, res.status);
+}
+
+void test_linprog2d_region_solve_simple() {
+	/* Half-plane y >= 0 clipped by 0 <= x <= 1 */
+	const double Gx[3] = {0.0, 1.0, -1.0};
+	const double Gy[3] = {1.0, 0.0, 0.0};
+	const double h[3] = {0.0, 0.0, -1.0};
+	const double h_inf[2] = {0.0, 1.0};
+	linprog2d_result_t res;
+	linprog2d_region_t *region = linprog2d_region_create(1U);
+	ASSERT_NE(NULL, region);
+	ASSERT_TRUE(linprog2d_region_prepare(region, Gx, Gy, h, 1U));
+
+	res = linprog2d_region_solve(region, 0.0, 1.0, Gx, Gy, h, 0U);
+	EXPECT_EQ(LP2D_UNBOUNDED, res.status);
+	res = linprog2d_region_solve(region, 0.0, 1.0, Gx + 1, Gy + 1, h + 1, 1U);
+	EXPECT_EQ(LP2D_UNBOUNDED, res.status);
+	res = linprog2d_region_solve(region, 0.0, 1.0, Gx + 1, Gy + 1, h + 1, 2U);
+	EXPECT_EQ(LP2D_EDGE, res.status);
+	EXPECT_EQ(0.0, res.x1);
+	EXPECT_EQ(0.0, res.y1);
+	EXPECT_EQ(1.0, res.x2);
+	EXPECT_EQ(0.0, res.y2);
+	res = linprog2d_region_solve(region, 1.0, 1.0, Gx + 1, Gy + 1, h + 1, 2U);
+	EXPECT_EQ(LP2D_POINT, res.status);
+	EXPECT_EQ(0.0, res.x1);
+	EXPECT_EQ(0.0, res.y1);
+	res = linprog2d_region_solve(region, 1.0, -1.0, Gx + 1, Gy + 1, h + 1, 2U);
+	EXPECT_EQ(LP2D_UNBOUNDED, res.status);
+	res = linprog2d_region_solve(region, 0.0, 0.0, Gx + 1, Gy + 1, h + 1, 2U);
+	EXPECT_EQ(LP2D_ERROR, res.status);
+
+	/* Infeasible: x >= 0 and x <= -1 */
+	res = linprog2d_region_solve(region, 1.0, 1.0, Gx + 1, Gy + 1, h_inf, 2U);
+	EXPECT_EQ(LP2D_INFEASIBLE, res.status);
+
+	linprog2d_region_free(region);
+}
+
+void test_linprog2d_region_solve_random() {
+#define N_BASE 300U
+#define N_EXTRA 10U
+	double Gx[N_BASE + N_EXTRA], Gy[N_BASE + N_EXTRA], h[N_BASE + N_EXTRA];
+	unsigned long int state = 6151UL;
+	unsigned int i, j, n, k, round;
+	double cx, cy;
+	linprog2d_region_t *region = linprog2d_region_create(N_BASE);
+	linprog2d_t *prog = linprog2d_create(N_BASE + N_EXTRA);
+	ASSERT_NE(NULL, region);
+	ASSERT_NE(NULL, prog);
+
+	for (round = 0U; round < 100U; round++) {
+		/* Random base region containing the origin; small regions are usually
+		   unbounded */
+		n = (round % 4U == 0U) ? 1U + round % 5U : N_BASE;
+		for (i = 0U; i < n; i++) {
+			Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+			h[i] = -(0.1 + fabs(test_rand(&state)));
+		}
+		ASSERT_TRUE(linprog2d_region_prepare(region, Gx, Gy, h, n));
+
+		for (j = 0U; j < 20U; j++) {
+			/* Additional constraints that cut close to the origin */
+			k = j % (N_EXTRA + 1U);
+			for (i = n; i < n + k; i++) {
+				Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+				h[i] = -0.5 * fabs(test_rand(&state));
+			}
+			cx = test_rand(&state), cy = test_rand(&state);
+			expect_result_near(
+			    linprog2d_solve(prog, cx, cy, Gx, Gy, h, n + k),
+			    linprog2d_region_solve(region, cx, cy, Gx + n, Gy + n, h + n, k),
+			    1e-6);
+		}
+	}
+	linprog2d_region_free(region);
+	linprog2d_free(prog);
+#undef N_BASE
+#undef N_EXTRA
+}
+
+void test_linprog2d_region_solve_axis() {
+#define N_BASE 64U
+#define N_EXTRA 3U
+	static const double C[4][2] = {{1.0, 0.0}, {-1.0, 0.0}, {0.0, 1.0},
+	                               {0.0, -1.0}};
+	double Gx[N_BASE + N_EXTRA], Gy[N_BASE + N_EXTRA], h[N_BASE + N_EXTRA];
+	unsigned long int state = 4409UL;
+	unsigned int i, j, n, k, round;
+	double phi;
+	linprog2d_region_t *region = linprog2d_region_create(N_BASE);
+	linprog2d_t *prog = linprog2d_create(N_BASE + N_EXTRA);
+	ASSERT_NE(NULL, region);
+	ASSERT_NE(NULL, prog);
+
+	for (round = 0U; round < 200U; round++) {
+		/* Bounded region: tangents of the unit circle at random angles in
+		   every quadrant. The leftmost and rightmost points of the region are
+		   vertices in which floor and ceiling meet, so the optimum of an
+		   objective with cy = 0 is a single point. */
+		n = 8U + round % (N_BASE - 7U);
+		for (i = 0U; i < n; i++) {
+			phi = 6.283185307179586 * (i + 0.5 * (1.0 + test_rand(&state))) / n;
+			Gx[i] = -cos(phi), Gy[i] = -sin(phi), h[i] = -1.0;
+		}
+		ASSERT_TRUE(linprog2d_region_prepare(region, Gx, Gy, h, n));
+
+		for (j = 0U; j < 4U * (N_EXTRA + 1U); j++) {
+			/* Additional constraints that may cut off the optimum */
+			k = j / 4U;
+			for (i = n; i < n + k; i++) {
+				Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+				h[i] = -0.5 * fabs(test_rand(&state));
+			}
+			expect_result_near(
+			    linprog2d_solve(prog, C[j % 4U][0], C[j % 4U][1], Gx, Gy, h,
+			                    n + k),
+			    linprog2d_region_solve(region, C[j % 4U][0], C[j % 4U][1],
+			                           Gx + n, Gy + n, h + n, k),
+			    1e-6);
+		}
+	}
+	linprog2d_region_free(region);
+	linprog2d_free(prog);
+#undef N_BASE
+#undef N_EXTRA
+}
+
+void test_linprog2d_sampling_random() {
+#define N 20000U
+	static double Gx[N], Gy[N], h[N];
+	unsigned long int state = 9127UL;
+	unsigned int i, round, n;
+	double cx, cy;
+	linprog2d_sampling_t *smp = linprog2d_sampling_create(N);
+	linprog2d_t *prog = linprog2d_create(N);
+	ASSERT_NE(NULL, smp);
+	ASSERT_NE(NULL, prog);
+	EXPECT_EQ(LP2D_ERROR, linprog2d_sampling_solve(smp, 0.0, 1.0, Gx, Gy, h,
+	                                               N + 1U).status);
+
+	for (round = 0U; round < 40U; round++) {
+		/* Random constraints containing the origin; small problems are solved
+		   directly and are usually unbounded */
+		n = (round % 4U == 0U) ? 1U + round : N;
+		for (i = 0U; i < n; i++) {
+			Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+			h[i] = -(0.1 + fabs(test_rand(&state)));
+		}
+		cx = test_rand(&state), cy = test_rand(&state);
+		expect_result_near(linprog2d_solve(prog, cx, cy, Gx, Gy, h, n),
+		                   linprog2d_sampling_solve(smp, cx, cy, Gx, Gy, h, n),
+		                   1e-6);
+		EXPECT_GT(10U, ((linprog2d_sampling_data_t *)smp)->n_rounds);
+	}
+
+	/* Only floor constraints, maximizing y is unbounded */
+	for (i = 0U; i < N; i++) {
+		Gx[i] = test_rand(&state), Gy[i] = 1.0 + fabs(test_rand(&state));
+		h[i] = test_rand(&state);
+	}
+	EXPECT_EQ(LP2D_POINT,
+	          linprog2d_sampling_solve(smp, 0.0, 1.0, Gx, Gy, h, N).status);
+	EXPECT_EQ(LP2D_UNBOUNDED,
+	          linprog2d_sampling_solve(smp, 0.0, -1.0, Gx, Gy, h, N).status);
+
+	/* A single constraint contradicting the floor constraints */
+	Gx[N / 2U] = 0.0, Gy[N / 2U] = -1.0, h[N / 2U] = 1e3;
+	EXPECT_EQ(LP2D_INFEASIBLE,
+	          linprog2d_sampling_solve(smp, 0.0, 1.0, Gx, Gy, h, N).status);
+
+	linprog2d_sampling_free(smp);
+	linprog2d_free(prog);
+#undef N
+}
+
+/**
+ * Scanner that splits the constraints into three chunks, like the parallel
+ * scan in tools/linprog2d_scan.c, and counts its invocations.
+ */
+static unsigned int test_scanner(void *data,
+                                 const linprog2d_violator_scan_t *scan,
+                                 unsigned int *idx) {
+	static unsigned int chunk[20000U];
+	unsigned int t, i, k = 0U, k_chunk;
+	const unsigned int size = scan->n / 3U;
+	(*(unsigned int *)data)++;
+	for (t = 0U; t < 3U; t++) {
+		k_chunk = linprog2d_violators_find(scan, t * size,
+		                                   (t < 2U) ? (t + 1U) * size : scan->n,
+		                                   chunk);
+		for (i = 0U; i < k_chunk && k <= scan->max_k; i++) {
+			idx[k++] = chunk[i];
+		}
+	}
+	return k;
+}
+
+void test_linprog2d_sampling_scanner() {
+#define N 20000U
+	static double Gx[N], Gy[N], h[N];
+	unsigned long int state = 1187UL;
+	unsigned int i, round, n_calls = 0U;
+	double cx, cy;
+	linprog2d_sampling_t *smp = linprog2d_sampling_create(N);
+	linprog2d_sampling_t *smp_scan = linprog2d_sampling_create(N);
+	ASSERT_NE(NULL, smp);
+	ASSERT_NE(NULL, smp_scan);
+	linprog2d_sampling_set_scanner(smp_scan, test_scanner, &n_calls);
+
+	/* Both instances draw the same samples and must find the same violators */
+	for (round = 0U; round < 10U; round++) {
+		for (i = 0U; i < N; i++) {
+			Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+			h[i] = -(0.1 + fabs(test_rand(&state)));
+		}
+		cx = test_rand(&state), cy = test_rand(&state);
+		expect_result_near(
+		    linprog2d_sampling_solve(smp, cx, cy, Gx, Gy, h, N),
+		    linprog2d_sampling_solve(smp_scan, cx, cy, Gx, Gy, h, N), 0.0);
+		EXPECT_EQ(((linprog2d_sampling_data_t *)smp)->n_rounds,
+		          ((linprog2d_sampling_data_t *)smp_scan)->n_rounds);
+	}
+	EXPECT_NE(0U, n_calls);
+
+	/* Removing the scanner restores the sequential scan */
+	n_calls = 0U;
+	linprog2d_sampling_set_scanner(smp_scan, NULL, NULL);
+	linprog2d_sampling_solve(smp_scan, cx, cy, Gx, Gy, h, N);
+	EXPECT_EQ(0U, n_calls);
+
+	linprog2d_sampling_free(smp_scan);
+	linprog2d_sampling_free(smp);
+#undef N
+}
+
+/* Oracle for the polygon with n_facets edges approximating the unit circle;
+   returns the facet closest in angle to the query point */
+static unsigned int test_circle_oracle(void *data, double x, double y,
+                                       double *Gx, double *Gy, double *h,
+                                       unsigned int max_k) {
+	const double n_facets = *(const double *)data;
+	const double step = TWO_PI / n_facets;
+	const double theta = step * floor(atan2(y, x) / step + 0.5);
+	(void)max_k;
+	Gx[0] = -cos(theta), Gy[0] = -sin(theta), h[0] = -1.0;
+	return (Gx[0] * x + Gy[0] * y < h[0]) ? 1U : 0U;
+}
+
+/* Oracle that never finds a violated constraint */
+static unsigned int test_empty_oracle(void *data, double x, double y,
+                                      double *Gx, double *Gy, double *h,
+                                      unsigned int max_k) {
+	(void)data;
+	(void)x;
+	(void)y;
+	(void)Gx;
+	(void)Gy;
+	(void)h;
+	(void)max_k;
+	return 0U;
+}
+
+void test_linprog2d_cutting_circle() {
+#define N 1000U
+	double Gx[N], Gy[N], h[N], n_facets = N;
+	const double Gx0[2] = {1.0, -1.0}, Gy0[2] = {0.0, 0.0};
+	const double h0[2] = {2.0, 0.0};
+	unsigned long int state = 3371UL;
+	unsigned int i, round;
+	double cx, cy;
+	linprog2d_cutting_t *cut = linprog2d_cutting_create(64U);
+	linprog2d_t *prog = linprog2d_create(N);
+	ASSERT_NE(NULL, cut);
+	ASSERT_NE(NULL, prog);
+	for (i = 0U; i < N; i++) {
+		Gx[i] = -cos(TWO_PI * i / N), Gy[i] = -sin(TWO_PI * i / N);
+		h[i] = -1.0;
+	}
+
+	/* Compare against the materialized polygon */
+	for (round = 0U; round < 50U; round++) {
+		cx = test_rand(&state), cy = test_rand(&state);
+		expect_result_near(linprog2d_solve(prog, cx, cy, Gx, Gy, h, N),
+		                   linprog2d_cutting_solve(cut, cx, cy, NULL, NULL,
+		                                           NULL, 0U, test_circle_oracle,
+		                                           &n_facets),
+		                   1e-6);
+		EXPECT_GT(64U, ((linprog2d_cutting_data_t *)cut)->n_active);
+
+		/* Later rounds start from the basis of the previous round */
+		EXPECT_GT(((linprog2d_cutting_data_t *)cut)->n_rounds,
+		          ((linprog2d_cutting_data_t *)cut)->n_solves);
+	}
+
+	/* Implicit constraints combined with an infeasible initial constraint */
+	EXPECT_EQ(LP2D_INFEASIBLE,
+	          linprog2d_cutting_solve(cut, 1.0, 0.0, Gx0, Gy0, h0, 1U,
+	                                  test_circle_oracle, &n_facets)
+	              .status);
+
+	/* Without the oracle, the half-plane x <= 0 is unbounded */
+	EXPECT_EQ(LP2D_UNBOUNDED,
+	          linprog2d_cutting_solve(cut, 1.0, 0.0, Gx0 + 1, Gy0 + 1, h0 + 1,
+	                                  1U, test_empty_oracle, NULL)
+	              .status);
+
+	/* Slack constraints are dropped, so a small active set suffices for a
+	   very fine polygon. Cuts violated by less than the solver's tolerance
+	   are ignored, which limits the accuracy. */
+	linprog2d_cutting_free(cut);
+	cut = linprog2d_cutting_create(8U);
+	ASSERT_NE(NULL, cut);
+	n_facets = 1e9;
+	expect_result_near(linprog2d_result_create(LP2D_POINT, -0.6, -0.8, 0.0,
+	                                           0.0),
+	                   linprog2d_cutting_solve(cut, 0.3, 0.4, NULL, NULL, NULL,
+	                                           0U, test_circle_oracle,
+	                                           &n_facets),
+	                   1e-4);
+	EXPECT_GT(((linprog2d_cutting_data_t *)cut)->n_rounds, 8U);
+
+	/* The active set is too small for the constraints that are not yet old
+	   enough to be dropped */
+	linprog2d_cutting_free(cut);
+	cut = linprog2d_cutting_create(4U);
+	ASSERT_NE(NULL, cut);
+	EXPECT_EQ(LP2D_ERROR, linprog2d_cutting_solve(cut, 0.3, 0.4, NULL, NULL,
+	                                              NULL, 0U, test_circle_oracle,
+	                                              &n_facets)
+	                          .status);
+
+	linprog2d_cutting_free(cut);
+	linprog2d_free(prog);
+#undef N
+}
+
+void test_linprog2d_presolve_solve() {
+#define N 64U
+	double Gx[2U * N], Gy[2U * N], h[2U * N];
+	unsigned long int state = 5113UL;
+	unsigned int i, round;
+	double cx, cy;
+	linprog2d_result_t res;
+	linprog2d_t *prog = linprog2d_create(2U * N);
+	ASSERT_NE(NULL, prog);
+
+	for (round = 0U; round < 20U; round++) {
+		/* Random constraints followed by scaled copies with looser offsets */
+		for (i = 0U; i < N; i++) {
+			Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+			h[i] = -(0.1 + fabs(test_rand(&state)));
+			Gx[N + i] = 3.0 * Gx[i], Gy[N + i] = 3.0 * Gy[i];
+			h[N + i] = 3.0 * h[i] - fabs(test_rand(&state));
+		}
+		cx = test_rand(&state), cy = test_rand(&state);
+		/* Presolving is disabled by default */
+		EXPECT_EQ(linprog2d_solve(prog, cx, cy, Gx, Gy, h, N).status,
+		          linprog2d_solve(prog, cx, cy, Gx, Gy, h, 2U * N).status);
+		EXPECT_EQ(0U, linprog2d_presolve_removed(prog));
+
+		linprog2d_set_presolve(prog, TRUE);
+		res = linprog2d_solve(prog, cx, cy, Gx, Gy, h, N);
+		EXPECT_EQ(0U, linprog2d_presolve_removed(prog));
+		expect_result_near(res,
+		                   linprog2d_solve(prog, cx, cy, Gx, Gy, h, 2U * N),
+		                   1e-9);
+		EXPECT_EQ(N, linprog2d_presolve_removed(prog));
+		linprog2d_set_presolve(prog, FALSE);
+	}
+	linprog2d_free(prog);
+#undef N
+}
+
+void test_linprog2d_cache() {
+#define N 16U
+#define N_PROBLEMS 5U
+	double Gx[N_PROBLEMS][N], Gy[N_PROBLEMS][N], h[N_PROBLEMS][N];
+	unsigned long int state = 7717UL;
+	unsigned int i, j;
+	linprog2d_result_t res;
+	linprog2d_cache_t *cache = linprog2d_cache_create(3U, N);
+	linprog2d_t *prog = linprog2d_create(N);
+	ASSERT_NE(NULL, cache);
+	ASSERT_NE(NULL, prog);
+	for (j = 0U; j < N_PROBLEMS; j++) {
+		for (i = 0U; i < N; i++) {
+			Gx[j][i] = test_rand(&state), Gy[j][i] = test_rand(&state);
+			h[j][i] = -(0.1 + fabs(test_rand(&state)));
+		}
+	}
+
+	/* Problems that do not fit are rejected */
+	EXPECT_EQ(LP2D_ERROR, linprog2d_cache_solve(cache, 0.0, 1.0, Gx[0], Gy[0],
+	                                            h[0], N + 1U)
+	                          .status);
+
+	/* Fill the cache, then hit every entry */
+	for (j = 0U; j < 3U; j++) {
+		expect_result_near(
+		    linprog2d_solve(prog, 0.3, 0.7, Gx[j], Gy[j], h[j], N),
+		    linprog2d_cache_solve(cache, 0.3, 0.7, Gx[j], Gy[j], h[j], N),
+		    0.0);
+	}
+	EXPECT_EQ(0UL, linprog2d_cache_hits(cache));
+	EXPECT_EQ(3UL, linprog2d_cache_misses(cache));
+	for (j = 3U; j > 0U; j--) {
+		expect_result_near(
+		    linprog2d_solve(prog, 0.3, 0.7, Gx[j - 1U], Gy[j - 1U], h[j - 1U],
+		                    N),
+		    linprog2d_cache_solve(cache, 0.3, 0.7, Gx[j - 1U], Gy[j - 1U],
+		                          h[j - 1U], N),
+		    0.0);
+	}
+	EXPECT_EQ(3UL, linprog2d_cache_hits(cache));
+
+	/* A different gradient, number of constraints, or constraint misses */
+	linprog2d_cache_solve(cache, 0.3, 0.8, Gx[0], Gy[0], h[0], N);
+	linprog2d_cache_solve(cache, 0.3, 0.7, Gx[0], Gy[0], h[0], N - 1U);
+	EXPECT_EQ(3UL, linprog2d_cache_hits(cache));
+	EXPECT_EQ(5UL, linprog2d_cache_misses(cache));
+
+	/* The two problems above evicted problems 2 and 1, but not 0 */
+	linprog2d_cache_solve(cache, 0.3, 0.7, Gx[0], Gy[0], h[0], N);
+	EXPECT_EQ(4UL, linprog2d_cache_hits(cache));
+	linprog2d_cache_solve(cache, 0.3, 0.7, Gx[1], Gy[1], h[1], N);
+	EXPECT_EQ(6UL, linprog2d_cache_misses(cache));
+
+	/* Changing a single constraint in place is detected */
+	h[0][3] -= 1.0;
+	res = linprog2d_cache_solve(cache, 0.3, 0.7, Gx[0], Gy[0], h[0], N);
+	expect_result_near(linprog2d_solve(prog, 0.3, 0.7, Gx[0], Gy[0], h[0], N),
+	                   res, 0.0);
+	EXPECT_EQ(4UL, linprog2d_cache_hits(cache));
+	EXPECT_EQ(7UL, linprog2d_cache_misses(cache));
+
+	linprog2d_cache_free(cache);
+	linprog2d_free(prog);
+#undef N
+#undef N_PROBLEMS
+}
+
+void test_linprog2d_batch() {
+#define N 64U
+#define N_PROBLEMS 40U
+	double Gx[N_PROBLEMS][N], Gy[N_PROBLEMS][N], h[N_PROBLEMS][N];
+	linprog2d_problem_t problems[N_PROBLEMS];
+	linprog2d_result_t res[N_PROBLEMS];
+	unsigned long int state = 3371UL;
+	unsigned int i, j;
+	linprog2d_batch_t *batch = linprog2d_batch_create(N - 1U);
+	linprog2d_t *prog = linprog2d_create(N);
+	ASSERT_NE(NULL, batch);
+	ASSERT_NE(NULL, prog);
+
+	/* Problems of different size; every fourth one is likely infeasible and
+	   the last one does not fit into the batch */
+	for (j = 0U; j < N_PROBLEMS; j++) {
+		for (i = 0U; i < N; i++) {
+			Gx[j][i] = test_rand(&state), Gy[j][i] = test_rand(&state);
+			h[j][i] = ((j % 4U) ? -1.0 : 1.0) * (0.1 + fabs(test_rand(&state)));
+		}
+		problems[j].cx = test_rand(&state), problems[j].cy = test_rand(&state);
+		problems[j].Gx = Gx[j], problems[j].Gy = Gy[j], problems[j].h = h[j];
+		problems[j].n = (j * 7U) % N;
+	}
+	problems[N_PROBLEMS - 1U].n = N;
+
+	linprog2d_batch_solve(batch, problems, res, N_PROBLEMS);
+	for (j = 0U; j < N_PROBLEMS - 1U; j++) {
+		expect_result_near(linprog2d_solve(prog, problems[j].cx, problems[j].cy,
+		                                   Gx[j], Gy[j], h[j], problems[j].n),
+		                   res[j], 0.0);
+	}
+	EXPECT_EQ(LP2D_ERROR, res[N_PROBLEMS - 1U].status);
+
+	/* Part of the problems */
+	linprog2d_batch_solve(batch, problems + 1, res, 2U);
+	expect_result_near(linprog2d_solve(prog, problems[2].cx, problems[2].cy,
+	                                   Gx[2], Gy[2], h[2], problems[2].n),
+	                   res[1], 0.0);
+
+	linprog2d_batch_free(batch);
+	linprog2d_free(prog);
+#undef N
+#undef N_PROBLEMS
+}
+
+/**
+ * Observer state for test_linprog2d_observer.
+ */
+struct test_observer {
+	unsigned int n_calls, n_violations;
+	linprog2d_iteration_t last;
+};
+
+static void test_observer_cb(void *data, const linprog2d_t *prog,
+                             const linprog2d_iteration_t *it) {
+	struct test_observer *o = (struct test_observer *)data;
+	(void)prog;
+
+	/* Iterations are consecutive, the bracket only shrinks, and constraints
+	   are only discarded */
+	if (it->iteration != o->n_calls || it->x0 > it->x1 ||
+	    (o->n_calls && (it->x0 < o->last.x0 || it->x1 > o->last.x1 ||
+	                    it->ceil_len > o->last.ceil_len ||
+	                    it->floor_len > o->last.floor_len))) {
+		o->n_violations++;
+	}
+	o->last = *it;
+	o->n_calls++;
+}
+
+void test_linprog2d_observer() {
+#define N 256U
+	double Gx[N], Gy[N], h[N];
+	unsigned long int state = 8273UL;
+	struct test_observer o;
+	linprog2d_result_t res;
+	unsigned int i, j;
+	linprog2d_t *prog = linprog2d_create(N);
+	ASSERT_NE(NULL, prog);
+
+	linprog2d_set_observer(prog, test_observer_cb, &o);
+	for (j = 0U; j < 20U; j++) {
+		for (i = 0U; i < N; i++) {
+			Gx[i] = test_rand(&state), Gy[i] = test_rand(&state);
+			h[i] = -(0.1 + fabs(test_rand(&state)));
+		}
+		memset(&o, 0, sizeof(o));
+		res = linprog2d_solve(prog, test_rand(&state), test_rand(&state), Gx,
+		                      Gy, h, N);
+		EXPECT_EQ(LP2D_POINT, res.status);
+		EXPECT_EQ(((linprog2d_data_t *)prog)->n_iter, o.n_calls);
+		EXPECT_EQ(0U, o.n_violations);
+		EXPECT_LT(0U, o.n_calls);
+		if (o.last.verdict != LP2D_VERDICT_HERE) {
+			EXPECT_TRUE(o.last.ceil_len <= 1U && o.last.floor_len <= 1U);
+		}
+	}
+
+	/* Removing the observer stops the calls */
+	linprog2d_set_observer(prog, NULL, NULL);
+	memset(&o, 0, sizeof(o));
+	linprog2d_solve(prog, 1.0, 1.0, Gx, Gy, h, N);
+	EXPECT_EQ(0U, o.n_calls);
+
+	linprog2d_free(prog);
+#undef N
+}
+
+#ifdef LINPROG2D_CAPTURE
+static void test_capture_sink(void *data,
+                              const linprog2d_capture_record_t *rec) {
+	EXPECT_EQ(3U, rec->n);
+	EXPECT_LE(0.0, rec->seconds);
+	(*(unsigned int *)data)++;
+}
+
+void test_linprog2d_capture() {
+	const char *filename = "test_linprog2d_capture.bin";
+	const double Gx[3] = {-2.0, 1.0, -1.0};
+	const double Gy[3] = {-1.0, 1.0, -3.0};
+	const double h[3] = {-70.0, 40.0, -90.0};
+	unsigned int head[2];
+	double vals[7], arr[9];
+	char magic[8];
+	unsigned int i, n_records;
+	linprog2d_problem_t problems[2];
+	linprog2d_result_t res, batch_res[2];
+	linprog2d_t *prog = linprog2d_create(3U);
+	linprog2d_cutting_t *cut;
+	linprog2d_batch_t *batch;
+	FILE *f;
+	ASSERT_NE(NULL, prog);
+
+	/* Only the solve while capture is active is written to the file */
+	remove(filename);
+	linprog2d_solve(prog, -5.0, -10.0, Gx, Gy, h, 3U);
+	ASSERT_TRUE(linprog2d_capture_start(filename));
+	res = linprog2d_solve(prog, 1.0, 1.0, Gx, Gy, h, 3U);
+	linprog2d_capture_stop();
+	linprog2d_solve(prog, -5.0, -10.0, Gx, Gy, h, 3U);
+
+	f = fopen(filename, "rb");
+	ASSERT_NE(NULL, f);
+	EXPECT_EQ(8U, fread(magic, 1U, 8U, f));
+	EXPECT_EQ(0, memcmp(magic, CAPTURE_MAGIC, 8U));
+	EXPECT_EQ(2U, fread(head, sizeof(unsigned int), 2U, f));
+	EXPECT_EQ(3U, head[0]);
+	EXPECT_EQ((unsigned int)res.status, head[1]);
+	EXPECT_EQ(7U, fread(vals, sizeof(double), 7U, f));
+	EXPECT_EQ(1.0, vals[0]);
+	EXPECT_EQ(res.x1, vals[2]);
+	EXPECT_EQ(res.y1, vals[3]);
+	EXPECT_LE(0.0, vals[6]);
+	EXPECT_EQ(9U, fread(arr, sizeof(double), 9U, f));
+	EXPECT_EQ(Gx[2], arr[2]);
+	EXPECT_EQ(Gy[0], arr[3]);
+	EXPECT_EQ(h[2], arr[8]);
+	EXPECT_EQ(0U, fread(arr, sizeof(double), 1U, f));
+	fclose(f);
+	remove(filename);
+
+	/* Problems solved internally by the other solvers are not captured */
+	n_records = 0U;
+	linprog2d_capture_set_sink(test_capture_sink, &n_records);
+	cut = linprog2d_cutting_create(8U);
+	ASSERT_NE(NULL, cut);
+	linprog2d_cutting_solve(cut, 1.0, 1.0, Gx, Gy, h, 3U, test_empty_oracle,
+	                        NULL);
+	EXPECT_EQ(0U, n_records);
+	res = linprog2d_solve(prog, 1.0, 1.0, Gx, Gy, h, 3U);
+	EXPECT_EQ(1U, n_records);
+
+	/* Each problem of a batch is captured like a call to linprog2d_solve() */
+	problems[0].cx = 1.0, problems[0].cy = 1.0;
+	problems[1].cx = -5.0, problems[1].cy = -10.0;
+	for (i = 0U; i < 2U; i++) {
+		problems[i].Gx = Gx, problems[i].Gy = Gy, problems[i].h = h;
+		problems[i].n = 3U;
+	}
+	batch = linprog2d_batch_create(3U);
+	ASSERT_NE(NULL, batch);
+	linprog2d_batch_solve(batch, problems, batch_res, 2U);
+	EXPECT_EQ(3U, n_records);
+	linprog2d_capture_stop();
+	linprog2d_solve(prog, 1.0, 1.0, Gx, Gy, h, 3U);
+	linprog2d_batch_solve(batch, problems, batch_res, 2U);
+	EXPECT_EQ(3U, n_records);
+
+	linprog2d_batch_free(batch);
+	linprog2d_cutting_free(cut);
+	linprog2d_free(prog);
+}
+#endif /* LINPROG2D_CAPTURE */
+
+#ifdef LINPROG2D_METRICS
+void test_linprog2d_metrics() {
+	static struct metrics_block before, after;
+	const double Gx[4] = {-2.0, 1.0, -1.0, -1.0};
+	const double Gy[4] = {-1.0, 1.0, -3.0, -3.0};
+	const double h[4] = {-70.0, 40.0, -90.0, -90.0};
+	unsigned long int n_iter = 0UL;
+	unsigned int i, n_threads;
+	char buf[16];
+	linprog2d_problem_t problems[2];
+	linprog2d_result_t res[2];
+	linprog2d_batch_t *batch;
+	linprog2d_t *prog;
+	FILE *f;
+
+	n_threads = metrics_merge(&before);
+	prog = linprog2d_create(3U);
+	ASSERT_NE(NULL, prog);
+	EXPECT_EQ(LP2D_EDGE, linprog2d_solve(prog, 1.0, 1.0, Gx, Gy, h, 3U).status);
+	EXPECT_EQ(LP2D_ERROR, linprog2d_solve(prog, 1.0, 1.0, Gx, Gy, h, 4U).status);
+	linprog2d_free(prog);
+
+	/* The problems of a batch are recorded like calls to linprog2d_solve() */
+	for (i = 0U; i < 2U; i++) {
+		problems[i].cx = 1.0, problems[i].cy = 1.0;
+		problems[i].Gx = Gx, problems[i].Gy = Gy, problems[i].h = h;
+		problems[i].n = 3U + i;
+	}
+	batch = linprog2d_batch_create(3U);
+	ASSERT_NE(NULL, batch);
+	linprog2d_batch_solve(batch, problems, res, 2U);
+	linprog2d_batch_free(batch);
+	EXPECT_EQ(n_threads, metrics_merge(&after));
+
+	/* Iterations are only recorded for problems within the capacity */
+	EXPECT_EQ(2UL, after.status[LP2D_EDGE] - before.status[LP2D_EDGE]);
+	EXPECT_EQ(2UL, after.status[LP2D_ERROR] - before.status[LP2D_ERROR]);
+	EXPECT_EQ(2UL, after.exceeded - before.exceeded);
+	EXPECT_EQ(2UL, after.created[2] - before.created[2]);
+	for (i = 0U; i < METRICS_LATENCY_BUCKETS; i++) {
+		n_iter += after.latency[2][i] - before.latency[2][i];
+		n_iter += after.latency[3][i] - before.latency[3][i];
+	}
+	EXPECT_EQ(4UL, n_iter);
+	for (i = 0U, n_iter = 0UL; i < METRICS_ITER_BUCKETS; i++) {
+		n_iter += after.iter[i] - before.iter[i];
+	}
+	EXPECT_EQ(2UL, n_iter);
+
+	f = tmpfile();
+	ASSERT_NE(NULL, f);
+	linprog2d_metrics_dump(f, LINPROG2D_METRICS_JSON);
+	rewind(f);
+	EXPECT_EQ(15U, fread(buf, 1U, 15U, f));
+	EXPECT_EQ(0, memcmp(buf, "{\n  \"threads\": ", 15U));
+	fclose(f);
+}
+
+static void *test_metrics_thread(void *arg) {
+	const double Gx[3] = {-2.0, 1.0, -1.0};
+	const double Gy[3] = {-1.0, 1.0, -3.0};
+	const double h[3] = {-70.0, 40.0, -90.0};
+	linprog2d_t *prog = linprog2d_create(3U);
+	if (prog) {
+		linprog2d_solve(prog, 1.0, 1.0, Gx, Gy, h, 3U);
+		linprog2d_free(prog);
+	}
+	return arg;
+}
+
+void test_linprog2d_metrics_recycle() {
+	static struct metrics_block before, after;
+	unsigned int i, n_threads;
+	pthread_t thread;
+
+	/* Threads started one after another share a single block */
+	n_threads = metrics_merge(&before);
+	for (i = 0U; i < 4U; i++) {
+		ASSERT_EQ(0, pthread_create(&thread, NULL, test_metrics_thread, NULL));
+		ASSERT_EQ(0, pthread_join(thread, NULL));
+	}
+	EXPECT_LE(metrics_merge(&after), n_threads + 1U);
+	EXPECT_EQ(4UL, after.status[LP2D_EDGE] - before.status[LP2D_EDGE]);
+	EXPECT_EQ(4UL, after.created[2] - before.created[2]);
+}
+#endif /* LINPROG2D_METRICS */
+
 /******************************************************************************
  * Main program                                                               *
  ******************************************************************************/
@@ -1618,6 +2966,7 @@ int main() {
 	RUN(test_linprog2d_condition_problem_offset2);
 	RUN(test_linprog2d_condition_problem_offset_and_rescale_single);
 	RUN(test_linprog2d_condition_problem_offset_and_rescale);
+	RUN(test_linprog2d_presolve);
 	RUN(test_linprog2d_categorize);
 	RUN(test_linprog2d_calculate_intersect);
 	RUN(test_linprog2d_calculate_yoffset_form);
@@ -1663,6 +3012,40 @@ int main() {
 #ifndef __EMSCRIPTEN__
 	RUN(test_linprog2d_solve_simple_fail);
 #endif
+#endif
+	RUN(test_sort_indices);
+	RUN(test_linprog2d_solve_polygon_degenerate);
+#ifndef LINPROG2D_NO_ALLOC
+	RUN(test_sorted_angle);
+	RUN(test_linprog2d_solve_sorted_polygon);
+	RUN(test_linprog2d_region_square);
+	RUN(test_linprog2d_region_unbounded);
+	RUN(test_linprog2d_region_empty);
+	RUN(test_linprog2d_region_random);
+	RUN(test_linprog2d_region_solve_simple);
+	RUN(test_linprog2d_region_solve_random);
+	RUN(test_linprog2d_region_solve_axis);
+	RUN(test_linprog2d_dynamic_simple);
+	RUN(test_linprog2d_dynamic_edges);
+	RUN(test_linprog2d_dynamic_random);
+	RUN(test_linprog2d_window_random);
+	RUN(test_linprog2d_kinetic_simple);
+	RUN(test_linprog2d_kinetic_random);
+	RUN(test_linprog2d_kinetic_infeasible);
+	RUN(test_linprog2d_sampling_random);
+	RUN(test_linprog2d_sampling_scanner);
+	RUN(test_linprog2d_cutting_circle);
+	RUN(test_linprog2d_presolve_solve);
+	RUN(test_linprog2d_cache);
+	RUN(test_linprog2d_batch);
+	RUN(test_linprog2d_observer);
+#endif
+#ifdef LINPROG2D_CAPTURE
+	RUN(test_linprog2d_capture);
+#endif
+#ifdef LINPROG2D_METRICS
+	RUN(test_linprog2d_metrics);
+	RUN(test_linprog2d_metrics_recycle);
 #endif
 
 	fprintf(stderr, ANSI_GRAY "=====" ANSI_RESET "\n");
@@ -0,0 +1,101 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/test_wasm.js
+ *
+ * Tests the memory layout of the JavaScript/WebAssembly library under
+ * Node.js with the native addon disabled. The input arrays of solve() and
+ * batch() must be placed in the workspace behind the static data of the
+ * module, also when solve() is called before batch() has ever been called.
+ * The memory is found by intercepting WebAssembly.Memory; the inputs are
+ * located by searching the memory for their values.
+ *
+ * Usage: node test/test_wasm.js [build directory]
+ *
+ * @author Andreas Stöckel
+ */
+
+'use strict';
+
+const path = require('path');
+
+const dir = path.resolve(process.argv[2] || 'build');
+
+/* Must match WORKSPACE_OFFS in linprog2d.in.js */
+const WORKSPACE_OFFS = 0x80000;
+
+/* Remember the memory the library creates */
+const Memory = WebAssembly.Memory;
+let memory = null;
+WebAssembly.Memory = function(descriptor) {
+	return memory = new Memory(descriptor);
+};
+
+process.env.LINPROG2D_NATIVE = '0';
+const lp = require(dir + '/linprog2d.js').linprog2d;
+
+let n_failed = 0;
+function expect(cond, msg) {
+	console.log((cond ? '[OK]   ' : '[FAIL] ') + msg);
+	n_failed += cond ? 0 : 1;
+}
+
+/**
+ * Returns the byte offset of the first occurrence of the given values in the
+ * memory, or -1.
+ */
+function find(values) {
+	const mem = new Float64Array(memory.buffer);
+	for (let i = 0; i + values.length <= mem.length; i++) {
+		let j = 0;
+		while (j < values.length && mem[i + j] === values[j]) {
+			j++;
+		}
+		if (j === values.length) {
+			return i * 8;
+		}
+	}
+	return -1;
+}
+
+lp.init().then(solve => {
+	/* solve() on a fresh instance; the values are unlikely to appear in the
+	   static data of the module */
+	const Gx = [-2.0078125, 1, -1.001953125];
+	const res = solve(1, 1, Gx, [-1, 1, -3], [-70, 40, -90]);
+	expect(res.status === lp.EDGE, 'solve() before batch() solves the problem');
+	const offs = find(Gx);
+	expect(offs >= WORKSPACE_OFFS,
+	       'solve() before batch() writes to the workspace (offset 0x' +
+	       offs.toString(16) + ')');
+
+	/* The solver region moves behind the batch region */
+	const b = lp.batch(1, 3);
+	b.c.set([1, 1]), b.n.set([3]);
+	b.Gx.set([-2.0009765625, 1, -1.000244140625]);
+	b.Gy.set([-1, 1, -3]), b.h.set([-70, 40, -90]);
+	expect(b.solve()[4] === lp.EDGE, 'batch() solves the problem');
+	expect(find([-2.0009765625, 1, -1.000244140625]) >= WORKSPACE_OFFS,
+	       'batch() writes to the workspace');
+	expect(solve(1, 1, Gx, [-1, 1, -3], [-70, 40, -90]).status === lp.EDGE,
+	       'solve() after batch() solves the problem');
+
+	console.log(n_failed ? n_failed + ' test(s) failed' : 'All tests passed');
+	process.exit(n_failed ? 1 : 0);
+});
@@ -0,0 +1,234 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tools/linprog2d_async.c
+ *
+ * Worker pool behind the asynchronous solver interface. Jobs are passed to
+ * the workers through a bounded multi-producer multi-consumer queue (after
+ * D. Vyukov): each cell carries a sequence number that tells producers and
+ * consumers whether the cell is free or filled for the current lap, so the
+ * queue only needs one compare-and-swap per operation and no locks. Idle
+ * workers sleep on a semaphore that counts the jobs in the queue.
+ *
+ * Uses the GCC/Clang __atomic builtins.
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "linprog2d_async.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdlib.h>
+
+/* Separates the producer and consumer positions to avoid false sharing */
+#define CACHE_LINE 64U
+
+struct cell {
+	unsigned long int seq;
+	linprog2d_async_job_t *job;
+};
+
+struct linprog2d_async {
+	unsigned long int enq_pos;
+	char pad0[CACHE_LINE - sizeof(unsigned long int)];
+	unsigned long int deq_pos;
+	char pad1[CACHE_LINE - sizeof(unsigned long int)];
+	struct cell *cells;
+	unsigned long int mask;
+	sem_t items;
+	int stop;
+	unsigned int capacity, n_threads;
+	pthread_t *threads;
+};
+
+/******************************************************************************
+ * Queue                                                                      *
+ ******************************************************************************/
+
+static int queue_push(linprog2d_async_t *a, linprog2d_async_job_t *job) {
+	struct cell *c;
+	unsigned long int pos = __atomic_load_n(&a->enq_pos, __ATOMIC_RELAXED);
+	long int dif;
+	while (1) {
+		c = &a->cells[pos & a->mask];
+		dif = (long int)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - pos);
+		if (dif == 0L) {
+			if (__atomic_compare_exchange_n(&a->enq_pos, &pos, pos + 1UL, 1,
+			                                __ATOMIC_RELAXED,
+			                                __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (dif < 0L) {
+			return 0; /* The cell still holds a job from the last lap */
+		} else {
+			pos = __atomic_load_n(&a->enq_pos, __ATOMIC_RELAXED);
+		}
+	}
+	c->job = job;
+	__atomic_store_n(&c->seq, pos + 1UL, __ATOMIC_RELEASE);
+	return 1;
+}
+
+static linprog2d_async_job_t *queue_pop(linprog2d_async_t *a) {
+	struct cell *c;
+	linprog2d_async_job_t *job;
+	unsigned long int pos = __atomic_load_n(&a->deq_pos, __ATOMIC_RELAXED);
+	long int dif;
+	while (1) {
+		c = &a->cells[pos & a->mask];
+		dif = (long int)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) -
+		                 (pos + 1UL));
+		if (dif == 0L) {
+			if (__atomic_compare_exchange_n(&a->deq_pos, &pos, pos + 1UL, 1,
+			                                __ATOMIC_RELAXED,
+			                                __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (dif < 0L) {
+			return NULL; /* The cell has not been filled yet */
+		} else {
+			pos = __atomic_load_n(&a->deq_pos, __ATOMIC_RELAXED);
+		}
+	}
+	job = c->job;
+	__atomic_store_n(&c->seq, pos + a->mask + 1UL, __ATOMIC_RELEASE);
+	return job;
+}
+
+/******************************************************************************
+ * Workers                                                                    *
+ ******************************************************************************/
+
+static void *worker_main(void *arg) {
+	linprog2d_async_t *a = (linprog2d_async_t *)arg;
+	linprog2d_async_job_t *job;
+	linprog2d_async_callback_t callback;
+	linprog2d_t *prog = linprog2d_create(a->capacity);
+
+	while (1) {
+		while (sem_wait(&a->items) != 0) {
+			/* Interrupted by a signal */
+		}
+
+		/* A producer may have claimed a cell before ours without having
+		   filled it yet; wait for it instead of sleeping again. */
+		while (!(job = queue_pop(a))) {
+			if (__atomic_load_n(&a->stop, __ATOMIC_ACQUIRE)) {
+				linprog2d_free(prog);
+				return NULL;
+			}
+			sched_yield();
+		}
+
+		if (!prog || linprog2d_capacity(prog) < job->n) {
+			linprog2d_free(prog);
+			prog = linprog2d_create(job->n);
+		}
+		if (prog) {
+			job->result = linprog2d_solve(prog, job->cx, job->cy, job->Gx,
+			                              job->Gy, job->h, job->n);
+		} else {
+			job->result.status = LP2D_ERROR;
+		}
+
+		/* The job belongs to the callback once it is invoked */
+		if ((callback = job->callback)) {
+			callback(job);
+		} else {
+			__atomic_store_n(&job->done, 1, __ATOMIC_RELEASE);
+		}
+	}
+	return NULL;
+}
+
+/******************************************************************************
+ * External API                                                               *
+ ******************************************************************************/
+
+linprog2d_async_t *linprog2d_async_create(unsigned int n_threads,
+                                          unsigned int queue_size,
+                                          unsigned int capacity) {
+	linprog2d_async_t *a;
+	unsigned long int i, size = 2UL;
+	if (n_threads == 0U ||
+	    !(a = (linprog2d_async_t *)calloc(1U, sizeof(linprog2d_async_t)))) {
+		return NULL;
+	}
+	while (size < queue_size) {
+		size *= 2UL;
+	}
+	a->cells = (struct cell *)calloc(size, sizeof(struct cell));
+	a->threads = (pthread_t *)calloc(n_threads, sizeof(pthread_t));
+	if (!a->cells || !a->threads || sem_init(&a->items, 0, 0U) != 0) {
+		free(a->cells);
+		free(a->threads);
+		free(a);
+		return NULL;
+	}
+	for (i = 0UL; i < size; i++) {
+		a->cells[i].seq = i;
+	}
+	a->mask = size - 1UL;
+	a->capacity = capacity;
+	for (; a->n_threads < n_threads; a->n_threads++) {
+		if (pthread_create(&a->threads[a->n_threads], NULL, worker_main, a) !=
+		    0) {
+			linprog2d_async_free(a);
+			return NULL;
+		}
+	}
+	return a;
+}
+
+void linprog2d_async_free(linprog2d_async_t *a) {
+	unsigned int i;
+	if (!a) {
+		return;
+	}
+
+	/* Each worker exits once it wakes up to an empty queue */
+	__atomic_store_n(&a->stop, 1, __ATOMIC_RELEASE);
+	for (i = 0U; i < a->n_threads; i++) {
+		sem_post(&a->items);
+	}
+	for (i = 0U; i < a->n_threads; i++) {
+		pthread_join(a->threads[i], NULL);
+	}
+	sem_destroy(&a->items);
+	free(a->threads);
+	free(a->cells);
+	free(a);
+}
+
+int linprog2d_async_submit(linprog2d_async_t *a, linprog2d_async_job_t *job) {
+	job->done = 0;
+	if (!queue_push(a, job)) {
+		return 0;
+	}
+	sem_post(&a->items);
+	return 1;
+}
+
+int linprog2d_async_done(const linprog2d_async_job_t *job) {
+	return __atomic_load_n(&job->done, __ATOMIC_ACQUIRE);
+}
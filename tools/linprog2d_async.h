@@ -0,0 +1,107 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tools/linprog2d_async.h
+ *
+ * Asynchronous solver interface for event-loop based programs. Problems are
+ * described by caller-owned job structures that are submitted to a bounded
+ * lock-free queue and solved on a pool of worker threads. The caller either
+ * polls the job for completion or receives a callback on the worker thread
+ * that solved it (for example to wake up its event loop through a pipe).
+ *
+ * The constraint arrays are not copied; they must remain valid until the job
+ * has completed.
+ *
+ * @author Andreas Stöckel
+ */
+
+#ifndef LINPROG_2D_ASYNC_H_
+#define LINPROG_2D_ASYNC_H_
+
+#include <linprog2d.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct linprog2d_async_job;
+
+/**
+ * Completion callback. Called on a worker thread once the result of the job
+ * is available. The callback takes ownership of the job and may free or
+ * resubmit it.
+ */
+typedef void (*linprog2d_async_callback_t)(struct linprog2d_async_job *job);
+
+/**
+ * A single problem submitted to the worker pool. The caller fills in the
+ * problem and optionally the callback and the user data; result and done are
+ * written by the worker pool.
+ */
+struct linprog2d_async_job {
+	double cx, cy;
+	const double *Gx, *Gy, *h;
+	unsigned int n;
+	linprog2d_async_callback_t callback;
+	void *data;
+	linprog2d_result_t result;
+	int done;
+};
+
+typedef struct linprog2d_async_job linprog2d_async_job_t;
+
+/**
+ * Opaque type representing the worker pool.
+ */
+typedef struct linprog2d_async linprog2d_async_t;
+
+/**
+ * Starts n_threads worker threads. Each worker owns a solver instance that is
+ * pre-grown to the given capacity and grows further on demand. queue_size is
+ * the maximum number of jobs waiting to be solved and is rounded up to a
+ * power of two. Returns null on failure.
+ */
+linprog2d_async_t *linprog2d_async_create(unsigned int n_threads,
+                                          unsigned int queue_size,
+                                          unsigned int capacity);
+
+/**
+ * Solves all jobs still in the queue, stops the workers, and frees the pool.
+ * Must not be called while other threads submit jobs.
+ */
+void linprog2d_async_free(linprog2d_async_t *async);
+
+/**
+ * Places the job in the queue without blocking. May be called from any
+ * thread. Returns zero if the queue is full.
+ */
+int linprog2d_async_submit(linprog2d_async_t *async,
+                           linprog2d_async_job_t *job);
+
+/**
+ * Returns non-zero once the result of the job is available. Must only be used
+ * for jobs without callback.
+ */
+int linprog2d_async_done(const linprog2d_async_job_t *job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINPROG_2D_ASYNC_H_ */
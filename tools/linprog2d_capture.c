@@ -0,0 +1,207 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file tools/linprog2d_capture.c
+ *
+ * Background writer behind the capture sink. Records are serialized into a
+ * byte ring buffer under a mutex; the writer thread waits on a condition
+ * variable, and writes the filled part of the buffer to the file without
+ * holding the mutex, so solving threads are only held up by the copy.
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "linprog2d_capture.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Magic bytes at the beginning of each capture file, see linprog2d.c */
+#define CAPTURE_MAGIC "LP2DCAP1"
+
+struct linprog2d_capture_writer {
+	pthread_mutex_t mutex;
+	pthread_cond_t filled;
+	pthread_t thread;
+	FILE *f;
+	char *buf;
+
+	/* Total number of bytes written to and read from the buffer; the
+	   difference is the number of bytes waiting to be written */
+	unsigned long int head, tail, size;
+	unsigned long int n_dropped;
+	int stop;
+};
+
+/******************************************************************************
+ * Ring buffer                                                                *
+ ******************************************************************************/
+
+/**
+ * Copies n bytes to the ring buffer. The caller must have checked that there
+ * is enough space.
+ */
+static void ring_put(linprog2d_capture_writer_t *w, const void *src,
+                     unsigned long int n) {
+	const unsigned long int offs = w->head % w->size;
+	const unsigned long int n0 = (n < w->size - offs) ? n : w->size - offs;
+	memcpy(w->buf + offs, src, n0);
+	memcpy(w->buf, (const char *)src + n0, n - n0);
+	w->head += n;
+}
+
+/**
+ * Capture sink. Serializes the record in the format of capture_write() in
+ * linprog2d.c.
+ */
+static void writer_sink(void *data, const linprog2d_capture_record_t *rec) {
+	linprog2d_capture_writer_t *w = (linprog2d_capture_writer_t *)data;
+	const unsigned long int arr = sizeof(double) * rec->n;
+	const unsigned long int n = sizeof(unsigned int) * 2U +
+	                            sizeof(double) * 7U + 3U * arr;
+	unsigned int head[2];
+	double vals[7];
+	head[0] = rec->n, head[1] = (unsigned int)rec->res.status;
+	vals[0] = rec->cx, vals[1] = rec->cy;
+	vals[2] = rec->res.x1, vals[3] = rec->res.y1;
+	vals[4] = rec->res.x2, vals[5] = rec->res.y2;
+	vals[6] = rec->seconds;
+
+	pthread_mutex_lock(&w->mutex);
+	if (w->size - (w->head - w->tail) < n) {
+		w->n_dropped++;
+	} else {
+		ring_put(w, head, sizeof(head));
+		ring_put(w, vals, sizeof(vals));
+		ring_put(w, rec->Gx, arr);
+		ring_put(w, rec->Gy, arr);
+		ring_put(w, rec->h, arr);
+		pthread_cond_signal(&w->filled);
+	}
+	pthread_mutex_unlock(&w->mutex);
+}
+
+/******************************************************************************
+ * Writer thread                                                              *
+ ******************************************************************************/
+
+static void *writer_main(void *arg) {
+	linprog2d_capture_writer_t *w = (linprog2d_capture_writer_t *)arg;
+	unsigned long int offs, n;
+	pthread_mutex_lock(&w->mutex);
+	while (1) {
+		while (!w->stop && w->head == w->tail) {
+			pthread_cond_wait(&w->filled, &w->mutex);
+		}
+		if (w->head == w->tail) {
+			break; /* Stopped and drained */
+		}
+
+		/* Write the contiguous part after the tail; the sinks only append
+		   behind the head, so the region stays valid without the lock */
+		offs = w->tail % w->size;
+		n = w->head - w->tail;
+		n = (n < w->size - offs) ? n : w->size - offs;
+		pthread_mutex_unlock(&w->mutex);
+		fwrite(w->buf + offs, 1U, n, w->f);
+		pthread_mutex_lock(&w->mutex);
+		w->tail += n;
+	}
+	pthread_mutex_unlock(&w->mutex);
+	return NULL;
+}
+
+/******************************************************************************
+ * External API                                                               *
+ ******************************************************************************/
+
+linprog2d_capture_writer_t *linprog2d_capture_writer_start(
+    const char *filename, unsigned long int buf_size) {
+	linprog2d_capture_writer_t *w;
+	if (buf_size == 0UL || !(w = (linprog2d_capture_writer_t *)calloc(
+	                             1U, sizeof(linprog2d_capture_writer_t)))) {
+		return NULL;
+	}
+	w->size = buf_size;
+	if (!(w->buf = (char *)malloc(buf_size))) {
+		free(w);
+		return NULL;
+	}
+	if (!(w->f = fopen(filename, "ab"))) {
+		free(w->buf);
+		free(w);
+		return NULL;
+	}
+	fseek(w->f, 0L, SEEK_END);
+	if (ftell(w->f) == 0L) {
+		fwrite(CAPTURE_MAGIC, 1U, sizeof(CAPTURE_MAGIC) - 1U, w->f);
+	}
+	if (pthread_mutex_init(&w->mutex, NULL) != 0) {
+		fclose(w->f);
+		free(w->buf);
+		free(w);
+		return NULL;
+	}
+	if (pthread_cond_init(&w->filled, NULL) != 0) {
+		pthread_mutex_destroy(&w->mutex);
+		fclose(w->f);
+		free(w->buf);
+		free(w);
+		return NULL;
+	}
+	if (pthread_create(&w->thread, NULL, writer_main, w) != 0) {
+		pthread_cond_destroy(&w->filled);
+		pthread_mutex_destroy(&w->mutex);
+		fclose(w->f);
+		free(w->buf);
+		free(w);
+		return NULL;
+	}
+	linprog2d_capture_set_sink(writer_sink, w);
+	return w;
+}
+
+void linprog2d_capture_writer_stop(linprog2d_capture_writer_t *w) {
+	if (!w) {
+		return;
+	}
+	linprog2d_capture_set_sink(NULL, NULL);
+	pthread_mutex_lock(&w->mutex);
+	w->stop = 1;
+	pthread_cond_signal(&w->filled);
+	pthread_mutex_unlock(&w->mutex);
+	pthread_join(w->thread, NULL);
+	pthread_cond_destroy(&w->filled);
+	pthread_mutex_destroy(&w->mutex);
+	fclose(w->f);
+	free(w->buf);
+	free(w);
+}
+
+unsigned long int linprog2d_capture_writer_dropped(
+    linprog2d_capture_writer_t *w) {
+	unsigned long int res;
+	pthread_mutex_lock(&w->mutex);
+	res = w->n_dropped;
+	pthread_mutex_unlock(&w->mutex);
+	return res;
+}
@@ -0,0 +1,72 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file tools/linprog2d_capture.h
+ *
+ * Background writer for problem capture. Solving threads only copy each
+ * captured problem into a ring buffer; a dedicated thread writes the buffer
+ * to the capture file. The file has the same format as the one written by
+ * linprog2d_capture_start() and can be re-run with test/replay_linprog2d.
+ * If the writer cannot keep up and the buffer is full, problems are dropped
+ * instead of blocking the solving threads.
+ *
+ * Requires a library compiled with the LINPROG2D_CAPTURE flag.
+ *
+ * @author Andreas Stöckel
+ */
+
+#ifndef LINPROG_2D_CAPTURE_H_
+#define LINPROG_2D_CAPTURE_H_
+
+#include <linprog2d.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Opaque type representing the background writer.
+ */
+typedef struct linprog2d_capture_writer linprog2d_capture_writer_t;
+
+/**
+ * Opens the given capture file, starts the writer thread, and installs it as
+ * capture sink using linprog2d_capture_set_sink(). buf_size is the size of
+ * the ring buffer in bytes. Must not be called while other threads solve
+ * problems. Returns null on failure.
+ */
+linprog2d_capture_writer_t *linprog2d_capture_writer_start(
+    const char *filename, unsigned long int buf_size);
+
+/**
+ * Stops capture, writes the remaining buffer contents, and closes the file.
+ * Must not be called while other threads solve problems.
+ */
+void linprog2d_capture_writer_stop(linprog2d_capture_writer_t *writer);
+
+/**
+ * Returns the number of problems dropped because the buffer was full.
+ */
+unsigned long int linprog2d_capture_writer_dropped(
+    linprog2d_capture_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINPROG_2D_CAPTURE_H_ */
@@ -0,0 +1,577 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tools/linprog2d_cli.c
+ *
+ * Command line solver for streams of problems. Problems are read from the
+ * given files or stdin, solved on a pool of worker threads, and the results
+ * are written to stdout in input order.
+ *
+ * Usage: linprog2d-cli [-i csv|bin] [-o csv|bin] [-j threads] [file...]
+ *
+ * CSV input contains one problem per line, "cx,cy,Gx0,Gy0,h0,Gx1,Gy1,h1,...";
+ * empty lines and lines starting with '#' are skipped. CSV output contains one
+ * line "status,x1,y1,x2,y2" per problem, where status is one of "error",
+ * "infeasible", "unbounded", "edge", or "point".
+ *
+ * Binary input consists of records of the number of constraints n as unsigned
+ * int, followed by cx, cy, Gx[n], Gy[n], h[n] as double. Binary output
+ * consists of records of the status as unsigned int, followed by x1, y1, x2,
+ * y2 as double. All binary data is in native byte order.
+ *
+ * Parsing, solving, and writing overlap: the main thread parses problems into
+ * a ring of batches, the workers solve batches as soon as they are parsed, and
+ * a writer thread outputs solved batches in order and hands them back to the
+ * parser. A summary including the throughput is written to stderr.
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <linprog2d.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * Batches                                                                    *
+ ******************************************************************************/
+
+/* Maximum number of problems and constraints per batch */
+#define BATCH_PROBLEMS 1024U
+#define BATCH_CONSTRAINTS 65536UL
+
+/* Number of batches in flight per worker thread */
+#define BATCHES_PER_WORKER 4U
+
+/* Size of the stdio buffers */
+#define IO_BUF_SIZE (1UL << 20)
+
+/**
+ * A batch of problems. The constraints of problem i are stored at
+ * [offs[i], offs[i] + n[i]) in the Gx, Gy, h arrays.
+ */
+struct batch {
+	unsigned int len;
+	unsigned long int n_constraints, pool_size;
+	double cx[BATCH_PROBLEMS], cy[BATCH_PROBLEMS];
+	unsigned int n[BATCH_PROBLEMS];
+	unsigned long int offs[BATCH_PROBLEMS];
+	linprog2d_result_t res[BATCH_PROBLEMS];
+	double *Gx, *Gy, *h;
+};
+
+/**
+ * Makes sure that the batch can hold n additional constraints. Returns zero if
+ * there is not enough memory.
+ */
+static int batch_reserve(struct batch *b, unsigned long int n) {
+	unsigned long int size = b->pool_size ? b->pool_size : BATCH_CONSTRAINTS;
+	double *Gx, *Gy, *h;
+	if (b->n_constraints + n <= b->pool_size) {
+		return 1;
+	}
+	while (size < b->n_constraints + n) {
+		size *= 2UL;
+	}
+	Gx = (double *)realloc(b->Gx, sizeof(double) * size);
+	Gy = Gx ? (double *)realloc(b->Gy, sizeof(double) * size) : NULL;
+	h = Gy ? (double *)realloc(b->h, sizeof(double) * size) : NULL;
+	b->Gx = Gx ? Gx : b->Gx;
+	b->Gy = Gy ? Gy : b->Gy;
+	b->h = h ? h : b->h;
+	if (!h) {
+		return 0;
+	}
+	b->pool_size = size;
+	return 1;
+}
+
+/******************************************************************************
+ * Pipeline                                                                   *
+ ******************************************************************************/
+
+/**
+ * Ring of batches shared between the parser, the workers, and the writer.
+ * Batch number k lives in slot k % n_slots; batches are parsed, claimed by
+ * workers, and written in increasing order.
+ */
+struct pipeline {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct batch *slots;
+	int *solved;
+	unsigned int n_slots;
+	unsigned long int n_parsed, n_claimed, n_written;
+	int eof;
+	int output_binary;
+	int out_of_memory;
+	unsigned long int n_problems, n_constraints;
+};
+
+static void *worker_main(void *arg) {
+	struct pipeline *p = (struct pipeline *)arg;
+	linprog2d_t *prog = NULL;
+	unsigned int capacity = 0U, i;
+	unsigned long int k;
+	struct batch *b;
+	while (1) {
+		/* Claim the next parsed batch */
+		pthread_mutex_lock(&p->mutex);
+		while (p->n_claimed == p->n_parsed && !p->eof) {
+			pthread_cond_wait(&p->cond, &p->mutex);
+		}
+		if (p->n_claimed == p->n_parsed) {
+			pthread_mutex_unlock(&p->mutex);
+			break;
+		}
+		k = p->n_claimed++;
+		pthread_mutex_unlock(&p->mutex);
+
+		/* Solve all problems in the batch, growing the solver as needed. A
+		   problem for which no solver can be allocated results in an error. */
+		b = &p->slots[k % p->n_slots];
+		for (i = 0U; i < b->len; i++) {
+			if (!prog || b->n[i] > capacity) {
+				linprog2d_free(prog);
+				capacity = (b->n[i] > capacity) ? b->n[i] : capacity;
+				if (!(prog = linprog2d_create(capacity))) {
+					__atomic_store_n(&p->out_of_memory, 1, __ATOMIC_RELAXED);
+					b->res[i].status = LP2D_ERROR;
+					b->res[i].x1 = b->res[i].y1 = 0.0;
+					b->res[i].x2 = b->res[i].y2 = 0.0;
+					continue;
+				}
+			}
+			b->res[i] = linprog2d_solve(prog, b->cx[i], b->cy[i],
+			                            b->Gx + b->offs[i], b->Gy + b->offs[i],
+			                            b->h + b->offs[i], b->n[i]);
+		}
+
+		pthread_mutex_lock(&p->mutex);
+		p->solved[k % p->n_slots] = 1;
+		pthread_cond_broadcast(&p->cond);
+		pthread_mutex_unlock(&p->mutex);
+	}
+	linprog2d_free(prog);
+	return NULL;
+}
+
+static void write_batch(const struct pipeline *p, const struct batch *b) {
+	static const char *status_names[] = {"error", "infeasible", "unbounded",
+	                                      "edge", "point"};
+	unsigned int i, status;
+	double vals[4];
+	for (i = 0U; i < b->len; i++) {
+		const linprog2d_result_t *r = &b->res[i];
+		if (p->output_binary) {
+			status = (unsigned int)r->status;
+			vals[0] = r->x1, vals[1] = r->y1, vals[2] = r->x2, vals[3] = r->y2;
+			fwrite(&status, sizeof(unsigned int), 1U, stdout);
+			fwrite(vals, sizeof(double), 4U, stdout);
+		} else if (r->status == LP2D_EDGE) {
+			printf("%s,%.17g,%.17g,%.17g,%.17g\n", status_names[r->status],
+			       r->x1, r->y1, r->x2, r->y2);
+		} else if (r->status == LP2D_POINT) {
+			printf("%s,%.17g,%.17g,,\n", status_names[r->status], r->x1,
+			       r->y1);
+		} else {
+			printf("%s,,,,\n", status_names[r->status]);
+		}
+	}
+}
+
+static void *writer_main(void *arg) {
+	struct pipeline *p = (struct pipeline *)arg;
+	unsigned long int k;
+	struct batch *b;
+	while (1) {
+		/* Wait for the next batch in order to be solved */
+		pthread_mutex_lock(&p->mutex);
+		while (!p->solved[p->n_written % p->n_slots] &&
+		       !(p->eof && p->n_written == p->n_parsed)) {
+			pthread_cond_wait(&p->cond, &p->mutex);
+		}
+		if (p->eof && p->n_written == p->n_parsed) {
+			pthread_mutex_unlock(&p->mutex);
+			break;
+		}
+		k = p->n_written;
+		pthread_mutex_unlock(&p->mutex);
+
+		b = &p->slots[k % p->n_slots];
+		write_batch(p, b);
+		p->n_problems += b->len;
+		p->n_constraints += b->n_constraints;
+
+		/* Hand the batch back to the parser */
+		pthread_mutex_lock(&p->mutex);
+		p->solved[k % p->n_slots] = 0;
+		p->n_written++;
+		pthread_cond_broadcast(&p->cond);
+		pthread_mutex_unlock(&p->mutex);
+	}
+	fflush(stdout);
+	return NULL;
+}
+
+/******************************************************************************
+ * Parsers                                                                    *
+ ******************************************************************************/
+
+/**
+ * Input stream state shared by the parsers.
+ */
+struct input {
+	FILE *f;
+	const char *name;
+	int binary;
+	char *line;
+	unsigned long int line_size, line_no;
+};
+
+/**
+ * Reads the next line into in->line, growing the buffer as needed. Returns
+ * zero at the end of the file.
+ */
+static int read_line(struct input *in) {
+	unsigned long int len = 0UL;
+	char *line;
+	while (1) {
+		if (len + 2UL > in->line_size) {
+			in->line_size = in->line_size ? 2UL * in->line_size : 4096UL;
+			if (!(line = (char *)realloc(in->line, in->line_size))) {
+				return 0;
+			}
+			in->line = line;
+		}
+		if (!fgets(in->line + len, (int)(in->line_size - len), in->f)) {
+			return len > 0UL;
+		}
+		len += strlen(in->line + len);
+		if (len > 0UL && in->line[len - 1UL] == '\n') {
+			return 1;
+		}
+	}
+}
+
+/* Parser results in addition to the number of added problems */
+#define PARSE_ERROR -1
+#define PARSE_OUT_OF_MEMORY -2
+
+/**
+ * Parses a single CSV line into the batch. Returns 1 if a problem was added,
+ * 0 if the line was skipped, PARSE_ERROR on a parse error, and
+ * PARSE_OUT_OF_MEMORY if the batch cannot be grown. On failure, the batch is
+ * left unchanged.
+ */
+static int parse_csv(struct input *in, struct batch *b) {
+	double vals[3];
+	unsigned int i, n = 0U;
+	char *s = in->line, *end;
+	while (*s == ' ' || *s == '\t') {
+		s++;
+	}
+	if (*s == '#' || *s == '\n' || *s == '\r' || *s == '\0') {
+		return 0;
+	}
+
+	/* The first two values are the gradient, followed by triples Gx, Gy, h */
+	b->offs[b->len] = b->n_constraints;
+	for (i = 0U;; i++) {
+		vals[(i < 2U) ? i : (i - 2U) % 3U] = strtod(s, &end);
+		if (end == s) {
+			b->n_constraints = b->offs[b->len];
+			return PARSE_ERROR;
+		}
+		if (i == 1U) {
+			b->cx[b->len] = vals[0], b->cy[b->len] = vals[1];
+		} else if (i > 1U && (i - 2U) % 3U == 2U) {
+			if (!batch_reserve(b, 1UL)) {
+				b->n_constraints = b->offs[b->len];
+				return PARSE_OUT_OF_MEMORY;
+			}
+			b->Gx[b->n_constraints] = vals[0];
+			b->Gy[b->n_constraints] = vals[1];
+			b->h[b->n_constraints] = vals[2];
+			b->n_constraints++, n++;
+		}
+		for (s = end; *s == ' ' || *s == '\t'; s++) {
+		}
+		if (*s != ',') {
+			break;
+		}
+		s++;
+	}
+
+	/* Make sure the line ends after a complete constraint */
+	if ((*s != '\n' && *s != '\r' && *s != '\0') || i < 1U ||
+	    (i > 1U && (i - 2U) % 3U != 2U)) {
+		b->n_constraints = b->offs[b->len];
+		return PARSE_ERROR;
+	}
+	b->n[b->len++] = n;
+	return 1;
+}
+
+/**
+ * Reads a single binary record into the batch. Returns 1 if a problem was
+ * added, 0 at the end of the file, PARSE_ERROR on a truncated record, and
+ * PARSE_OUT_OF_MEMORY if the batch cannot be grown.
+ */
+static int parse_bin(struct input *in, struct batch *b) {
+	unsigned int n;
+	double c[2];
+	unsigned long int o = b->n_constraints;
+	if (fread(&n, sizeof(unsigned int), 1U, in->f) != 1U) {
+		return 0;
+	}
+	if (fread(c, sizeof(double), 2U, in->f) != 2U) {
+		return PARSE_ERROR;
+	}
+	if (!batch_reserve(b, n)) {
+		return PARSE_OUT_OF_MEMORY;
+	}
+	if (fread(b->Gx + o, sizeof(double), n, in->f) != n ||
+	    fread(b->Gy + o, sizeof(double), n, in->f) != n ||
+	    fread(b->h + o, sizeof(double), n, in->f) != n) {
+		return PARSE_ERROR;
+	}
+	b->cx[b->len] = c[0], b->cy[b->len] = c[1];
+	b->offs[b->len] = o;
+	b->n[b->len++] = n;
+	b->n_constraints += n;
+	return 1;
+}
+
+/**
+ * Fills the batch with problems from the input. Returns -1 on error, 0 at the
+ * end of the input, and 1 if the batch is full. On error, the batch holds the
+ * problems read before the error.
+ */
+static int parse_batch(struct input *in, struct batch *b) {
+	int res;
+	b->len = 0U;
+	b->n_constraints = 0UL;
+	while (b->len < BATCH_PROBLEMS && b->n_constraints < BATCH_CONSTRAINTS) {
+		if (in->binary) {
+			res = parse_bin(in, b);
+		} else if (!read_line(in)) {
+			res = 0;
+		} else {
+			in->line_no++;
+			if ((res = parse_csv(in, b)) == 0) {
+				continue;
+			}
+		}
+		if (res == PARSE_OUT_OF_MEMORY) {
+			fprintf(stderr, "Out of memory\n");
+			return -1;
+		} else if (res < 0) {
+			if (in->binary) {
+				fprintf(stderr, "%s: truncated record\n", in->name);
+			} else {
+				fprintf(stderr, "%s:%lu: parse error\n", in->name,
+				        in->line_no);
+			}
+			return -1;
+		} else if (res == 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static void usage(const char *name) {
+	fprintf(stderr,
+	        "Usage: %s [-i csv|bin] [-o csv|bin] [-j threads] [file...]\n",
+	        name);
+}
+
+/**
+ * Parses the value of the -i and -o options. Returns 1 for "bin", 0 for
+ * "csv", and -1 otherwise.
+ */
+static int parse_format(const char *s) {
+	if (strcmp(s, "bin") == 0) {
+		return 1;
+	}
+	return (strcmp(s, "csv") == 0) ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+	struct pipeline p;
+	struct input in;
+	pthread_t *workers, writer;
+	unsigned int i, n_workers, n_started;
+	int arg, res = 0, status = 0, more, has_writer;
+	long int n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	double t0, t1;
+	struct batch *b;
+
+	memset(&p, 0, sizeof(p));
+	memset(&in, 0, sizeof(in));
+	n_workers = (n_cpus > 0L) ? (unsigned int)n_cpus : 1U;
+	for (arg = 1; arg < argc && argv[arg][0] == '-' && argv[arg][1]; arg++) {
+		if (arg + 1 >= argc) {
+			usage(argv[0]);
+			return 1;
+		}
+		if (strcmp(argv[arg], "-i") == 0 && parse_format(argv[arg + 1]) >= 0) {
+			in.binary = parse_format(argv[++arg]);
+		} else if (strcmp(argv[arg], "-o") == 0 &&
+		           parse_format(argv[arg + 1]) >= 0) {
+			p.output_binary = parse_format(argv[++arg]);
+		} else if (strcmp(argv[arg], "-j") == 0 && atoi(argv[arg + 1]) > 0) {
+			n_workers = (unsigned int)atoi(argv[++arg]);
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	/* Allocate the ring of batches */
+	p.n_slots = BATCHES_PER_WORKER * n_workers;
+	p.slots = (struct batch *)calloc(p.n_slots, sizeof(struct batch));
+	p.solved = (int *)calloc(p.n_slots, sizeof(int));
+	workers = (pthread_t *)calloc(n_workers, sizeof(pthread_t));
+	if (!p.slots || !p.solved || !workers) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	setvbuf(stdout, NULL, _IOFBF, IO_BUF_SIZE);
+
+	/* Start the workers and the writer */
+	t0 = now();
+	if (pthread_mutex_init(&p.mutex, NULL) != 0 ||
+	    pthread_cond_init(&p.cond, NULL) != 0) {
+		fprintf(stderr, "Cannot initialise the thread synchronisation\n");
+		return 1;
+	}
+	for (n_started = 0U; n_started < n_workers; n_started++) {
+		if (pthread_create(&workers[n_started], NULL, worker_main, &p) != 0) {
+			break;
+		}
+	}
+	has_writer = n_started > 0U &&
+	             pthread_create(&writer, NULL, writer_main, &p) == 0;
+	if (!has_writer) {
+		fprintf(stderr, "Cannot create threads\n");
+		res = -1;
+	} else if (n_started < n_workers) {
+		fprintf(stderr, "Cannot create threads; using %u of %u\n", n_started,
+		        n_workers);
+		n_workers = n_started;
+	}
+
+	/* Parse all inputs into batches */
+	for (; res >= 0 && (arg < argc || !in.f); arg++) {
+		if (arg >= argc || strcmp(argv[arg], "-") == 0) {
+			in.f = stdin, in.name = "<stdin>";
+		} else if (!(in.f = fopen(argv[arg], in.binary ? "rb" : "r"))) {
+			fprintf(stderr, "Cannot open %s\n", argv[arg]);
+			res = -1;
+			break;
+		} else {
+			in.name = argv[arg];
+		}
+		setvbuf(in.f, NULL, _IOFBF, IO_BUF_SIZE);
+		in.line_no = 0UL;
+
+		for (more = 1; more;) {
+			/* Wait for a free slot */
+			pthread_mutex_lock(&p.mutex);
+			while (p.n_parsed - p.n_written >= p.n_slots) {
+				pthread_cond_wait(&p.cond, &p.mutex);
+			}
+			b = &p.slots[p.n_parsed % p.n_slots];
+			pthread_mutex_unlock(&p.mutex);
+
+			/* Problems before a parse error are still solved */
+			if ((res = parse_batch(&in, b)) <= 0) {
+				more = 0;
+			}
+			if (b->len > 0U) {
+				pthread_mutex_lock(&p.mutex);
+				p.n_parsed++;
+				pthread_cond_broadcast(&p.cond);
+				pthread_mutex_unlock(&p.mutex);
+			}
+		}
+		if (in.f != stdin) {
+			fclose(in.f);
+		}
+		if (arg >= argc) {
+			break;
+		}
+	}
+	status = (res < 0) ? 1 : 0;
+
+	/* Signal the end of the input and wait for all threads to finish */
+	pthread_mutex_lock(&p.mutex);
+	p.eof = 1;
+	pthread_cond_broadcast(&p.cond);
+	pthread_mutex_unlock(&p.mutex);
+	for (i = 0U; i < n_started; i++) {
+		pthread_join(workers[i], NULL);
+	}
+	if (has_writer) {
+		pthread_join(writer, NULL);
+	}
+	t1 = now();
+	if (p.out_of_memory) {
+		fprintf(stderr, "Out of memory; some problems were not solved\n");
+		status = 1;
+	}
+
+	fprintf(stderr,
+	        "Solved %lu problems with %lu constraints in %.3f s using %u "
+	        "threads; %.1f problems/s, %.1f constraints/s\n",
+	        p.n_problems, p.n_constraints, t1 - t0, n_workers,
+	        (t1 > t0) ? (double)p.n_problems / (t1 - t0) : 0.0,
+	        (t1 > t0) ? (double)p.n_constraints / (t1 - t0) : 0.0);
+
+	for (i = 0U; i < p.n_slots; i++) {
+		free(p.slots[i].Gx);
+		free(p.slots[i].Gy);
+		free(p.slots[i].h);
+	}
+	free(p.slots);
+	free(p.solved);
+	free(workers);
+	free(in.line);
+	pthread_mutex_destroy(&p.mutex);
+	pthread_cond_destroy(&p.cond);
+	return status;
+}
@@ -0,0 +1,203 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tools/linprog2d_client.c
+ *
+ * Client library for the linprog2d solve daemon. See linprog2d_client.h for a
+ * description of the protocol.
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "linprog2d_client.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SU sizeof(unsigned int)
+#define SD sizeof(double)
+
+struct linprog2d_client {
+	int fd;
+	unsigned int next_id;
+	char *buf;
+	unsigned long int buf_size;
+};
+
+/**
+ * Reads exactly size bytes from fd. Returns zero on failure or end of file.
+ */
+static int read_full(int fd, void *buf, unsigned long int size) {
+	char *p = (char *)buf;
+	long int res;
+	while (size > 0UL) {
+		res = (long int)read(fd, p, size);
+		if (res < 0L && errno == EINTR) {
+			continue;
+		} else if (res <= 0L) {
+			return 0;
+		}
+		p += res, size -= (unsigned long int)res;
+	}
+	return 1;
+}
+
+/**
+ * Writes exactly size bytes to fd. Returns zero on failure.
+ */
+static int write_full(int fd, const void *buf, unsigned long int size) {
+	const char *p = (const char *)buf;
+	long int res;
+	while (size > 0UL) {
+		res = (long int)write(fd, p, size);
+		if (res < 0L && errno == EINTR) {
+			continue;
+		} else if (res <= 0L) {
+			return 0;
+		}
+		p += res, size -= (unsigned long int)res;
+	}
+	return 1;
+}
+
+/**
+ * Makes sure that the message buffer holds at least size bytes.
+ */
+static int client_reserve(linprog2d_client_t *c, unsigned long int size) {
+	char *buf;
+	if (size <= c->buf_size) {
+		return 1;
+	}
+	if (!(buf = (char *)realloc(c->buf, size))) {
+		return 0;
+	}
+	c->buf = buf;
+	c->buf_size = size;
+	return 1;
+}
+
+linprog2d_client_t *linprog2d_client_connect(const char *path) {
+	struct sockaddr_un addr;
+	linprog2d_client_t *c;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		return NULL;
+	}
+	if (!(c = (linprog2d_client_t *)calloc(1U, sizeof(linprog2d_client_t)))) {
+		return NULL;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	c->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (c->fd < 0 ||
+	    connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		linprog2d_client_close(c);
+		return NULL;
+	}
+	return c;
+}
+
+void linprog2d_client_close(linprog2d_client_t *c) {
+	if (c) {
+		if (c->fd >= 0) {
+			close(c->fd);
+		}
+		free(c->buf);
+		free(c);
+	}
+}
+
+int linprog2d_client_send(linprog2d_client_t *c,
+                          const linprog2d_problem_t *problems, unsigned int m,
+                          unsigned int *id) {
+	unsigned long int size = 3UL * SU, offs;
+	unsigned int i, head[3];
+	double grad[2];
+	for (i = 0U; i < m; i++) {
+		size += SU + SD * (2UL + 3UL * problems[i].n);
+	}
+	if (size - SU > LINPROG2D_MAX_MESSAGE || !client_reserve(c, size)) {
+		return 0;
+	}
+
+	/* Assemble the message in the buffer and send it with a single write */
+	head[0] = (unsigned int)(size - SU), head[1] = c->next_id, head[2] = m;
+	memcpy(c->buf, head, sizeof(head));
+	offs = sizeof(head);
+	for (i = 0U; i < m; i++) {
+		const linprog2d_problem_t *p = &problems[i];
+		grad[0] = p->cx, grad[1] = p->cy;
+		memcpy(c->buf + offs, &p->n, SU);
+		memcpy(c->buf + offs + SU, grad, 2U * SD);
+		offs += SU + 2U * SD;
+		memcpy(c->buf + offs, p->Gx, SD * p->n);
+		memcpy(c->buf + offs + SD * p->n, p->Gy, SD * p->n);
+		memcpy(c->buf + offs + 2UL * SD * p->n, p->h, SD * p->n);
+		offs += 3UL * SD * p->n;
+	}
+	if (!write_full(c->fd, c->buf, size)) {
+		return 0;
+	}
+	*id = c->next_id++;
+	return 1;
+}
+
+int linprog2d_client_recv(linprog2d_client_t *c, unsigned int *id,
+                          linprog2d_result_t *res, unsigned int max_m,
+                          unsigned int *m) {
+	unsigned int len, head[2], i, status;
+	double vals[4];
+	const char *p;
+	if (!read_full(c->fd, &len, SU) || len < 2U * SU ||
+	    len > LINPROG2D_MAX_MESSAGE || !client_reserve(c, len) ||
+	    !read_full(c->fd, c->buf, len)) {
+		return 0;
+	}
+	memcpy(head, c->buf, sizeof(head));
+	if ((unsigned long int)len != 2UL * SU + head[1] * (SU + 4UL * SD)) {
+		return 0;
+	}
+	*id = head[0];
+	p = c->buf + sizeof(head);
+	for (i = 0U; i < head[1] && i < max_m; i++) {
+		memcpy(&status, p, SU);
+		memcpy(vals, p + SU, 4U * SD);
+		res[i].status = (enum linprog2d_status)status;
+		res[i].x1 = vals[0], res[i].y1 = vals[1];
+		res[i].x2 = vals[2], res[i].y2 = vals[3];
+		p += SU + 4U * SD;
+	}
+	*m = head[1];
+	return 1;
+}
+
+int linprog2d_client_solve(linprog2d_client_t *c,
+                           const linprog2d_problem_t *problems, unsigned int m,
+                           linprog2d_result_t *res) {
+	unsigned int id_sent, id_recv, m_recv;
+	return linprog2d_client_send(c, problems, m, &id_sent) &&
+	       linprog2d_client_recv(c, &id_recv, res, m, &m_recv) &&
+	       id_sent == id_recv && m_recv == m;
+}
@@ -0,0 +1,98 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tools/linprog2d_client.h
+ *
+ * Client library for the linprog2d solve daemon (tools/linprog2d_daemon.c).
+ *
+ * The daemon listens on a Unix domain socket. All integers are unsigned int
+ * and all floating point values are double, in native byte order. Each
+ * message is prefixed with its length in bytes (excluding the length field).
+ *
+ * A request consists of a request id and the number of problems, followed by
+ * n, cx, cy, Gx[n], Gy[n], h[n] for each problem. A response consists of the
+ * request id and the number of problems, followed by the status and x1, y1,
+ * x2, y2 of each result. Requests may be pipelined; the responses to
+ * pipelined requests may arrive in any order and are matched by their id.
+ *
+ * @author Andreas Stöckel
+ */
+
+#ifndef LINPROG_2D_CLIENT_H_
+#define LINPROG_2D_CLIENT_H_
+
+#include <linprog2d.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Maximum size of a single message in bytes. The daemon closes connections
+ * that send larger messages.
+ */
+#define LINPROG2D_MAX_MESSAGE (256UL << 20)
+
+/**
+ * Opaque type representing a connection to the daemon.
+ */
+typedef struct linprog2d_client linprog2d_client_t;
+
+/**
+ * Connects to the daemon listening on the given socket path. Returns null on
+ * failure.
+ */
+linprog2d_client_t *linprog2d_client_connect(const char *path);
+
+/**
+ * Closes the connection and frees the client.
+ */
+void linprog2d_client_close(linprog2d_client_t *client);
+
+/**
+ * Sends a batch of m problems to the daemon without waiting for the results.
+ * The id of the request is written to id. Returns zero on failure.
+ */
+int linprog2d_client_send(linprog2d_client_t *client,
+                          const linprog2d_problem_t *problems, unsigned int m,
+                          unsigned int *id);
+
+/**
+ * Waits for the next response. Writes the request id to id, the number of
+ * results in the response to m, and up to max_m results to res. Returns zero
+ * on failure.
+ */
+int linprog2d_client_recv(linprog2d_client_t *client, unsigned int *id,
+                          linprog2d_result_t *res, unsigned int max_m,
+                          unsigned int *m);
+
+/**
+ * Solves a batch of m problems and writes the results to res. Must not be
+ * used while other requests on this connection are pending. Returns zero on
+ * failure.
+ */
+int linprog2d_client_solve(linprog2d_client_t *client,
+                           const linprog2d_problem_t *problems, unsigned int m,
+                           linprog2d_result_t *res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINPROG_2D_CLIENT_H_ */
@@ -0,0 +1,443 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tools/linprog2d_daemon.c
+ *
+ * Solve daemon listening on a Unix domain socket. See linprog2d_client.h for
+ * a description of the protocol.
+ *
+ * Usage: linprog2d-daemon [-s socket] [-j threads] [-c capacity]
+ *
+ * Each connection is served by a reader thread that reads complete requests
+ * and places them in a shared queue. A pool of worker threads, each owning a
+ * solver instance pre-grown to the given capacity, takes requests from the
+ * queue, solves them, and writes the response back to the connection. Thus,
+ * requests pipelined on a single connection are solved in parallel and their
+ * responses may be sent out of order. The number of requests in flight per
+ * connection is limited; once the limit is reached the reader thread stops
+ * reading from the socket until a response has been sent.
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "linprog2d_client.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SU sizeof(unsigned int)
+#define SD sizeof(double)
+
+/* Default socket path */
+#define DEFAULT_SOCKET "/tmp/linprog2d.sock"
+
+/* Default number of constraints the solver instances are pre-grown to */
+#define DEFAULT_CAPACITY 1024U
+
+/* Maximum number of requests in flight per connection */
+#define MAX_PENDING 64U
+
+/******************************************************************************
+ * Connections and jobs                                                       *
+ ******************************************************************************/
+
+/**
+ * A client connection. The connection is shared between its reader thread
+ * and the workers solving its requests; the socket is closed once the last
+ * reference is released.
+ */
+struct conn {
+	int fd;
+	unsigned int refs, pending;
+	pthread_mutex_t mutex, write_mutex;
+	pthread_cond_t cond;
+};
+
+/**
+ * A single request read from a connection.
+ */
+struct job {
+	struct conn *conn;
+	char *msg;
+	unsigned long int size;
+	struct job *next;
+};
+
+/**
+ * Queue of requests shared by all connections and workers.
+ */
+struct queue {
+	struct job *head, *tail;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+static struct queue queue;
+static unsigned int capacity = DEFAULT_CAPACITY;
+static volatile sig_atomic_t done = 0;
+
+/**
+ * Reads exactly size bytes from fd. Returns zero on failure or end of file.
+ */
+static int read_full(int fd, void *buf, unsigned long int size) {
+	char *p = (char *)buf;
+	long int res;
+	while (size > 0UL) {
+		res = (long int)read(fd, p, size);
+		if (res < 0L && errno == EINTR) {
+			continue;
+		} else if (res <= 0L) {
+			return 0;
+		}
+		p += res, size -= (unsigned long int)res;
+	}
+	return 1;
+}
+
+/**
+ * Writes exactly size bytes to fd. Returns zero on failure.
+ */
+static int write_full(int fd, const void *buf, unsigned long int size) {
+	const char *p = (const char *)buf;
+	long int res;
+	while (size > 0UL) {
+		res = (long int)write(fd, p, size);
+		if (res < 0L && errno == EINTR) {
+			continue;
+		} else if (res <= 0L) {
+			return 0;
+		}
+		p += res, size -= (unsigned long int)res;
+	}
+	return 1;
+}
+
+/**
+ * Drops a reference to the connection; closes and frees the connection once
+ * the last reference is gone.
+ */
+static void conn_release(struct conn *c) {
+	unsigned int refs;
+	pthread_mutex_lock(&c->mutex);
+	refs = --c->refs;
+	pthread_mutex_unlock(&c->mutex);
+	if (refs == 0U) {
+		close(c->fd);
+		pthread_mutex_destroy(&c->mutex);
+		pthread_mutex_destroy(&c->write_mutex);
+		pthread_cond_destroy(&c->cond);
+		free(c);
+	}
+}
+
+/**
+ * Marks a request of the connection as answered and wakes up the reader
+ * thread if it is waiting for a free slot.
+ */
+static void conn_finish(struct conn *c) {
+	pthread_mutex_lock(&c->mutex);
+	c->pending--;
+	pthread_cond_signal(&c->cond);
+	pthread_mutex_unlock(&c->mutex);
+	conn_release(c);
+}
+
+/**
+ * Reads requests from the connection and places them in the queue until the
+ * client hangs up or sends a malformed message.
+ */
+static void *reader_main(void *arg) {
+	struct conn *c = (struct conn *)arg;
+	struct job *job;
+	unsigned int len;
+	char *msg;
+
+	while (read_full(c->fd, &len, SU)) {
+		if (len < 2U * SU || len > LINPROG2D_MAX_MESSAGE ||
+		    !(msg = (char *)malloc(len))) {
+			break;
+		}
+		if (!read_full(c->fd, msg, len) ||
+		    !(job = (struct job *)malloc(sizeof(struct job)))) {
+			free(msg);
+			break;
+		}
+		job->conn = c, job->msg = msg, job->size = len, job->next = NULL;
+
+		/* Wait for a free slot, then take a reference for the job */
+		pthread_mutex_lock(&c->mutex);
+		while (c->pending >= MAX_PENDING) {
+			pthread_cond_wait(&c->cond, &c->mutex);
+		}
+		c->pending++, c->refs++;
+		pthread_mutex_unlock(&c->mutex);
+
+		pthread_mutex_lock(&queue.mutex);
+		if (queue.tail) {
+			queue.tail->next = job;
+		} else {
+			queue.head = job;
+		}
+		queue.tail = job;
+		pthread_cond_signal(&queue.cond);
+		pthread_mutex_unlock(&queue.mutex);
+	}
+
+	/* Unblock workers still writing responses to a client that is gone */
+	shutdown(c->fd, SHUT_RD);
+	conn_release(c);
+	return NULL;
+}
+
+/******************************************************************************
+ * Workers                                                                    *
+ ******************************************************************************/
+
+/**
+ * Per-worker state. The solver and the constraint arrays only ever grow.
+ */
+struct worker {
+	linprog2d_t *prog;
+	double *Gx, *Gy, *h;
+	unsigned int n;
+	char *out;
+	unsigned long int out_size;
+};
+
+static int worker_reserve(struct worker *w, unsigned int n) {
+	if (n <= w->n) {
+		return 1;
+	}
+	linprog2d_free(w->prog);
+	free(w->Gx);
+	free(w->Gy);
+	free(w->h);
+	w->n = n;
+	w->prog = linprog2d_create(n);
+	w->Gx = (double *)malloc(SD * n);
+	w->Gy = (double *)malloc(SD * n);
+	w->h = (double *)malloc(SD * n);
+	if (!w->prog || !w->Gx || !w->Gy || !w->h) {
+		w->n = 0U;
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * Solves all problems in the request and assembles the response in the
+ * output buffer. Returns the size of the response, or zero if the request is
+ * malformed.
+ */
+static unsigned long int worker_solve(struct worker *w, const char *msg,
+                                      unsigned long int size) {
+	unsigned int head[3], i, n, status;
+	unsigned long int offs = 2UL * SU, len;
+	double grad[2], vals[4];
+	linprog2d_result_t res;
+	char *out;
+
+	/* Each problem takes at least SU + 2 * SD bytes in the request */
+	memcpy(head + 1, msg, 2U * SU);
+	if (head[2] > (size - 2UL * SU) / (SU + 2UL * SD)) {
+		return 0UL;
+	}
+	len = 2UL * SU + head[2] * (SU + 4UL * SD);
+	if (len + SU > w->out_size) {
+		if (!(out = (char *)realloc(w->out, len + SU))) {
+			return 0UL;
+		}
+		w->out = out;
+		w->out_size = len + SU;
+	}
+	head[0] = (unsigned int)len;
+	memcpy(w->out, head, sizeof(head));
+	out = w->out + sizeof(head);
+
+	for (i = 0U; i < head[2]; i++) {
+		/* Copy the problem into aligned arrays */
+		if (size - offs < SU + 2UL * SD) {
+			return 0UL;
+		}
+		memcpy(&n, msg + offs, SU);
+		memcpy(grad, msg + offs + SU, 2U * SD);
+		offs += SU + 2UL * SD;
+		if ((size - offs) / (3UL * SD) < n || !worker_reserve(w, n)) {
+			return 0UL;
+		}
+		memcpy(w->Gx, msg + offs, SD * n);
+		memcpy(w->Gy, msg + offs + SD * n, SD * n);
+		memcpy(w->h, msg + offs + 2UL * SD * n, SD * n);
+		offs += 3UL * SD * n;
+
+		res = linprog2d_solve(w->prog, grad[0], grad[1], w->Gx, w->Gy, w->h,
+		                      n);
+		status = (unsigned int)res.status;
+		vals[0] = res.x1, vals[1] = res.y1, vals[2] = res.x2, vals[3] = res.y2;
+		memcpy(out, &status, SU);
+		memcpy(out + SU, vals, 4U * SD);
+		out += SU + 4U * SD;
+	}
+	return (offs == size) ? len + SU : 0UL;
+}
+
+static void *worker_main(void *arg) {
+	struct worker w;
+	struct job *job;
+	unsigned long int len;
+	(void)arg;
+
+	memset(&w, 0, sizeof(w));
+	if (!worker_reserve(&w, capacity)) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+
+	while (1) {
+		pthread_mutex_lock(&queue.mutex);
+		while (!queue.head) {
+			pthread_cond_wait(&queue.cond, &queue.mutex);
+		}
+		job = queue.head;
+		if (!(queue.head = job->next)) {
+			queue.tail = NULL;
+		}
+		pthread_mutex_unlock(&queue.mutex);
+
+		/* Answer the request; drop the connection if anything goes wrong */
+		if ((len = worker_solve(&w, job->msg, job->size))) {
+			pthread_mutex_lock(&job->conn->write_mutex);
+			if (!write_full(job->conn->fd, w.out, len)) {
+				len = 0UL;
+			}
+			pthread_mutex_unlock(&job->conn->write_mutex);
+		}
+		if (!len) {
+			shutdown(job->conn->fd, SHUT_RDWR);
+		}
+
+		conn_finish(job->conn);
+		free(job->msg);
+		free(job);
+	}
+	return NULL;
+}
+
+/******************************************************************************
+ * Main program                                                               *
+ ******************************************************************************/
+
+static void handle_signal(int sig) {
+	(void)sig;
+	done = 1;
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-s socket] [-j threads] [-c capacity]\n",
+	        name);
+}
+
+int main(int argc, char *argv[]) {
+	const char *path = DEFAULT_SOCKET;
+	unsigned int i, n_workers = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	struct sockaddr_un addr;
+	struct sigaction sa;
+	struct conn *c;
+	pthread_attr_t attr;
+	pthread_t thread;
+	int opt, fd, cfd;
+
+	while ((opt = getopt(argc, argv, "s:j:c:")) != -1) {
+		if (opt == 's') {
+			path = optarg;
+		} else if (opt == 'j' && atoi(optarg) > 0) {
+			n_workers = (unsigned int)atoi(optarg);
+		} else if (opt == 'c' && atoi(optarg) > 0) {
+			capacity = (unsigned int)atoi(optarg);
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind != argc || strlen(path) >= sizeof(addr.sun_path)) {
+		usage(argv[0]);
+		return 1;
+	}
+	n_workers = (n_workers > 0U) ? n_workers : 1U;
+
+	/* Stop on SIGINT/SIGTERM; report failed writes instead of dying */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = handle_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sa.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &sa, NULL);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+	    bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+	    listen(fd, 64) != 0) {
+		perror(path);
+		return 1;
+	}
+
+	pthread_mutex_init(&queue.mutex, NULL);
+	pthread_cond_init(&queue.cond, NULL);
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	for (i = 0U; i < n_workers; i++) {
+		pthread_create(&thread, &attr, worker_main, NULL);
+	}
+	fprintf(stderr, "Listening on %s with %u workers\n", path, n_workers);
+
+	while (!done) {
+		if ((cfd = accept(fd, NULL, NULL)) < 0) {
+			continue;
+		}
+		if (!(c = (struct conn *)calloc(1U, sizeof(struct conn)))) {
+			close(cfd);
+			continue;
+		}
+		c->fd = cfd, c->refs = 1U;
+		pthread_mutex_init(&c->mutex, NULL);
+		pthread_mutex_init(&c->write_mutex, NULL);
+		pthread_cond_init(&c->cond, NULL);
+		if (pthread_create(&thread, &attr, reader_main, c) != 0) {
+			conn_release(c);
+		}
+	}
+
+	/* Worker and reader threads end with the process */
+	close(fd);
+	unlink(path);
+	pthread_attr_destroy(&attr);
+	return 0;
+}
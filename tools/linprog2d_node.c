@@ -0,0 +1,624 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tools/linprog2d_node.c
+ *
+ * Native Node.js addon (Node-API) exposing the same interface as the
+ * JavaScript/WebAssembly library: init(), solve(), and solve_batch(), plus
+ * solve_batch_async(), which solves a batch on the libuv thread pool and
+ * returns a promise. Float64Array and Uint32Array arguments are read in place;
+ * plain arrays are copied. linprog2d.js loads this addon instead of the
+ * WebAssembly module if build/linprog2d.node is found next to it.
+ *
+ * Batches are solved with an interleaved linprog2d_batch instance. The async
+ * variant splits the batch into chunks of roughly equal numbers of
+ * constraints, one per thread pool thread, and keeps the input arrays alive
+ * until all chunks have completed; the arrays must not be modified or
+ * transferred in the meantime.
+ *
+ * @author Andreas Stöckel
+ */
+
+#include <linprog2d.h>
+
+#include <node_api.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of chunks solve_batch_async() splits a batch into if the size of
+   the thread pool is not set through UV_THREADPOOL_SIZE */
+#define DEFAULT_CHUNKS 4U
+
+/* Throws and returns null if a Node-API call fails */
+#define CALL(call)                              \
+	do {                                        \
+		if ((call) != napi_ok) {                \
+			throw_string(env, "Node-API error"); \
+			return NULL;                        \
+		}                                       \
+	} while (0)
+
+/**
+ * Throws the given message as a string, like the JavaScript wrapper does.
+ */
+static void throw_string(napi_env env, const char *msg) {
+	napi_value value;
+	if (napi_create_string_utf8(env, msg, NAPI_AUTO_LENGTH, &value) == napi_ok) {
+		napi_throw(env, value);
+	}
+}
+
+/******************************************************************************
+ * Arguments                                                                  *
+ ******************************************************************************/
+
+/**
+ * An array argument. Points at the contents of a typed array of the expected
+ * type, or at a copy of a plain array, in which case owned is set.
+ */
+struct array_arg {
+	void *data;
+	size_t len;
+	int owned;
+};
+
+static void array_arg_free(struct array_arg *a) {
+	if (a->owned) {
+		free(a->data);
+	}
+	a->data = NULL, a->len = 0U, a->owned = 0;
+}
+
+/**
+ * Reads an array of doubles (type napi_float64_array) or unsigned integers
+ * (napi_uint32_array). Returns zero and throws if the value is neither a
+ * typed array of that type nor a plain array.
+ */
+static int get_array(napi_env env, napi_value value, napi_typedarray_type type,
+                     struct array_arg *a) {
+	napi_typedarray_type actual;
+	napi_value ab, elem;
+	size_t offs, i;
+	uint32_t len;
+	bool is_typed, is_array;
+	double d;
+	a->data = NULL, a->len = 0U, a->owned = 0;
+	if (napi_is_typedarray(env, value, &is_typed) != napi_ok ||
+	    napi_is_array(env, value, &is_array) != napi_ok) {
+		return 0;
+	}
+	if (is_typed) {
+		if (napi_get_typedarray_info(env, value, &actual, &a->len, &a->data,
+		                             &ab, &offs) == napi_ok &&
+		    actual == type) {
+			return 1;
+		}
+	} else if (is_array && napi_get_array_length(env, value, &len) == napi_ok) {
+		a->len = len, a->owned = 1;
+		a->data = malloc((type == napi_float64_array ? sizeof(double)
+		                                             : sizeof(uint32_t)) *
+		                 (len ? len : 1U));
+		for (i = 0U; a->data && i < len; i++) {
+			if (napi_get_element(env, value, (uint32_t)i, &elem) != napi_ok ||
+			    napi_get_value_double(env, elem, &d) != napi_ok) {
+				break;
+			}
+			if (type == napi_float64_array) {
+				((double *)a->data)[i] = d;
+			} else {
+				((uint32_t *)a->data)[i] = (uint32_t)d;
+			}
+		}
+		if (a->data && i == len) {
+			return 1;
+		}
+		array_arg_free(a);
+	}
+	throw_string(env, "Invalid input");
+	return 0;
+}
+
+/******************************************************************************
+ * Addon state                                                                *
+ ******************************************************************************/
+
+/**
+ * Solver instances used by the synchronous functions; grown on demand.
+ */
+struct addon {
+	napi_ref solve; /* Function returned by init() */
+	linprog2d_t *prog;
+	linprog2d_batch_t *batch;
+	unsigned int batch_capacity;
+};
+
+static void addon_free(napi_env env, void *data, void *hint) {
+	struct addon *addon = (struct addon *)data;
+	(void)hint;
+	if (addon->solve) {
+		napi_delete_reference(env, addon->solve);
+	}
+	linprog2d_free(addon->prog);
+	linprog2d_batch_free(addon->batch);
+	free(addon);
+}
+
+static struct addon *addon_get(napi_env env) {
+	void *data = NULL;
+	napi_get_instance_data(env, &data);
+	return (struct addon *)data;
+}
+
+/**
+ * Makes sure the solver instance can hold a problem with n constraints.
+ * Grows the capacity geometrically.
+ */
+static int addon_reserve(struct addon *addon, unsigned int n) {
+	const unsigned int capacity = addon->prog ? linprog2d_capacity(addon->prog)
+	                                          : 0U;
+	if (!addon->prog || capacity < n) {
+		n = (n > 2U * capacity) ? n : 2U * capacity;
+		linprog2d_free(addon->prog);
+		addon->prog = linprog2d_create(n > 64U ? n : 64U);
+	}
+	return addon->prog != NULL;
+}
+
+/**
+ * Makes sure the batch instance can solve problems with n constraints.
+ */
+static int addon_reserve_batch(struct addon *addon, unsigned int n) {
+	if (!addon->batch || addon->batch_capacity < n) {
+		n = (n > 2U * addon->batch_capacity) ? n : 2U * addon->batch_capacity;
+		n = (n > 64U) ? n : 64U;
+		linprog2d_batch_free(addon->batch);
+		addon->batch = linprog2d_batch_create(n);
+		addon->batch_capacity = addon->batch ? n : 0U;
+	}
+	return addon->batch != NULL;
+}
+
+/******************************************************************************
+ * Batches                                                                    *
+ ******************************************************************************/
+
+/**
+ * A batch of problems described by the arguments of solve_batch().
+ */
+struct batch {
+	struct array_arg c, n, Gx, Gy, h;
+	linprog2d_problem_t *problems;
+	linprog2d_result_t *res;
+	unsigned int m, max_n;
+};
+
+static void batch_free(struct batch *b) {
+	array_arg_free(&b->c);
+	array_arg_free(&b->n);
+	array_arg_free(&b->Gx);
+	array_arg_free(&b->Gy);
+	array_arg_free(&b->h);
+	free(b->problems);
+	free(b->res);
+	b->problems = NULL, b->res = NULL;
+}
+
+/**
+ * Reads the arguments c, n, Gx, Gy, h and fills in the problem descriptors.
+ * Returns zero and throws if the arguments are invalid.
+ */
+static int batch_prepare(napi_env env, napi_value *argv, struct batch *b) {
+	const uint32_t *n;
+	size_t i, offs = 0U;
+	memset(b, 0, sizeof(struct batch));
+	if (!get_array(env, argv[0], napi_float64_array, &b->c) ||
+	    !get_array(env, argv[1], napi_uint32_array, &b->n) ||
+	    !get_array(env, argv[2], napi_float64_array, &b->Gx) ||
+	    !get_array(env, argv[3], napi_float64_array, &b->Gy) ||
+	    !get_array(env, argv[4], napi_float64_array, &b->h)) {
+		batch_free(b);
+		return 0;
+	}
+	b->m = (unsigned int)b->n.len;
+	b->problems = (linprog2d_problem_t *)malloc(sizeof(linprog2d_problem_t) *
+	                                            (b->m ? b->m : 1U));
+	b->res = (linprog2d_result_t *)malloc(sizeof(linprog2d_result_t) *
+	                                      (b->m ? b->m : 1U));
+	if (b->c.len != 2U * b->m || b->Gy.len != b->Gx.len ||
+	    b->h.len != b->Gx.len || !b->problems || !b->res) {
+		throw_string(env, "Invalid input");
+		batch_free(b);
+		return 0;
+	}
+	n = (const uint32_t *)b->n.data;
+	for (i = 0U; i < b->m; i++) {
+		linprog2d_problem_t *p = &b->problems[i];
+		if (n[i] > b->Gx.len - offs) {
+			throw_string(env, "Invalid input");
+			batch_free(b);
+			return 0;
+		}
+		p->cx = ((const double *)b->c.data)[2U * i];
+		p->cy = ((const double *)b->c.data)[2U * i + 1U];
+		p->Gx = (const double *)b->Gx.data + offs;
+		p->Gy = (const double *)b->Gy.data + offs;
+		p->h = (const double *)b->h.data + offs;
+		p->n = n[i];
+		b->max_n = (n[i] > b->max_n) ? n[i] : b->max_n;
+		offs += n[i];
+	}
+	return 1;
+}
+
+/**
+ * Writes the results as (x1, y1, x2, y2, status) records to out, which is
+ * either a Float64Array or a plain array, or to a new Float64Array if out is
+ * null.
+ */
+static napi_value batch_results(napi_env env, const struct batch *b,
+                                napi_value out) {
+	napi_typedarray_type type;
+	napi_value ab, val;
+	double *rec = NULL;
+	size_t len = 0U, offs;
+	unsigned int i, j;
+	bool is_typed = false, is_array = false;
+	if (out) {
+		CALL(napi_is_typedarray(env, out, &is_typed));
+		CALL(napi_is_array(env, out, &is_array));
+		if (is_typed) {
+			CALL(napi_get_typedarray_info(env, out, &type, &len,
+			                              (void **)&rec, &ab, &offs));
+		}
+		if ((is_typed && (type != napi_float64_array || len < 5U * b->m)) ||
+		    (!is_typed && !is_array)) {
+			throw_string(env, "Invalid input");
+			return NULL;
+		}
+	} else {
+		CALL(napi_create_arraybuffer(env, sizeof(double) * 5U * b->m,
+		                             (void **)&rec, &ab));
+		CALL(napi_create_typedarray(env, napi_float64_array, 5U * b->m, ab,
+		                            0U, &out));
+	}
+	for (i = 0U; rec && i < b->m; i++) {
+		rec[5U * i + 0U] = b->res[i].x1;
+		rec[5U * i + 1U] = b->res[i].y1;
+		rec[5U * i + 2U] = b->res[i].x2;
+		rec[5U * i + 3U] = b->res[i].y2;
+		rec[5U * i + 4U] = (double)b->res[i].status;
+	}
+	for (i = 0U; !rec && i < b->m; i++) {
+		const double r[5] = {b->res[i].x1, b->res[i].y1, b->res[i].x2,
+		                     b->res[i].y2, (double)b->res[i].status};
+		for (j = 0U; j < 5U; j++) {
+			CALL(napi_create_double(env, r[j], &val));
+			CALL(napi_set_element(env, out, 5U * i + j, val));
+		}
+	}
+	return out;
+}
+
+/******************************************************************************
+ * Asynchronous batches                                                       *
+ ******************************************************************************/
+
+/**
+ * A range of problems of an asynchronous batch solved by one work item.
+ */
+struct async_chunk {
+	struct async_batch *ab;
+	napi_async_work work;
+	unsigned int i0, i1;
+	int ok;
+};
+
+/**
+ * A batch solved on the thread pool, split into chunks.
+ */
+struct async_batch {
+	struct batch b;
+	napi_ref refs[5];
+	napi_deferred deferred;
+	struct async_chunk *chunks;
+	unsigned int n_chunks, n_pending;
+	int failed;
+};
+
+static void async_free(napi_env env, struct async_batch *ab) {
+	unsigned int i;
+	for (i = 0U; i < 5U; i++) {
+		if (ab->refs[i]) {
+			napi_delete_reference(env, ab->refs[i]);
+		}
+	}
+	batch_free(&ab->b);
+	free(ab->chunks);
+	free(ab);
+}
+
+static void async_execute(napi_env env, void *data) {
+	struct async_chunk *chunk = (struct async_chunk *)data;
+	const struct batch *b = &chunk->ab->b;
+	linprog2d_batch_t *batch;
+	(void)env;
+	if (chunk->i0 == chunk->i1) {
+		chunk->ok = 1;
+	} else if ((batch = linprog2d_batch_create(b->max_n))) {
+		linprog2d_batch_solve(batch, b->problems + chunk->i0,
+		                      b->res + chunk->i0, chunk->i1 - chunk->i0);
+		linprog2d_batch_free(batch);
+		chunk->ok = 1;
+	}
+}
+
+static void async_complete(napi_env env, napi_status status, void *data) {
+	struct async_chunk *chunk = (struct async_chunk *)data;
+	struct async_batch *ab = chunk->ab;
+	napi_value res = NULL, err;
+
+	ab->failed = ab->failed || status != napi_ok || !chunk->ok;
+	napi_delete_async_work(env, chunk->work);
+	if (--ab->n_pending > 0U) {
+		return;
+	}
+
+	/* All chunks have completed; settle the promise */
+	if (!ab->failed) {
+		res = batch_results(env, &ab->b, NULL);
+	}
+	if (res) {
+		napi_resolve_deferred(env, ab->deferred, res);
+	} else {
+		napi_create_string_utf8(env, "Out of memory", NAPI_AUTO_LENGTH, &err);
+		napi_reject_deferred(env, ab->deferred, err);
+	}
+	async_free(env, ab);
+}
+
+/**
+ * Returns the number of chunks a batch is split into, i.e. the number of
+ * threads in the libuv thread pool.
+ */
+static unsigned int async_n_chunks(void) {
+	const char *s = getenv("UV_THREADPOOL_SIZE");
+	const int n = s ? atoi(s) : 0;
+	return (n > 0) ? (unsigned int)n : DEFAULT_CHUNKS;
+}
+
+/******************************************************************************
+ * Exported functions                                                         *
+ ******************************************************************************/
+
+static napi_value js_init(napi_env env, napi_callback_info info) {
+	napi_deferred deferred;
+	napi_value promise, solve;
+	(void)info;
+	CALL(napi_create_promise(env, &deferred, &promise));
+	CALL(napi_get_reference_value(env, addon_get(env)->solve, &solve));
+	CALL(napi_resolve_deferred(env, deferred, solve));
+	return promise;
+}
+
+static napi_value js_solve(napi_env env, napi_callback_info info) {
+	struct addon *addon = addon_get(env);
+	struct array_arg Gx, Gy, h;
+	linprog2d_result_t res;
+	napi_value argv[5], obj, val;
+	size_t argc = 5U;
+	double cx, cy;
+	int ok;
+
+	CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+	if (argc < 5U || napi_get_value_double(env, argv[0], &cx) != napi_ok ||
+	    napi_get_value_double(env, argv[1], &cy) != napi_ok) {
+		throw_string(env, "Invalid input");
+		return NULL;
+	}
+	if (!get_array(env, argv[2], napi_float64_array, &Gx)) {
+		return NULL;
+	}
+	if (!get_array(env, argv[3], napi_float64_array, &Gy)) {
+		array_arg_free(&Gx);
+		return NULL;
+	}
+	if (!get_array(env, argv[4], napi_float64_array, &h)) {
+		array_arg_free(&Gx);
+		array_arg_free(&Gy);
+		return NULL;
+	}
+	ok = Gx.len == Gy.len && Gy.len == h.len;
+	if (!ok) {
+		throw_string(env, "Invalid input");
+	} else if (!(ok = addon_reserve(addon, (unsigned int)Gx.len))) {
+		throw_string(env, "Out of memory");
+	} else {
+		res = linprog2d_solve(addon->prog, cx, cy, (const double *)Gx.data,
+		                      (const double *)Gy.data, (const double *)h.data,
+		                      (unsigned int)Gx.len);
+	}
+	array_arg_free(&Gx);
+	array_arg_free(&Gy);
+	array_arg_free(&h);
+	if (!ok) {
+		return NULL;
+	}
+
+	CALL(napi_create_object(env, &obj));
+	CALL(napi_create_double(env, res.x1, &val));
+	CALL(napi_set_named_property(env, obj, "x1", val));
+	CALL(napi_create_double(env, res.y1, &val));
+	CALL(napi_set_named_property(env, obj, "y1", val));
+	CALL(napi_create_double(env, res.x2, &val));
+	CALL(napi_set_named_property(env, obj, "x2", val));
+	CALL(napi_create_double(env, res.y2, &val));
+	CALL(napi_set_named_property(env, obj, "y2", val));
+	CALL(napi_create_uint32(env, (uint32_t)res.status, &val));
+	CALL(napi_set_named_property(env, obj, "status", val));
+	return obj;
+}
+
+static napi_value js_solve_batch(napi_env env, napi_callback_info info) {
+	struct addon *addon = addon_get(env);
+	struct batch b;
+	napi_value argv[6], res = NULL;
+	napi_valuetype out_type = napi_undefined;
+	size_t argc = 6U;
+
+	CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+	if (argc < 5U) {
+		throw_string(env, "Invalid input");
+		return NULL;
+	}
+	if (argc > 5U) {
+		CALL(napi_typeof(env, argv[5], &out_type));
+	}
+	if (!batch_prepare(env, argv, &b)) {
+		return NULL;
+	}
+	if (!addon_reserve_batch(addon, b.max_n)) {
+		throw_string(env, "Out of memory");
+	} else {
+		linprog2d_batch_solve(addon->batch, b.problems, b.res, b.m);
+		res = batch_results(env, &b,
+		                    (out_type == napi_undefined || out_type == napi_null)
+		                        ? NULL
+		                        : argv[5]);
+	}
+	batch_free(&b);
+	return res;
+}
+
+static napi_value js_solve_batch_async(napi_env env, napi_callback_info info) {
+	struct async_batch *ab;
+	struct async_chunk *chunk;
+	napi_value argv[5], promise, name;
+	size_t argc = 5U, offs, target;
+	unsigned int i, i0, k, n_chunks;
+
+	CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+	if (argc < 5U) {
+		throw_string(env, "Invalid input");
+		return NULL;
+	}
+	if (!(ab = (struct async_batch *)calloc(1U, sizeof(struct async_batch)))) {
+		throw_string(env, "Out of memory");
+		return NULL;
+	}
+	if (!batch_prepare(env, argv, &ab->b)) {
+		free(ab);
+		return NULL;
+	}
+
+	/* Split the batch into chunks of roughly equal numbers of constraints;
+	   there is at least one (possibly empty) chunk, which settles the
+	   promise */
+	n_chunks = async_n_chunks();
+	if (!(ab->chunks = (struct async_chunk *)calloc(
+	          n_chunks, sizeof(struct async_chunk)))) {
+		throw_string(env, "Out of memory");
+		async_free(env, ab);
+		return NULL;
+	}
+	target = ab->b.Gx.len / n_chunks + 1U;
+	for (i = 0U, i0 = 0U, k = 0U, offs = 0U; i < ab->b.m; i++) {
+		offs += ab->b.problems[i].n;
+		if (offs >= target * (k + 1U) && k + 1U < n_chunks) {
+			ab->chunks[k].i0 = i0, ab->chunks[k].i1 = i + 1U;
+			i0 = i + 1U, k++;
+		}
+	}
+	if (i0 < ab->b.m || k == 0U) {
+		ab->chunks[k].i0 = i0, ab->chunks[k].i1 = ab->b.m;
+		k++;
+	}
+	ab->n_chunks = k;
+
+	/* Keep the input arrays alive while the chunks are solved */
+	for (i = 0U; i < 5U; i++) {
+		if (napi_create_reference(env, argv[i], 1U, &ab->refs[i]) != napi_ok) {
+			throw_string(env, "Node-API error");
+			async_free(env, ab);
+			return NULL;
+		}
+	}
+	CALL(napi_create_string_utf8(env, "linprog2d_solve_batch",
+	                             NAPI_AUTO_LENGTH, &name));
+	for (i = 0U; i < k; i++) {
+		chunk = &ab->chunks[i];
+		chunk->ab = ab;
+		if (napi_create_async_work(env, NULL, name, async_execute,
+		                           async_complete, chunk,
+		                           &chunk->work) != napi_ok) {
+			while (i-- > 0U) {
+				napi_delete_async_work(env, ab->chunks[i].work);
+			}
+			throw_string(env, "Node-API error");
+			async_free(env, ab);
+			return NULL;
+		}
+	}
+
+	/* Queue the chunks; the batch is freed once the last one completes */
+	CALL(napi_create_promise(env, &ab->deferred, &promise));
+	ab->n_pending = k;
+	for (i = 0U; i < k; i++) {
+		napi_queue_async_work(env, ab->chunks[i].work);
+	}
+	return promise;
+}
+
+/******************************************************************************
+ * Module initialisation                                                      *
+ ******************************************************************************/
+
+static napi_value addon_init(napi_env env, napi_value exports) {
+	static const char *status_names[5] = {"ERROR", "INFEASIBLE", "UNBOUNDED",
+	                                      "EDGE", "POINT"};
+	struct addon *addon;
+	napi_value fn, val;
+	unsigned int i;
+
+	if (!(addon = (struct addon *)calloc(1U, sizeof(struct addon)))) {
+		throw_string(env, "Out of memory");
+		return NULL;
+	}
+	CALL(napi_set_instance_data(env, addon, addon_free, NULL));
+
+	CALL(napi_create_function(env, "solve", NAPI_AUTO_LENGTH, js_solve, NULL,
+	                          &fn));
+	CALL(napi_set_named_property(env, exports, "solve", fn));
+	CALL(napi_create_reference(env, fn, 1U, &addon->solve));
+	CALL(napi_create_function(env, "init", NAPI_AUTO_LENGTH, js_init, NULL,
+	                          &fn));
+	CALL(napi_set_named_property(env, exports, "init", fn));
+	CALL(napi_create_function(env, "solve_batch", NAPI_AUTO_LENGTH,
+	                          js_solve_batch, NULL, &fn));
+	CALL(napi_set_named_property(env, exports, "solve_batch", fn));
+	CALL(napi_create_function(env, "solve_batch_async", NAPI_AUTO_LENGTH,
+	                          js_solve_batch_async, NULL, &fn));
+	CALL(napi_set_named_property(env, exports, "solve_batch_async", fn));
+	for (i = 0U; i < 5U; i++) {
+		CALL(napi_create_uint32(env, i, &val));
+		CALL(napi_set_named_property(env, exports, status_names[i], val));
+	}
+	return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, addon_init)
@@ -0,0 +1,312 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tools/linprog2d_pool.js
+ *
+ * Pool of Node.js worker threads solving batches of problems in parallel.
+ * The WebAssembly module is compiled once on the main thread and instantiated
+ * in every worker. The problems and the results of a batch are stored in
+ * SharedArrayBuffers visible to all workers; a batch is split into chunks of
+ * roughly equal numbers of constraints, which are handed out to the workers
+ * as they become idle. Each worker copies its chunks into its own WebAssembly
+ * memory and solves them with a single call to solve_batch(). Errors thrown
+ * in a worker are passed back and reject the batch; a worker that exits is
+ * replaced by a new one, and the batch it was working on is rejected.
+ *
+ * Usage:
+ *
+ *     const pool = await require('./tools/linprog2d_pool.js').create();
+ *     const res = await pool.solveBatch(c, n, Gx, Gy, h);
+ *     pool.close();
+ *
+ * where the arguments and the result are as for linprog2d.solve_batch().
+ *
+ * @author Andreas Stöckel
+ */
+
+'use strict';
+
+const os = require('os');
+const path = require('path');
+const wt = require('worker_threads');
+
+/* Number of chunks per worker a batch is split into; more chunks balance the
+   load better at the cost of more messages */
+const CHUNKS_PER_WORKER = 4;
+
+/* Wrapper script loaded by default */
+const DEFAULT_SCRIPT = path.join(__dirname, '..', 'build', 'linprog2d.sidecar.js');
+
+/******************************************************************************
+ * Worker                                                                     *
+ ******************************************************************************/
+
+/* Each message from a worker is null on success or an error description */
+function worker_main() {
+	const lp = require(wt.workerData.script).linprog2d;
+	lp.init(wt.workerData.module).then(() => {
+		wt.parentPort.on('message', (msg) => {
+			const i0 = msg.i0, i1 = msg.i1, o0 = msg.o0, o1 = msg.o1;
+			const b = msg.buffers;
+			try {
+				lp.solve_batch(
+					new Float64Array(b.c, 16 * i0, 2 * (i1 - i0)),
+					new Uint32Array(b.n, 4 * i0, i1 - i0),
+					new Float64Array(b.Gx, 8 * o0, o1 - o0),
+					new Float64Array(b.Gy, 8 * o0, o1 - o0),
+					new Float64Array(b.h, 8 * o0, o1 - o0),
+					new Float64Array(b.out, 40 * i0, 5 * (i1 - i0)));
+			} catch (e) {
+				wt.parentPort.postMessage(String(e));
+				return;
+			}
+			wt.parentPort.postMessage(null);
+		});
+		wt.parentPort.postMessage(null); /* Ready */
+	}).catch(e => wt.parentPort.postMessage(String(e)));
+}
+
+/******************************************************************************
+ * Main thread                                                                *
+ ******************************************************************************/
+
+/**
+ * Returns a typed array of the given type and length backed by a
+ * SharedArrayBuffer, reusing arr if it is large enough.
+ */
+function shared(type, arr, len) {
+	if (arr && arr.length >= len) {
+		return arr;
+	}
+	return new type(new SharedArrayBuffer(type.BYTES_PER_ELEMENT * Math.max(len, 1)));
+}
+
+/**
+ * Returns src if it is backed by a SharedArrayBuffer and starts at its
+ * beginning, otherwise copies it into the shared array stored under the given
+ * key in own, which is reused across batches.
+ */
+function as_shared(type, src, own, key) {
+	if (src instanceof type && src.buffer instanceof SharedArrayBuffer &&
+	    src.byteOffset == 0) {
+		return src;
+	}
+	own[key] = shared(type, own[key], src.length);
+	own[key].set(src);
+	return own[key];
+}
+
+/**
+ * Splits the m problems with the given constraint counts into chunks of
+ * roughly target constraints. Returns a list of [i0, i1, o0, o1] ranges of
+ * problem and constraint indices.
+ */
+function split(n, m, target) {
+	const chunks = [];
+	let i0 = 0, o0 = 0, o = 0;
+	for (let i = 0; i < m; i++) {
+		o += n[i];
+		if (o - o0 >= target || i + 1 == m) {
+			chunks.push([i0, i + 1, o0, o]);
+			i0 = i + 1, o0 = o;
+		}
+	}
+	return chunks;
+}
+
+class Pool {
+	constructor(script, module, threads) {
+		this.script = script, this.module = module;
+		this.arrays = {}; /* Shared copies of inputs not already shared */
+		this.queue = Promise.resolve();
+		this.batch = null; /* Callbacks of the batch being solved */
+		this.broken = null; /* Set if a worker cannot be started */
+		this.closed = false;
+		this.workers = [];
+		for (let i = 0; i < threads; i++) {
+			this.workers.push(this._spawn(i));
+		}
+	}
+
+	/**
+	 * Starts the worker with the given index. w.ready is a promise that
+	 * resolves once the worker has instantiated the module. A worker that
+	 * exits after that is replaced; one that fails to start marks the pool as
+	 * broken.
+	 */
+	_spawn(i) {
+		const w = new wt.Worker(__filename, {
+			workerData: {script: this.script, module: this.module}});
+		w.ready = new Promise((resolve, reject) => {
+			w.once('message', (msg) => (msg === null) ? resolve() : reject(msg));
+			w.once('exit', () => reject('Worker exited'));
+		});
+		w.ready.then(() => {
+			w.started = true;
+			w.on('message', (msg) => this.batch && this.batch.done(w, msg));
+		}, (e) => {
+			this.broken = this.broken || e;
+		});
+		w.on('error', (e) => {
+			w.error = String(e);
+		});
+		w.on('exit', () => {
+			if (this.batch) {
+				this.batch.lost(w, w.error || 'Worker exited');
+			}
+			if (!this.closed && w.started && this.workers[i] === w) {
+				this.workers[i] = this._spawn(i);
+			}
+		});
+		return w;
+	}
+
+	/**
+	 * Solves m = n.length problems on the worker threads. The arguments and
+	 * the returned Float64Array of (x1, y1, x2, y2, status) records are as for
+	 * linprog2d.solve_batch(). Arrays backed by a SharedArrayBuffer are used
+	 * in place, others are copied once. Concurrent calls are processed one
+	 * after another.
+	 */
+	solveBatch(c, n, Gx, Gy, h) {
+		const res = this.queue.then(() => this._solve(c, n, Gx, Gy, h));
+		this.queue = res.catch(() => null);
+		return res;
+	}
+
+	_solve(c, n, Gx, Gy, h) {
+		const m = n.length, total = Gx.length;
+		if ((c.length != 2 * m) || (Gy.length != total) || (h.length != total)) {
+			return Promise.reject('Invalid input');
+		}
+
+		/* The workers would read past the constraint arrays otherwise */
+		let sum = 0;
+		for (let i = 0; i < m; i++) {
+			sum += n[i];
+		}
+		if (!(sum <= total)) {
+			return Promise.reject('Invalid input');
+		}
+		if (this.broken) {
+			return Promise.reject(this.broken);
+		}
+
+		/* Wait for workers that are being replaced */
+		return Promise.all(this.workers.map(w => w.ready)).then(
+			() => this._dispatch(c, n, Gx, Gy, h));
+	}
+
+	_dispatch(c, n, Gx, Gy, h) {
+		const m = n.length, total = Gx.length;
+		const own = this.arrays;
+		const out = shared(Float64Array, null, 5 * m);
+		const buffers = {
+			'c': as_shared(Float64Array, c, own, 'c').buffer,
+			'n': as_shared(Uint32Array, n, own, 'n').buffer,
+			'Gx': as_shared(Float64Array, Gx, own, 'Gx').buffer,
+			'Gy': as_shared(Float64Array, Gy, own, 'Gy').buffer,
+			'h': as_shared(Float64Array, h, own, 'h').buffer,
+			'out': out.buffer
+		};
+		const target = Math.ceil(total / (CHUNKS_PER_WORKER * this.workers.length));
+		const chunks = split(n, m, Math.max(target, 1));
+
+		/* Hand out the next chunk whenever a worker has finished one. After an
+		   error, no more chunks are handed out; the batch is rejected once the
+		   chunks in flight are done, so that their results do not end up in
+		   the next batch. */
+		return new Promise((resolve, reject) => {
+			let next = 0, active = 0, error = null;
+			const dispatch = (w) => {
+				if (!error && next < chunks.length) {
+					const [i0, i1, o0, o1] = chunks[next++];
+					active++, w.busy = true;
+					w.postMessage({i0, i1, o0, o1, buffers});
+				}
+			};
+			const finish = () => {
+				if (active == 0 && (error || next == chunks.length)) {
+					this.batch = null;
+					if (error) {
+						reject(error);
+					} else {
+						resolve(out.subarray(0, 5 * m));
+					}
+				}
+			};
+			this.batch = {
+				'done': (w, msg) => {
+					active--, w.busy = false;
+					error = error || msg;
+					dispatch(w);
+					finish();
+				},
+				'lost': (w, e) => {
+					if (w.busy) {
+						active--, w.busy = false;
+					}
+					error = error || e;
+					finish();
+				}
+			};
+			for (const w of this.workers) {
+				dispatch(w);
+			}
+			finish();
+		});
+	}
+
+	/**
+	 * Terminates the worker threads.
+	 */
+	close() {
+		this.closed = true;
+		return Promise.all(this.workers.map(w => w.terminate()));
+	}
+}
+
+/**
+ * Starts a pool of worker threads. Options are
+ * {
+ *     'threads': <number of workers, defaults to the number of CPUs>,
+ *     'script': <path of the linprog2d wrapper script, defaults to
+ *                build/linprog2d.sidecar.js>,
+ *     'source': <module source passed to linprog2d.compile()>
+ * }
+ * Returns a promise for the pool once all workers are ready.
+ */
+function create(options) {
+	options = options || {};
+	const threads = options.threads || os.cpus().length;
+	const script = path.resolve(options.script || DEFAULT_SCRIPT);
+	return require(script).linprog2d.compile(options.source).then(module => {
+		const pool = new Pool(script, module, threads);
+		return Promise.all(pool.workers.map(w => w.ready)).then(() => pool, e => {
+			pool.close();
+			throw e;
+		});
+	});
+}
+
+if (!wt.isMainThread && wt.workerData && wt.workerData.script) {
+	worker_main();
+}
+
+module.exports = {create};
@@ -0,0 +1,229 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file tools/linprog2d_scan.c
+ *
+ * Thread pool behind the parallel violator scan. Each scan bumps a generation
+ * counter under a mutex and wakes the workers; each worker scans its chunk
+ * with linprog2d_violators_find() into a buffer of its own and the last one
+ * to finish wakes the calling thread, which then merges the buffers.
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "linprog2d_scan.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+struct chunk {
+	unsigned int *idx, size, k;
+};
+
+struct linprog2d_scan {
+	pthread_mutex_t mutex;
+	pthread_cond_t start, done;
+	unsigned long int gen;
+	unsigned int n_pending, n_active;
+	int stop;
+
+	/* Scan currently running and its split into chunks */
+	const linprog2d_violator_scan_t *scan;
+	unsigned int chunk_size;
+
+	unsigned int n_threads, n_started, min_chunk;
+	struct chunk *chunks;
+	pthread_t *threads;
+};
+
+struct worker {
+	linprog2d_scan_t *s;
+	unsigned int t;
+};
+
+/******************************************************************************
+ * Workers                                                                    *
+ ******************************************************************************/
+
+static void scan_chunk(linprog2d_scan_t *s, unsigned int t) {
+	const linprog2d_violator_scan_t *scan = s->scan;
+	unsigned int i0 = t * s->chunk_size, i1 = i0 + s->chunk_size;
+	i1 = (i1 < scan->n && t + 1U < s->n_active) ? i1 : scan->n;
+	s->chunks[t].k = linprog2d_violators_find(scan, i0, i1, s->chunks[t].idx);
+}
+
+static void *worker_main(void *arg) {
+	linprog2d_scan_t *s = ((struct worker *)arg)->s;
+	const unsigned int t = ((struct worker *)arg)->t;
+	unsigned long int gen = 0UL;
+	free(arg);
+
+	pthread_mutex_lock(&s->mutex);
+	while (1) {
+		while (!s->stop && s->gen == gen) {
+			pthread_cond_wait(&s->start, &s->mutex);
+		}
+		if (s->stop) {
+			break;
+		}
+		gen = s->gen;
+		if (t >= s->n_active) {
+			continue;
+		}
+		pthread_mutex_unlock(&s->mutex);
+
+		scan_chunk(s, t);
+
+		pthread_mutex_lock(&s->mutex);
+		if (--s->n_pending == 0U) {
+			pthread_cond_signal(&s->done);
+		}
+	}
+	pthread_mutex_unlock(&s->mutex);
+	return NULL;
+}
+
+/******************************************************************************
+ * External API                                                               *
+ ******************************************************************************/
+
+linprog2d_scan_t *linprog2d_scan_create(unsigned int n_threads,
+                                        unsigned int min_chunk) {
+	linprog2d_scan_t *s;
+	struct worker *w;
+	if (n_threads == 0U ||
+	    !(s = (linprog2d_scan_t *)calloc(1U, sizeof(linprog2d_scan_t)))) {
+		return NULL;
+	}
+	s->chunks = (struct chunk *)calloc(n_threads, sizeof(struct chunk));
+	s->threads = (pthread_t *)calloc(n_threads, sizeof(pthread_t));
+	if (!s->chunks || !s->threads ||
+	    pthread_mutex_init(&s->mutex, NULL) != 0) {
+		free(s->chunks);
+		free(s->threads);
+		free(s);
+		return NULL;
+	}
+	if (pthread_cond_init(&s->start, NULL) != 0) {
+		pthread_mutex_destroy(&s->mutex);
+		free(s->chunks);
+		free(s->threads);
+		free(s);
+		return NULL;
+	}
+	if (pthread_cond_init(&s->done, NULL) != 0) {
+		pthread_cond_destroy(&s->start);
+		pthread_mutex_destroy(&s->mutex);
+		free(s->chunks);
+		free(s->threads);
+		free(s);
+		return NULL;
+	}
+	s->n_threads = n_threads;
+	s->min_chunk = (min_chunk > 0U) ? min_chunk : 1U;
+
+	/* The calling thread scans the first chunk */
+	for (s->n_started = 1U; s->n_started < n_threads; s->n_started++) {
+		if (!(w = (struct worker *)malloc(sizeof(struct worker)))) {
+			linprog2d_scan_free(s);
+			return NULL;
+		}
+		w->s = s, w->t = s->n_started;
+		if (pthread_create(&s->threads[s->n_started], NULL, worker_main, w) !=
+		    0) {
+			free(w);
+			linprog2d_scan_free(s);
+			return NULL;
+		}
+	}
+	return s;
+}
+
+void linprog2d_scan_free(linprog2d_scan_t *s) {
+	unsigned int i;
+	if (!s) {
+		return;
+	}
+	pthread_mutex_lock(&s->mutex);
+	s->stop = 1;
+	pthread_cond_broadcast(&s->start);
+	pthread_mutex_unlock(&s->mutex);
+	for (i = 1U; i < s->n_started; i++) {
+		pthread_join(s->threads[i], NULL);
+	}
+	pthread_cond_destroy(&s->done);
+	pthread_cond_destroy(&s->start);
+	pthread_mutex_destroy(&s->mutex);
+	for (i = 0U; i < s->n_threads; i++) {
+		free(s->chunks[i].idx);
+	}
+	free(s->chunks);
+	free(s->threads);
+	free(s);
+}
+
+unsigned int linprog2d_scan(void *data, const linprog2d_violator_scan_t *scan,
+                            unsigned int *idx) {
+	linprog2d_scan_t *s = (linprog2d_scan_t *)data;
+	unsigned int t, i, k, n_active = scan->n / s->min_chunk;
+	n_active = (n_active < s->n_threads) ? n_active : s->n_threads;
+	if (n_active < 2U) {
+		return linprog2d_violators_find(scan, 0U, scan->n, idx);
+	}
+
+	/* Each chunk holds at most max_k + 1 violators. The workers are idle, so
+	   their buffers can be grown here. The first chunk is written to idx. */
+	for (t = 1U; t < n_active; t++) {
+		if (s->chunks[t].size < scan->max_k + 1U) {
+			free(s->chunks[t].idx);
+			s->chunks[t].idx = (unsigned int *)malloc(
+			    sizeof(unsigned int) * (scan->max_k + 1U));
+			s->chunks[t].size = s->chunks[t].idx ? scan->max_k + 1U : 0U;
+			if (!s->chunks[t].idx) {
+				return linprog2d_violators_find(scan, 0U, scan->n, idx);
+			}
+		}
+	}
+
+	pthread_mutex_lock(&s->mutex);
+	s->scan = scan;
+	s->n_active = n_active;
+	s->chunk_size = scan->n / n_active;
+	s->n_pending = n_active - 1U;
+	s->gen++;
+	pthread_cond_broadcast(&s->start);
+	pthread_mutex_unlock(&s->mutex);
+
+	k = linprog2d_violators_find(scan, 0U, s->chunk_size, idx);
+
+	pthread_mutex_lock(&s->mutex);
+	while (s->n_pending > 0U) {
+		pthread_cond_wait(&s->done, &s->mutex);
+	}
+	pthread_mutex_unlock(&s->mutex);
+
+	/* Concatenate in chunk order, keeping the first max_k + 1 violators */
+	for (t = 1U; t < n_active && k <= scan->max_k; t++) {
+		for (i = 0U; i < s->chunks[t].k && k <= scan->max_k; i++) {
+			idx[k++] = s->chunks[t].idx[i];
+		}
+	}
+	return k;
+}
@@ -0,0 +1,78 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file tools/linprog2d_scan.h
+ *
+ * Parallel violator scan for linprog2d_sampling_solve(). The constraints are
+ * split into one contiguous chunk per thread; the calling thread scans the
+ * first chunk while the workers scan the others. The per-chunk results are
+ * concatenated in order, so the sampling solver sees exactly the violators
+ * the sequential scan would have found.
+ *
+ * Usage:
+ *
+ *     linprog2d_scan_t *scan = linprog2d_scan_create(4U, 4096U);
+ *     linprog2d_sampling_set_scanner(smp, linprog2d_scan, scan);
+ *     ...
+ *     linprog2d_scan_free(scan);
+ *
+ * @author Andreas Stöckel
+ */
+
+#ifndef LINPROG_2D_SCAN_H_
+#define LINPROG_2D_SCAN_H_
+
+#include <linprog2d.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Opaque type representing the scan threads.
+ */
+typedef struct linprog2d_scan linprog2d_scan_t;
+
+/**
+ * Starts n_threads - 1 worker threads. Scans over fewer than min_chunk
+ * constraints per thread use fewer threads; scans over fewer than
+ * 2 * min_chunk constraints run on the calling thread only. Returns null on
+ * failure.
+ */
+linprog2d_scan_t *linprog2d_scan_create(unsigned int n_threads,
+                                        unsigned int min_chunk);
+
+/**
+ * Stops the worker threads and frees the pool. Must not be called while a
+ * scan is running.
+ */
+void linprog2d_scan_free(linprog2d_scan_t *scan);
+
+/**
+ * Scanner callback for linprog2d_sampling_set_scanner(); data must point at a
+ * linprog2d_scan_t. Only one scan may run on a pool at a time, so each
+ * sampling solver that is used concurrently needs its own pool.
+ */
+unsigned int linprog2d_scan(void *data, const linprog2d_violator_scan_t *scan,
+                            unsigned int *idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINPROG_2D_SCAN_H_ */
@@ -0,0 +1,168 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file tools/linprog2d_shared_cache.c
+ *
+ * Sharded wrapper around linprog2d_cache. The shard of a problem only depends
+ * on a constant number of its values, so picking the shard does not add a
+ * second full pass over the input to the hash computed by the cache itself.
+ *
+ * @author Andreas Stöckel
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "linprog2d_shared_cache.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Number of constraints sampled when picking the shard */
+#define N_SAMPLES 8U
+
+/* Keeps the mutexes of different shards in separate cache lines */
+#define CACHE_LINE 64U
+
+struct shard {
+	pthread_mutex_t mutex;
+	linprog2d_cache_t *cache;
+	char pad[CACHE_LINE];
+};
+
+struct linprog2d_shared_cache {
+	struct shard *shards;
+	unsigned int n_shards, n_init;
+};
+
+/******************************************************************************
+ * Shard selection                                                            *
+ ******************************************************************************/
+
+/**
+ * Folds the bit pattern of the double x into the 32-bit hash value a.
+ */
+static unsigned long int shard_hash_step(unsigned long int a, double x) {
+	union {
+		double d;
+		unsigned int u[sizeof(double) / sizeof(unsigned int)];
+	} v;
+	unsigned int i;
+	v.d = x + 0.0; /* Map -0.0 to 0.0 */
+	for (i = 0U; i < sizeof(double) / sizeof(unsigned int); i++) {
+		a = ((a ^ v.u[i]) * 16777619UL) & 0xFFFFFFFFUL;
+	}
+	return a;
+}
+
+/**
+ * Hashes the gradient, the number of constraints, and up to N_SAMPLES evenly
+ * spaced constraints.
+ */
+static unsigned int shard_index(const linprog2d_shared_cache_t *c, double cx,
+                                double cy, const double *Gx, const double *Gy,
+                                const double *h, unsigned int n) {
+	unsigned long int a = shard_hash_step(2166136261UL ^ n, cx), i;
+	unsigned int k;
+	a = shard_hash_step(a, cy);
+	for (k = 0U; k < N_SAMPLES && k < n; k++) {
+		i = (unsigned long int)k * n / ((n < N_SAMPLES) ? n : N_SAMPLES);
+		a = shard_hash_step(a, Gx[i]);
+		a = shard_hash_step(a, Gy[i]);
+		a = shard_hash_step(a, h[i]);
+	}
+	return (unsigned int)((a ^ (a >> 16)) % c->n_shards);
+}
+
+/******************************************************************************
+ * External API                                                               *
+ ******************************************************************************/
+
+linprog2d_shared_cache_t *linprog2d_shared_cache_create(unsigned int n_shards,
+                                                        unsigned int entries,
+                                                        unsigned int capacity) {
+	linprog2d_shared_cache_t *c;
+	struct shard *s;
+	if (n_shards == 0U || !(c = (linprog2d_shared_cache_t *)calloc(
+	                            1U, sizeof(linprog2d_shared_cache_t)))) {
+		return NULL;
+	}
+	if (!(c->shards = (struct shard *)calloc(n_shards, sizeof(struct shard)))) {
+		free(c);
+		return NULL;
+	}
+	c->n_shards = n_shards;
+	for (; c->n_init < n_shards; c->n_init++) {
+		s = &c->shards[c->n_init];
+		if (!(s->cache = linprog2d_cache_create(entries, capacity))) {
+			linprog2d_shared_cache_free(c);
+			return NULL;
+		}
+		if (pthread_mutex_init(&s->mutex, NULL) != 0) {
+			linprog2d_cache_free(s->cache);
+			linprog2d_shared_cache_free(c);
+			return NULL;
+		}
+	}
+	return c;
+}
+
+void linprog2d_shared_cache_free(linprog2d_shared_cache_t *c) {
+	unsigned int i;
+	if (!c) {
+		return;
+	}
+	for (i = 0U; i < c->n_init; i++) {
+		pthread_mutex_destroy(&c->shards[i].mutex);
+		linprog2d_cache_free(c->shards[i].cache);
+	}
+	free(c->shards);
+	free(c);
+}
+
+linprog2d_result_t linprog2d_shared_cache_solve(
+    linprog2d_shared_cache_t *c, double cx, double cy, const double *Gx,
+    const double *Gy, const double *h, unsigned int n) {
+	struct shard *s = &c->shards[shard_index(c, cx, cy, Gx, Gy, h, n)];
+	linprog2d_result_t res;
+	pthread_mutex_lock(&s->mutex);
+	res = linprog2d_cache_solve(s->cache, cx, cy, Gx, Gy, h, n);
+	pthread_mutex_unlock(&s->mutex);
+	return res;
+}
+
+unsigned long int linprog2d_shared_cache_hits(linprog2d_shared_cache_t *c) {
+	unsigned long int res = 0UL;
+	unsigned int i;
+	for (i = 0U; i < c->n_shards; i++) {
+		pthread_mutex_lock(&c->shards[i].mutex);
+		res += linprog2d_cache_hits(c->shards[i].cache);
+		pthread_mutex_unlock(&c->shards[i].mutex);
+	}
+	return res;
+}
+
+unsigned long int linprog2d_shared_cache_misses(linprog2d_shared_cache_t *c) {
+	unsigned long int res = 0UL;
+	unsigned int i;
+	for (i = 0U; i < c->n_shards; i++) {
+		pthread_mutex_lock(&c->shards[i].mutex);
+		res += linprog2d_cache_misses(c->shards[i].cache);
+		pthread_mutex_unlock(&c->shards[i].mutex);
+	}
+	return res;
+}
@@ -0,0 +1,86 @@
+/*
+ *  linprog2d --- Two-dimensional linear programming solver
+ *  Copyright (C) 2018 Andreas Stöckel
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file tools/linprog2d_shared_cache.h
+ *
+ * Result cache that can be shared between threads. The cache is split into
+ * shards, each consisting of a linprog2d_cache instance guarded by its own
+ * mutex. A problem is assigned to a shard by a hash of the gradient and a
+ * fixed number of sampled constraints, so identical problems always meet in
+ * the same shard while unrelated problems rarely contend for the same lock.
+ *
+ * A miss is solved while the shard is locked; other threads looking up
+ * problems in the same shard wait for it. Use a few times more shards than
+ * threads to keep such waits rare.
+ *
+ * @author Andreas Stöckel
+ */
+
+#ifndef LINPROG_2D_SHARED_CACHE_H_
+#define LINPROG_2D_SHARED_CACHE_H_
+
+#include <linprog2d.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Opaque type representing the shared cache.
+ */
+typedef struct linprog2d_shared_cache linprog2d_shared_cache_t;
+
+/**
+ * Creates a cache with n_shards shards, each holding at most entries problems
+ * with at most capacity constraints. Returns null on failure.
+ */
+linprog2d_shared_cache_t *linprog2d_shared_cache_create(unsigned int n_shards,
+                                                        unsigned int entries,
+                                                        unsigned int capacity);
+
+/**
+ * Frees the cache. Must not be called while other threads use it.
+ */
+void linprog2d_shared_cache_free(linprog2d_shared_cache_t *cache);
+
+/**
+ * Same as linprog2d_cache_solve(). May be called from any thread.
+ */
+linprog2d_result_t linprog2d_shared_cache_solve(
+    linprog2d_shared_cache_t *cache, double cx, double cy, const double *Gx,
+    const double *Gy, const double *h, unsigned int n);
+
+/**
+ * Returns the number of calls to linprog2d_shared_cache_solve() that were
+ * answered from the cache, summed over all shards.
+ */
+unsigned long int linprog2d_shared_cache_hits(
+    linprog2d_shared_cache_t *cache);
+
+/**
+ * Returns the number of calls to linprog2d_shared_cache_solve() that had to
+ * solve the problem, summed over all shards.
+ */
+unsigned long int linprog2d_shared_cache_misses(
+    linprog2d_shared_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINPROG_2D_SHARED_CACHE_H_ */